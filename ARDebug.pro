@@ -21,6 +21,8 @@ SOURCES += Application/Core/main.cpp\
     Application/Core/util.cpp \
     Application/Core/settings.cpp \
     Application/Core/log.cpp \
+    Application/Core/latencymonitor.cpp \
+    Application/Core/benchmarkstats.cpp \
     Application/DataModel/datamodel.cpp \
     Application/DataModel/robotdata.cpp \
     Application/Networking/Wifi/datathread.cpp \
@@ -31,16 +33,51 @@ SOURCES += Application/Core/main.cpp\
     Application/Visualiser/visualiser.cpp \
     Application/Visualiser/visconfig.cpp \
     Application/Visualiser/visposition.cpp \
+    Application/Visualiser/vistrail.cpp \
+    Application/DataModel/posehistory.cpp \
+    Application/DataModel/occupancygrid.cpp \
+    Application/DataModel/spatialindex.cpp \
+    Application/DataModel/spatialindexbenchmark.cpp \
+    Application/DataModel/chartbenchmark.cpp \
+    Application/DataModel/disjointset.cpp \
+    Application/DataModel/swarmmetrics.cpp \
+    Application/DataModel/eventlog.cpp \
+    Application/DataModel/eventdetector.cpp \
+    Application/DataModel/commgraph.cpp \
+    Application/DataModel/slidingrange.cpp \
+    Application/DataModel/valuehistory.cpp \
+    Application/DataModel/quantilesketch.cpp \
+    Application/DataModel/fleethistogram.cpp \
+    Application/Visualiser/visoccupancy.cpp \
+    Application/Visualiser/visevents.cpp \
+    Application/Visualiser/viscommgraph.cpp \
+    Application/Visualiser/videocompositor.cpp \
+    Application/Visualiser/glvisualiser.cpp \
+    Application/Visualiser/visualiserbenchmark.cpp \
     Application/Tracking/aruco.cpp \
     Application/Tracking/usbcamerathread.cpp \
     Application/Visualiser/vistext.cpp \
     Application/UI/bluetoothconfigdialog.cpp \
-    Application/Tracking/cvbcamerathread.cpp
+    Application/UI/chartmodel.cpp \
+    Application/Tracking/cvbcamerathread.cpp \
+    Application/Tracking/motiongate.cpp \
+    Application/Tracking/syntheticscene.cpp \
+    Application/Tracking/syntheticcamerathread.cpp \
+    Application/Tracking/videofilecamerathread.cpp \
+    Application/Tracking/cameracalibration.cpp \
+    Application/Tracking/posefilter.cpp \
+    Application/Tracking/markertable.cpp \
+    Application/Tracking/dictionarybenchmark.cpp \
+    Application/Tracking/trackingbenchmark.cpp \
+    Application/Tracking/detectionmerger.cpp \
+    Application/Tracking/camerarig.cpp
 
 HEADERS  += Application/Core/mainwindow.h \
     Application/Core/util.h \
     Application/Core/settings.h \
     Application/Core/log.h \
+    Application/Core/latencymonitor.h \
+    Application/Core/benchmarkstats.h \
     Application/DataModel/datamodel.h \
     Application/DataModel/robotdata.h \
     Application/Networking/Wifi/datathread.h \
@@ -52,14 +89,47 @@ HEADERS  += Application/Core/mainwindow.h \
     Application/Visualiser/visconfig.h \
     Application/Visualiser/viselement.h \
     Application/Visualiser/visposition.h \
+    Application/Visualiser/vistrail.h \
+    Application/DataModel/posehistory.h \
+    Application/DataModel/occupancygrid.h \
+    Application/DataModel/spatialindex.h \
+    Application/DataModel/spatialindexbenchmark.h \
+    Application/DataModel/chartbenchmark.h \
+    Application/DataModel/disjointset.h \
+    Application/DataModel/swarmmetrics.h \
+    Application/DataModel/eventlog.h \
+    Application/DataModel/eventdetector.h \
+    Application/DataModel/commgraph.h \
+    Application/DataModel/slidingrange.h \
+    Application/DataModel/valuehistory.h \
+    Application/DataModel/quantilesketch.h \
+    Application/DataModel/fleethistogram.h \
+    Application/Visualiser/visoccupancy.h \
+    Application/Visualiser/visevents.h \
+    Application/Visualiser/viscommgraph.h \
+    Application/Visualiser/videocompositor.h \
+    Application/Visualiser/glvisualiser.h \
+    Application/Visualiser/visualiserbenchmark.h \
     Application/Tracking/aruco.h \
     Application/Tracking/usbcamerathread.h \
     Application/Visualiser/vistext.h \
     Application/UI/bluetoothconfigdialog.h \
+    Application/UI/chartmodel.h \
     Application/Tracking/cvbcamerathread.h \
     Application/Tracking/camerathread.h \
     Application/Core/defer.h \
-    Application/Core/logging.h
+    Application/Core/logging.h \
+    Application/Tracking/motiongate.h \
+    Application/Tracking/syntheticscene.h \
+    Application/Tracking/syntheticcamerathread.h \
+    Application/Tracking/videofilecamerathread.h \
+    Application/Tracking/cameracalibration.h \
+    Application/Tracking/posefilter.h \
+    Application/Tracking/markertable.h \
+    Application/Tracking/dictionarybenchmark.h \
+    Application/Tracking/trackingbenchmark.h \
+    Application/Tracking/detectionmerger.h \
+    Application/Tracking/camerarig.h
 
 FORMS += Application/UI/mainwindow.ui
 
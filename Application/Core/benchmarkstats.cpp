@@ -0,0 +1,50 @@
+/* benchmarkstats.cpp
+ *
+ * Summaries of benchmark measurements shared by every benchmark.
+ */
+
+#include "benchmarkstats.h"
+
+#include <algorithm>
+#include <cstdio>
+
+/* getBenchmarkStats
+ * Sort the values and return their mean, 95th percentile and largest, or
+ * zeros if there are none.
+ */
+BenchmarkStats getBenchmarkStats(std::vector<double>& values) {
+    BenchmarkStats stats;
+    if (values.empty()) {
+        return stats;
+    }
+
+    std::sort(values.begin(), values.end());
+
+    for (double value : values) {
+        stats.mean += value;
+    }
+
+    stats.mean /= values.size();
+    stats.p95 = percentile(values, 0.95);
+    stats.max = values.back();
+    return stats;
+}
+
+/* percentile
+ * Returns the value below which the given fraction of the sorted values lie.
+ */
+double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+
+    return sorted[std::min(sorted.size() - 1, (size_t)(fraction * sorted.size()))];
+}
+
+/* printFrameTimes
+ * Print a row of the mean and 95th percentile frame times in milliseconds,
+ * and the frame rate of the mean.
+ */
+void printFrameTimes(const char* name, const BenchmarkStats& stats) {
+    printf("%-12s %10.2f %10.2f %10.1f\n", name, stats.mean, stats.p95, stats.mean > 0 ? 1000 / stats.mean : 0.0);
+}
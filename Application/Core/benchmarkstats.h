@@ -0,0 +1,19 @@
+#ifndef BENCHMARKSTATS_H
+#define BENCHMARKSTATS_H
+
+#include <vector>
+
+/* BenchmarkStats
+ * Summary of the measurements of a benchmark, such as frame times.
+ */
+typedef struct BenchmarkStats {
+    double mean = 0;
+    double p95 = 0;
+    double max = 0;
+} BenchmarkStats;
+
+BenchmarkStats getBenchmarkStats(std::vector<double>& values);
+double percentile(const std::vector<double>& sorted, double fraction);
+void printFrameTimes(const char* name, const BenchmarkStats& stats);
+
+#endif // BENCHMARKSTATS_H
@@ -0,0 +1,209 @@
+/* latencymonitor.cpp
+ *
+ * Collects the latency of each hop of the tracking path into histograms.
+ */
+
+#include "latencymonitor.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+
+// Width of a histogram bucket in nanoseconds
+static const qint64 BUCKET_WIDTH = 250000;
+
+// Number of buckets, the last one also counts everything above its range
+static const int BUCKET_COUNT = 2000;
+
+/* Constructor
+ * Start with empty histograms.
+ */
+LatencyMonitor::LatencyMonitor()
+{
+    for (int hop = 0; hop < LATENCY_HOP_COUNT; hop++) {
+        buckets[hop].resize(BUCKET_COUNT);
+    }
+
+    reset();
+}
+
+/* startClock
+ * Returns a started monotonic timer.
+ */
+static QElapsedTimer startClock(void)
+{
+    QElapsedTimer clock;
+    clock.start();
+    return clock;
+}
+
+/* now
+ * Returns the time in nanoseconds on a monotonic clock shared by all threads.
+ */
+qint64 LatencyMonitor::now(void)
+{
+    static const QElapsedTimer clock = startClock();
+    return clock.nsecsElapsed();
+}
+
+/* hopName
+ * Returns a short name for a hop.
+ */
+QString LatencyMonitor::hopName(LatencyHop hop)
+{
+    switch (hop) {
+    case LATENCY_DETECTION: return "capture to detected";
+    case LATENCY_MODEL_UPDATE: return "detected to model";
+    case LATENCY_PAINT: return "model to drawn";
+    case LATENCY_END_TO_END: return "capture to drawn";
+    default: return "";
+    }
+}
+
+/* record
+ * Add one latency measurement to the histogram of a hop.
+ */
+void LatencyMonitor::record(LatencyHop hop, qint64 nanoseconds)
+{
+    nanoseconds = std::max<qint64>(0, nanoseconds);
+    int bucket = std::min<qint64>(BUCKET_COUNT - 1, nanoseconds / BUCKET_WIDTH);
+
+    QMutexLocker lock{&mutex};
+    buckets[hop][bucket]++;
+    count[hop]++;
+    sum[hop] += nanoseconds;
+    last[hop] = nanoseconds;
+    max[hop] = std::max(max[hop], nanoseconds);
+}
+
+/* frameApplied
+ * Called when the poses of a frame have been written to the data model. The
+ * frame is measured again when it is next drawn.
+ */
+void LatencyMonitor::frameApplied(qint64 captureTick)
+{
+    QMutexLocker lock{&mutex};
+    pendingCaptureTick = captureTick;
+    pendingAppliedTick = now();
+}
+
+/* framePainted
+ * Called when the visualiser has finished drawing. Records how long the
+ * newest applied frame waited to be drawn, and its age from capture.
+ */
+void LatencyMonitor::framePainted(void)
+{
+    qint64 captureTick;
+    qint64 appliedTick;
+
+    {
+        QMutexLocker lock{&mutex};
+        captureTick = pendingCaptureTick;
+        appliedTick = pendingAppliedTick;
+        pendingCaptureTick = 0;
+        pendingAppliedTick = 0;
+    }
+
+    if (appliedTick == 0) {
+        return;
+    }
+
+    qint64 painted = now();
+    record(LATENCY_PAINT, painted - appliedTick);
+    record(LATENCY_END_TO_END, painted - captureTick);
+}
+
+/* percentile
+ * Returns the upper edge, in milliseconds, of the bucket holding the given
+ * fraction of the measurements of a hop. The mutex must be held.
+ */
+double LatencyMonitor::percentile(LatencyHop hop, double fraction)
+{
+    if (count[hop] == 0) {
+        return 0;
+    }
+
+    quint64 rank = std::max<quint64>(1, std::ceil(fraction * count[hop]));
+    quint64 seen = 0;
+
+    for (int bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+        seen += buckets[hop][bucket];
+        if (seen >= rank) {
+            return std::min(max[hop], (bucket + 1) * BUCKET_WIDTH) / 1e6;
+        }
+    }
+
+    return max[hop] / 1e6;
+}
+
+/* getSummary
+ * Returns the statistics of a hop in milliseconds.
+ */
+LatencySummary LatencyMonitor::getSummary(LatencyHop hop)
+{
+    QMutexLocker lock{&mutex};
+
+    LatencySummary summary;
+    summary.count = count[hop];
+    summary.last = last[hop] / 1e6;
+    summary.mean = count[hop] > 0 ? (sum[hop] / 1e6) / count[hop] : 0;
+    summary.p50 = percentile(hop, 0.5);
+    summary.p95 = percentile(hop, 0.95);
+    summary.p99 = percentile(hop, 0.99);
+    summary.max = max[hop] / 1e6;
+    return summary;
+}
+
+/* reset
+ * Clear every histogram.
+ */
+void LatencyMonitor::reset(void)
+{
+    QMutexLocker lock{&mutex};
+
+    for (int hop = 0; hop < LATENCY_HOP_COUNT; hop++) {
+        std::fill(buckets[hop].begin(), buckets[hop].end(), 0);
+        count[hop] = 0;
+        sum[hop] = 0;
+        last[hop] = 0;
+        max[hop] = 0;
+    }
+
+    pendingCaptureTick = 0;
+    pendingAppliedTick = 0;
+}
+
+/* exportCsv
+ * Write every non-empty histogram bucket to a CSV file, one row per hop and
+ * bucket. Returns false if the file could not be written.
+ */
+bool LatencyMonitor::exportCsv(QString file)
+{
+    QFile output{file};
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        return false;
+    }
+
+    QTextStream stream{&output};
+    stream << "hop,lower_ms,upper_ms,count\n";
+
+    QMutexLocker lock{&mutex};
+
+    for (int hop = 0; hop < LATENCY_HOP_COUNT; hop++) {
+        for (int bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+            if (buckets[hop][bucket] == 0) {
+                continue;
+            }
+
+            double lower = bucket * BUCKET_WIDTH / 1e6;
+            double upper = bucket == BUCKET_COUNT - 1 ? max[hop] / 1e6 : (bucket + 1) * BUCKET_WIDTH / 1e6;
+
+            stream << hopName((LatencyHop)hop) << "," << lower << "," << upper << "," << buckets[hop][bucket] << "\n";
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,71 @@
+#ifndef LATENCYMONITOR_H
+#define LATENCYMONITOR_H
+
+#include <QString>
+#include <QMutex>
+
+#include <vector>
+
+typedef enum {
+    LATENCY_DETECTION,
+    LATENCY_MODEL_UPDATE,
+    LATENCY_PAINT,
+    LATENCY_END_TO_END,
+    LATENCY_HOP_COUNT
+} LatencyHop;
+
+// Statistics of one hop, in milliseconds
+typedef struct {
+    quint64 count;
+    double last;
+    double mean;
+    double p50;
+    double p95;
+    double p99;
+    double max;
+} LatencySummary;
+
+/* LatencyMonitor
+ * Histograms of the time a tracked pose spends in each part of the tracking
+ * path: from capture until detection is done, until the data model has been
+ * updated, and until the visualiser has drawn it. All times are measured on
+ * one monotonic clock, so they are comparable across threads.
+ */
+class LatencyMonitor
+{
+    LatencyMonitor();
+
+public:
+    static LatencyMonitor* instance() {
+        static LatencyMonitor instance;
+        return &instance;
+    }
+
+    static qint64 now(void);
+    static QString hopName(LatencyHop hop);
+
+    void record(LatencyHop hop, qint64 nanoseconds);
+    void frameApplied(qint64 captureTick);
+    void framePainted(void);
+
+    LatencySummary getSummary(LatencyHop hop);
+    void reset(void);
+    bool exportCsv(QString file);
+
+private:
+    double percentile(LatencyHop hop, double fraction);
+
+    QMutex mutex;
+
+    std::vector<quint64> buckets[LATENCY_HOP_COUNT];
+    quint64 count[LATENCY_HOP_COUNT];
+    qint64 sum[LATENCY_HOP_COUNT];
+    qint64 last[LATENCY_HOP_COUNT];
+    qint64 max[LATENCY_HOP_COUNT];
+
+    // Newest frame applied to the model that has not been drawn yet
+    qint64 pendingCaptureTick;
+    qint64 pendingAppliedTick;
+};
+
+#endif // LATENCYMONITOR_H
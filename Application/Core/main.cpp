@@ -7,15 +7,301 @@
 
 #include "mainwindow.h"
 #include <QApplication>
+#include <QCommandLineParser>
+
+#include <iostream>
 
 #include "settings.h"
 #include "log.h"
 
 #include "../Visualiser/viselement.h"
+#include "../Tracking/markertable.h"
+#include "../Tracking/dictionarybenchmark.h"
+#include "../Tracking/trackingbenchmark.h"
+#include "../Visualiser/visualiserbenchmark.h"
+#include "../DataModel/spatialindexbenchmark.h"
+#include "../DataModel/chartbenchmark.h"
 
 // Allocate and initialise the singleton pointers
 Settings *Settings::s_instance = 0;
 
+typedef struct {
+    QString name;
+    int frames;
+    int robots;
+} BenchmarkRequest;
+
+/* parseCommandLine
+ * Apply command line options to the settings. Returns the benchmark to run
+ * instead of the application, if one was requested.
+ */
+BenchmarkRequest parseCommandLine(QApplication& app) {
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Augmented reality debugging for robot swarms");
+    parser.addHelpOption();
+
+    QCommandLineOption synthetic("synthetic", "Read frames from a synthetic marker scene instead of a camera.");
+    QCommandLineOption markers("synthetic-markers", "Number of markers in the synthetic scene.", "count");
+    QCommandLineOption size("synthetic-size", "Resolution of the synthetic scene.", "WIDTHxHEIGHT");
+    QCommandLineOption fps("synthetic-fps", "Frame rate of the synthetic scene, 0 for as fast as possible.", "fps");
+    QCommandLineOption markerSize("synthetic-marker-size", "Side length of the synthetic markers in pixels.", "pixels");
+    QCommandLineOption speed("synthetic-speed", "Marker speed in frame widths per second.", "speed");
+    QCommandLineOption background("synthetic-background", "Grey level (0-255) or image file used as background.", "background");
+    QCommandLineOption noise("synthetic-noise", "Standard deviation of the added pixel noise.", "sigma");
+    QCommandLineOption blur("synthetic-blur", "Size of the Gaussian blur kernel, 0 for none.", "pixels");
+    QCommandLineOption seed("synthetic-seed", "Seed of the synthetic scene.", "seed");
+
+    QCommandLineOption video("video", "Read frames from a recorded video file instead of a camera.", "file");
+    QCommandLineOption videoFast("video-fast", "Play the video as fast as possible instead of at its recorded frame rate.");
+    QCommandLineOption videoLoop("video-loop", "Restart the video when it ends.");
+    QCommandLineOption videoStart("video-start", "Frame of the video to start playing from.", "frame");
+
+    QCommandLineOption calibration("calibration", "Camera calibration and arena homography file.", "file");
+    QCommandLineOption camera("camera", "Add a camera covering part of the arena, may be repeated. Type is usb, synthetic or video, "
+                                        "the argument is the device, seed or file, and calib the calibration file.", "type[:arg][@calib]");
+    QCommandLineOption grayscaleCapture("grayscale-capture", "Capture luma only and show the video in grey, implied by --no-video.");
+    QCommandLineOption noVideo("no-video", "Do not show the camera image behind the visualisation.");
+    QCommandLineOption latencyOverlay("latency-overlay", "Draw tracking latency statistics over the video.");
+    QCommandLineOption latencyCsv("latency-csv", "Write tracking latency histograms to a CSV file on exit.", "file");
+    QCommandLineOption dictionary("dictionary", "ArUco dictionary of the robot markers, e.g. DICT_4X4_1000.", "name");
+    QCommandLineOption benchmark("benchmark", "Run a benchmark and exit. Available: dictionaries, tracking, visualisers, sprites, spatial, comm, charts.", "name");
+    QCommandLineOption benchmarkFrames("benchmark-frames", "Number of frames each benchmark case runs for.", "count", "200");
+    QCommandLineOption benchmarkRobots("benchmark-robots", "Number of robots in the visualiser, sprite and comm benchmarks.", "count", "5000");
+    QCommandLineOption openGL("opengl", "Draw the visualisation with OpenGL instead of QPainter.");
+    QCommandLineOption trailLength("trail-length", "Seconds of movement shown behind each robot, 0 for none.", "seconds");
+    QCommandLineOption poseHistory("pose-history", "Seconds of position history kept for each robot.", "seconds");
+    QCommandLineOption valueHistory("value-history", "Seconds of numbers received from each robot kept for charting.", "seconds");
+    QCommandLineOption valueHistorySamples("value-history-samples", "Most numbers kept for charting over all robots together.", "count");
+    QCommandLineOption chartWindow("chart-window", "Seconds of robot values shown by the line chart.", "seconds");
+    QCommandLineOption occupancy("occupancy", "Show a map of where robots have spent their time.");
+    QCommandLineOption clusterDistance("cluster-distance", "Distance, as a proportion of the longer side of the arena, within which robots form a cluster.", "distance");
+    QCommandLineOption proximityDistance("proximity-distance", "Distance, as a proportion of the longer side of the arena, within which robots coming together is logged, 0 for none.", "distance");
+    QCommandLineOption commRadius("comm-radius", "Communication range of the robots, as a proportion of the longer side of the arena, 0 for no communication graph.", "distance");
+    QCommandLineOption detail("detail", "How robots are drawn: auto, glyphs, points or density.", "level", "auto");
+
+    parser.addOptions({synthetic, markers, size, fps, markerSize, speed, background, noise, blur, seed});
+    parser.addOptions({video, videoFast, videoLoop, videoStart});
+    parser.addOptions({calibration, camera, grayscaleCapture, noVideo, latencyOverlay, latencyCsv, openGL, detail});
+    parser.addOptions({trailLength, poseHistory, occupancy, clusterDistance, proximityDistance, commRadius});
+    parser.addOptions({valueHistory, valueHistorySamples, chartWindow});
+    parser.addOptions({dictionary, benchmark, benchmarkFrames, benchmarkRobots});
+    parser.process(app);
+
+    Settings* settings = Settings::instance();
+
+    if (parser.isSet(dictionary)) {
+        int value = markerDictionaryFromName(parser.value(dictionary));
+        if (value >= 0) {
+            settings->setMarkerDictionary(value);
+        } else {
+            std::cerr << "Unknown dictionary " << parser.value(dictionary).toStdString() << ", expected one of "
+                      << markerDictionaryNames().join(", ").toStdString() << std::endl;
+        }
+    }
+
+    SyntheticSceneConfig scene = settings->getSyntheticSceneConfig();
+    VideoFileConfig videoFile = settings->getVideoFileConfig();
+
+    if (parser.isSet(video)) {
+        settings->setCameraSource(CAMERA_SOURCE_VIDEO_FILE);
+        videoFile.file = parser.value(video);
+    }
+
+    videoFile.fast = parser.isSet(videoFast);
+    videoFile.loop = parser.isSet(videoLoop);
+
+    if (parser.isSet(videoStart)) {
+        videoFile.startFrame = parser.value(videoStart).toLongLong();
+    }
+
+    settings->setVideoFileConfig(videoFile);
+
+    if (parser.isSet(calibration)) {
+        settings->setCalibrationFile(parser.value(calibration));
+    }
+
+    if (parser.isSet(synthetic)) {
+        settings->setCameraSource(CAMERA_SOURCE_SYNTHETIC);
+    }
+
+    if (parser.isSet(markers)) {
+        scene.markerCount = parser.value(markers).toInt();
+    }
+
+    if (parser.isSet(size)) {
+        QStringList dimensions = parser.value(size).split('x');
+        if (dimensions.size() == 2 && dimensions[0].toInt() > 0 && dimensions[1].toInt() > 0) {
+            scene.width = dimensions[0].toInt();
+            scene.height = dimensions[1].toInt();
+        }
+    }
+
+    if (parser.isSet(fps)) {
+        scene.fps = parser.value(fps).toDouble();
+    }
+
+    if (parser.isSet(markerSize)) {
+        scene.markerSize = parser.value(markerSize).toInt();
+    }
+
+    if (parser.isSet(speed)) {
+        scene.speed = parser.value(speed).toDouble();
+    }
+
+    if (parser.isSet(background)) {
+        bool isLevel = false;
+        int level = parser.value(background).toInt(&isLevel);
+        if (isLevel) {
+            scene.backgroundLevel = level;
+        } else {
+            scene.backgroundFile = parser.value(background);
+        }
+    }
+
+    if (parser.isSet(noise)) {
+        scene.noiseSigma = parser.value(noise).toDouble();
+    }
+
+    if (parser.isSet(blur)) {
+        scene.blurKernel = parser.value(blur).toInt();
+    }
+
+    if (parser.isSet(seed)) {
+        scene.seed = parser.value(seed).toUInt();
+    }
+
+    // Without the video display nothing needs colour
+    settings->setGrayscaleCaptureEnabled(parser.isSet(grayscaleCapture) || parser.isSet(noVideo));
+    settings->setVideoEnabled(!parser.isSet(noVideo));
+    settings->setLatencyOverlayEnabled(parser.isSet(latencyOverlay));
+    settings->setLatencyExportFile(parser.value(latencyCsv));
+    settings->setOpenGLVisualiserEnabled(parser.isSet(openGL));
+
+    settings->setOccupancyOverlayEnabled(parser.isSet(occupancy));
+
+    if (parser.isSet(trailLength)) {
+        settings->setTrailLength(parser.value(trailLength).toDouble());
+    }
+
+    if (parser.isSet(poseHistory)) {
+        settings->setPoseHistoryDuration(parser.value(poseHistory).toDouble());
+    }
+
+    if (parser.isSet(valueHistory)) {
+        settings->setValueHistoryDuration(parser.value(valueHistory).toDouble());
+    }
+
+    if (parser.isSet(valueHistorySamples)) {
+        settings->setValueHistorySamples(parser.value(valueHistorySamples).toInt());
+    }
+
+    if (parser.isSet(chartWindow)) {
+        settings->setChartWindow(parser.value(chartWindow).toDouble());
+    }
+
+    if (parser.isSet(clusterDistance)) {
+        settings->setClusterDistance(parser.value(clusterDistance).toDouble());
+    }
+
+    if (parser.isSet(proximityDistance)) {
+        settings->setProximityDistance(parser.value(proximityDistance).toDouble());
+    }
+
+    if (parser.isSet(commRadius)) {
+        settings->setCommRadius(parser.value(commRadius).toDouble());
+    }
+
+    QString detailName = parser.value(detail);
+    if (detailName == "glyphs") {
+        settings->setVisualiserDetail(VISUALISER_DETAIL_GLYPHS);
+    } else if (detailName == "points") {
+        settings->setVisualiserDetail(VISUALISER_DETAIL_POINTS);
+    } else if (detailName == "density") {
+        settings->setVisualiserDetail(VISUALISER_DETAIL_DENSITY);
+    } else if (detailName != "auto") {
+        std::cerr << "Unknown detail level " << detailName.toStdString() << ", expected auto, glyphs, points or density" << std::endl;
+    }
+
+    std::vector<CameraConfig> cameras;
+    for (auto& spec : parser.values(camera)) {
+        CameraConfig config;
+        QString type = spec;
+
+        int at = type.lastIndexOf('@');
+        if (at >= 0) {
+            config.calibrationFile = type.mid(at + 1);
+            type = type.left(at);
+        }
+
+        int colon = type.indexOf(':');
+        if (colon >= 0) {
+            config.argument = type.mid(colon + 1);
+            type = type.left(colon);
+        }
+
+        if (type == "usb") {
+            config.source = CAMERA_SOURCE_USB;
+        } else if (type == "synthetic") {
+            config.source = CAMERA_SOURCE_SYNTHETIC;
+        } else if (type == "video") {
+            config.source = CAMERA_SOURCE_VIDEO_FILE;
+        } else {
+            std::cerr << "Unknown camera type " << type.toStdString() << ", expected usb, synthetic or video" << std::endl;
+            continue;
+        }
+
+        cameras.push_back(config);
+    }
+
+    settings->setCameras(cameras);
+
+    // Synthetic markers are drawn from the dictionary that is tracked
+    scene.dictionary = settings->getMarkerDictionary();
+    settings->setSyntheticSceneConfig(scene);
+
+    BenchmarkRequest request;
+    request.name = parser.value(benchmark);
+    request.frames = parser.value(benchmarkFrames).toInt();
+    request.robots = parser.value(benchmarkRobots).toInt();
+    return request;
+}
+
+/* runBenchmark
+ * Run the named benchmark. Returns the process exit code.
+ */
+int runBenchmark(const BenchmarkRequest& request) {
+    if (request.name == "dictionaries") {
+        return runDictionaryBenchmark(Settings::instance()->getSyntheticSceneConfig(), request.frames);
+    }
+
+    if (request.name == "tracking") {
+        return runTrackingBenchmark(Settings::instance()->getSyntheticSceneConfig(), request.frames);
+    }
+
+    if (request.name == "visualisers") {
+        return runVisualiserBenchmark(request.robots, request.frames);
+    }
+
+    if (request.name == "sprites") {
+        return runSpriteBenchmark(request.robots, request.frames);
+    }
+
+    if (request.name == "spatial") {
+        return runSpatialIndexBenchmark(request.frames);
+    }
+
+    if (request.name == "comm") {
+        return runCommGraphBenchmark(request.robots, request.frames);
+    }
+
+    if (request.name == "charts") {
+        return runChartBenchmark(request.frames);
+    }
+
+    std::cerr << "Unknown benchmark " << request.name.toStdString() << std::endl;
+    return 1;
+}
+
 /* main
  * Entry point for the whole application.
  */
@@ -23,6 +309,12 @@ int main(int argc, char *argv[])
 {
     // Show QT Application
     QApplication a(argc, argv);
+    BenchmarkRequest benchmark = parseCommandLine(a);
+
+    if (!benchmark.name.isEmpty()) {
+        return runBenchmark(benchmark);
+    }
+
     MainWindow w;
     w.show();
 
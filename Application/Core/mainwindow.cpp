@@ -12,6 +12,7 @@
 #include "defer.h"
 #include "log.h"
 #include "logging.h"
+#include "latencymonitor.h"
 #include "../Networking/Wifi/datathread.h"
 #include "../Networking/Bluetooth/bluetoothdatathread.h"
 
@@ -25,6 +26,7 @@
 
 #include <sys/socket.h>
 
+#include <QApplication>
 #include <QLayout>
 #include <QStandardItemModel>
 #include <QCheckBox>
@@ -33,6 +35,7 @@
 #include <QJsonArray>
 #include <QJsonObject>
 #include <sstream>
+#include <algorithm>
 #include <fstream>
 
 #include "../UI/chartdialog.h"
@@ -55,6 +58,9 @@ MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
 {
+    // One table entry per marker of the dictionary, so lookups never search
+    markerTable.resize(markerDictionarySize(Settings::instance()->getMarkerDictionary()));
+
     const auto robotConfigFilePath = "./RobotConfig.json";
     std::ifstream robotConfigFile{robotConfigFilePath};
 
@@ -101,7 +107,11 @@ MainWindow::MainWindow(QWidget *parent) :
                 int arucoId = obj["aruco_id"].toDouble();
                 QString robotId = obj["robot_id"].toString();
 
-                arucoNameMapping[arucoId] = robotId;
+                if(!markerTable.setRobot(arucoId, robotId))
+                {
+                    std::cout << "ArUco ID " << arucoId << " is not part of " << markerDictionaryName(Settings::instance()->getMarkerDictionary()).toStdString() << std::endl;
+                    continue;
+                }
 
                 std::cout << "ArUco ID " << arucoId << " is now mapped to Robot ID " << robotId.toStdString() << std::endl;
             }
@@ -109,20 +119,15 @@ MainWindow::MainWindow(QWidget *parent) :
     }
 
 
-#ifdef CVB_CAMERA_PRESENT
-    cameraThread = new CVBCameraThread;
-#else
-    cameraThread = new USBCameraThread;
-#endif
-
-    arucoTracker = new ArUco{&arucoNameMapping, cameraThread};
-
     ui->setupUi(this);
 
     // Show some console text
     Log::instance()->setup(ui->consoleText, nullptr);
     Log::instance()->logMessage("ARDebug started successfully\n", true);
 
+    // Every camera is tracked on its own thread, the rig merges their results
+    cameraRig = new CameraRig{&markerTable, Settings::instance()->getCameras()};
+
     // Set up the data model
     dataModel = new DataModel;
     ui->robotList->setModel(dataModel->getRobotList());
@@ -157,15 +162,31 @@ MainWindow::MainWindow(QWidget *parent) :
 
 
     // Intantiate the visualiser
-    visualiser = new Visualiser{dataModel, cameraThread};
+    // Camera frames are scaled and converted for display on their own thread,
+    // at the size of the tab until the visualiser is first resized
+    videoCompositor = new VideoCompositor{cameraRig, Settings::instance()->isVideoEnabled(), ui->visualiserTabWidget->size()};
+    videoCompositor->moveToThread(&compositorThread);
+    compositorThread.start();
+
+    // Both visualisers provide the same slots and signals
+    if(Settings::instance()->isOpenGLVisualiserEnabled())
+        visualiser = new GLVisualiser{dataModel, videoCompositor};
+    else
+        visualiser = new Visualiser{dataModel, videoCompositor};
+
     visualiser->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
 
     connect(dataModel, SIGNAL(modelChanged(bool, QString, std::vector<QString>)), visualiser, SLOT(refreshVisualisation()));
-    //connect(dataModel, SIGNAL(modelChanged(bool, QString, std::vector<QString>)), this, SLOT(updateChart(bool, QString, std::vector<QString>)));
     connect(ui->robotList->selectionModel(), SIGNAL(selectionChanged(QItemSelection,QItemSelection)), this, SLOT(resettingChart()));
 
+    // The chart only notes changes as they arrive and applies them on the timer
+    chart = new QtCharts::QChart();
+    chartModel = new ChartModel{dataModel, chart, this};
+    connect(dataModel, SIGNAL(modelChanged(bool, QString, std::vector<QString>)), chartModel, SLOT(dataChanged(bool, QString, std::vector<QString>)));
+
     QTimer* tmr = new QTimer{this};
-    connect(tmr, SIGNAL(timeout()), this, SLOT(redrawChart()));
+    connect(tmr, SIGNAL(timeout()), chartModel, SLOT(update()));
+    connect(tmr, SIGNAL(timeout()), this, SLOT(updateSwarmMetrics()));
     tmr->setInterval(100);
     tmr->start();
 
@@ -181,24 +202,19 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->customDataTable->horizontalHeader()->setStretchLastSection(true);
     ui->customDataTable->setEditTriggers(QTableWidget::NoEditTriggers);
 
-    //set up the chart view
-    chart = new QtCharts::QChart();
+    // Set up the swarm metrics table, one row per value
+    ui->swarmMetricsTable->setColumnCount(3);
+    ui->swarmMetricsTable->setHorizontalHeaderLabels(QStringList("Metric") << QString("Value") << QString{"Compute Time (us)"});
+    ui->swarmMetricsTable->horizontalHeader()->setStretchLastSection(true);
+    ui->swarmMetricsTable->verticalHeader()->hide();
+    ui->swarmMetricsTable->setEditTriggers(QTableWidget::NoEditTriggers);
 
+    //set up the chart view
     //chart->setTitle("robot data");
     chart->legend()->hide();
 
     QtCharts::QChartView *chartView = new QtCharts::QChartView(chart);
     chartView->setRenderHint(QPainter::Antialiasing);
-    colourmap[0].setRgb(230,25,75);//red
-    colourmap[1].setRgb(60,180,75);//green
-    colourmap[2].setRgb(255,225,25);//yellow
-    colourmap[3].setRgb(0,130,200);//blue
-    colourmap[4].setRgb(245,130,48);//orange
-    colourmap[5].setRgb(140,30,180);//purple
-    colourmap[6].setRgb(70,240,240);//cyan
-    colourmap[7].setRgb(240,30,230);//magenta
-    colourmap[8].setRgb(170,110,40);//brown
-    colourmap[9].setRgb(0,0,128);//navy
 
     // Arrange the rows vertically
     QVBoxLayout* mainbox = new QVBoxLayout();
@@ -213,11 +229,14 @@ MainWindow::MainWindow(QWidget *parent) :
     addIDMappingDialog = NULL;
 
     qRegisterMetaType<cv::Mat>("cv::Mat&");
+    qRegisterMetaType<FrameInfo>("FrameInfo");
+    qRegisterMetaType<std::vector<TrackResult>>("std::vector<TrackResult>");
+    qRegisterMetaType<FrameResult>("FrameResult");
 
-    connect(arucoTracker, SIGNAL(newRobotPosition(QString, Pose)), dataModel, SLOT(newRobotPosition(QString, Pose)));
+    connect(cameraRig, SIGNAL(newTrackingFrame(FrameResult)), dataModel, SLOT(newTrackingFrame(FrameResult)));
     connect(visualiser, SIGNAL(robotSelectedInVisualiser(QString)), this, SLOT(robotSelectedInVisualiser(QString)));
 
-    cameraThread->start();
+    cameraRig->start();
 
     // Start the camera reading immediately
     startReadingCamera();
@@ -246,14 +265,23 @@ MainWindow::~MainWindow()
     bluetoothThread.quit();
     bluetoothThread.wait();
 
-    // Stop the camera thread
-    cameraThread->quit();
-    cameraThread->wait();
+    // Stop the cameras and their tracking threads, then the compositor
+    cameraRig->stop();
+    compositorThread.quit();
+    compositorThread.wait();
+
+    // Keep the latency histograms for offline analysis
+    QString latencyFile = Settings::instance()->getLatencyExportFile();
+    if(!latencyFile.isEmpty() && !LatencyMonitor::instance()->exportCsv(latencyFile))
+        std::cerr << "Could not write latency histograms to " << latencyFile.toStdString() << std::endl;
 
     // Release all memory
     delete ui;
     delete dataModel;
     delete visualiser;
+    delete videoCompositor;
+    delete cameraRig;
+    delete chartModel;
     delete chart;
 
     // Delete the id mapping dialog if existing
@@ -507,7 +535,10 @@ void MainWindow::robotSelectedInVisualiser(QString id) {
  * Called when a robot is deleted to update the UI.
  */
 void MainWindow::robotDeleted(void) {
-    dataModelUpdate(true, dataModel->selectedRobotID, {});
+    // The deleted robot may have been the selected one
+    dataModelUpdate(true, QString{}, {});
+    updateCustomData();
+    chartModel->dataChanged(true, dataModel->selectedRobotID, {});
 }
 
 /* dataModelUpdate
@@ -533,7 +564,8 @@ void MainWindow::dataModelUpdate(bool listChanged, QString robotId, std::vector<
         }
     }
 
-    if (robotId!=dataModel->selectedRobotID)
+    // An empty id names no robot, even while none is selected
+    if (robotId.isEmpty() || robotId!=dataModel->selectedRobotID)
         return;
 
     // Update the necessary data tabs
@@ -665,223 +697,119 @@ void MainWindow::on_bluetoothConfigButton_clicked()
 
 
 
+/* on_customDataTable_itemDoubleClicked
+ * Chart the value that was double clicked. With Ctrl held, a number is
+ * added as another line to the numbers already charted. With Shift held, a
+ * number is shown as a histogram over the whole fleet.
+ */
 void MainWindow::on_customDataTable_itemDoubleClicked(QTableWidgetItem *item)
 {
-
-    chartEntry =  ui->customDataTable->item(item->row(), 0)->text();
+    QString key = ui->customDataTable->item(item->row(), 0)->text();
     RobotData* robot = dataModel->getRobotByID(dataModel->selectedRobotID);
 
+    if(!robot)
+        return;
 
-    chartType =robot->getValueType(chartEntry);
-    chartReset = true;
+    Qt::KeyboardModifiers modifiers = QApplication::keyboardModifiers();
+    bool number = robot->getValueType(key) == ValueType::Double;
 
-    redrawChart();
+    if(number && (modifiers & Qt::ShiftModifier))
+        chartModel->showHistogram(key);
+    else if(number && (modifiers & Qt::ControlModifier))
+        chartModel->addValue(robot->getID(), key);
+    else
+        chartModel->showValue(key, robot->getValueType(key));
 }
 
-void MainWindow::updateChart(bool listChanged, QString robotId, std::vector<QString> changedData)
+void MainWindow::resettingChart()
 {
-  static int count = 0;
-    disconnect(dataModel, SIGNAL(modelChanged(bool, QString, std::vector<QString>)), this, SLOT(updateChart(bool, QString, std::vector<QString>)));
-    Defer({
-        connect(dataModel, SIGNAL(modelChanged(bool, QString, std::vector<QString>)), this, SLOT(updateChart(bool, QString, std::vector<QString>)));
-          });
-
-    if (robotId!=dataModel->selectedRobotID)
-        return;
-
-    if(std::find(changedData.begin(), changedData.end(),chartEntry ) == changedData.end())
-        return;
+    chartModel->selectedRobotChanged();
+}
 
-    redrawChart();
+void MainWindow::updateBluetoothlist(){
+    ui->bluetoothlist->viewport()->update();
 }
 
+// Row of the swarm metrics table timed by the communication graph
+static const int COMM_GRAPH_TIMING = SWARM_METRIC_COUNT;
 
-void MainWindow::redrawChart()
+/* SwarmMetricRow
+ * One row of the swarm metrics table: its name, decimal places, the metric
+ * whose compute time is shown next to it or -1, and how to read its value
+ * from a sample.
+ */
+struct SwarmMetricRow
 {
-    QMap<QString, int> entryList;
-    static double ChartMaxX = 0;
-    static double ChartMaxY = 0;
-
-    if (chartReset)
-    {
-        chart->removeAllSeries();
-        ChartMaxX = 0;
-        ChartMaxY = 0;
-        for(int i = 0; i<dataModel->getRobotCount(); i++)
-        {
-            dataModel->getRobotByIndex(i)->colour= QColor(255,255,255);
-        }
-
-        chartReset=false;
-    }
-
-
-
-    if (chartType==ValueType::String)
-    {
-        chart->removeAllSeries();
-        QtCharts::QPieSeries *series = new QtCharts::QPieSeries();
-        //get data for chart
-        for(int i = 0; i<dataModel->getRobotCount(); i++)
-        {
-            RobotData* robot = dataModel->getRobotByIndex(i);
-            QString value ;
-
-            if (robot->getValueType(chartEntry)==ValueType::String)
-                value = robot->getStringValue(chartEntry);
-            else
-                value = "empty";
-
-            if(entryList.contains(value))
-                entryList[value] = entryList[value] + 1;
-            else
-                entryList[value] = 1;
-
-            if(colourList.contains(value))
-                robot->colour = colourList[value];
-            else
-            {
-                colourList[value] = colourmap[colourCounter%NR_OF_COLOURS];
-                robot->colour = colourList[value];
-                colourCounter++;
-            }
-
-
-        }
-        int counter = 0;
-        //create chart from data
-        QFont font("Arial", 8);
-        for(const auto& key : entryList.keys())
-        {
-            QString label = QString("%1 %2").arg(entryList[key]).arg(key);
-            series->append(label, entryList[key]);
-            QtCharts::QPieSlice *slice = series->slices().at(counter );
-            slice->setLabelFont(font);
-            slice->setColor(colourList[key]);
-            //slice->setLabelVisible();
+    QString name;
+    int decimals;
+    int timing;
+    double (*value)(const SwarmMetricsSample&);
+};
+
+/* swarmMetricRows
+ * The rows of the swarm metrics table.
+ */
+static const std::vector<SwarmMetricRow>& swarmMetricRows()
+{
+    static const std::vector<SwarmMetricRow> rows{
+        {"Robots", 0, -1, [](const SwarmMetricsSample& s){ return (double)s.robots; }},
+        {"Centroid x", 3, -1, [](const SwarmMetricsSample& s){ return s.centroid.x; }},
+        {"Centroid y", 3, -1, [](const SwarmMetricsSample& s){ return s.centroid.y; }},
+        {SwarmMetrics::getMetricName(SWARM_METRIC_DISPERSION), 4, SWARM_METRIC_DISPERSION, [](const SwarmMetricsSample& s){ return s.dispersion; }},
+        {"Nearest neighbour mean", 4, SWARM_METRIC_NEAREST_NEIGHBOUR, [](const SwarmMetricsSample& s){ return s.nearestMean; }},
+        {"Nearest neighbour median", 4, -1, [](const SwarmMetricsSample& s){ return s.nearestMedian; }},
+        {"Nearest neighbour 90th percentile", 4, -1, [](const SwarmMetricsSample& s){ return s.nearest90; }},
+        {SwarmMetrics::getMetricName(SWARM_METRIC_CLUSTERS), 0, SWARM_METRIC_CLUSTERS, [](const SwarmMetricsSample& s){ return (double)s.clusters; }},
+        {SwarmMetrics::getMetricName(SWARM_METRIC_HULL_AREA), 4, SWARM_METRIC_HULL_AREA, [](const SwarmMetricsSample& s){ return s.hullArea; }},
+        {SwarmMetrics::getMetricName(SWARM_METRIC_POLARISATION), 3, SWARM_METRIC_POLARISATION, [](const SwarmMetricsSample& s){ return s.polarisation; }},
+        {"Communication edges", 0, COMM_GRAPH_TIMING, [](const SwarmMetricsSample& s){ return (double)s.commEdges; }},
+        {"Communication components", 0, -1, [](const SwarmMetricsSample& s){ return (double)s.commComponents; }},
+        {"Largest component", 0, -1, [](const SwarmMetricsSample& s){ return (double)s.largestComponent; }},
+    };
+
+    return rows;
+}
 
+/* updateSwarmMetrics
+ * Called periodically to show the latest swarm metrics, and how long each
+ * took to compute, while the metrics tab is visible.
+ */
+void MainWindow::updateSwarmMetrics()
+{
+    if(!ui->swarmMetricsTab->isVisible())
+        return;
 
-            counter ++;
+    const SwarmMetrics* metrics = dataModel->getSwarmMetrics();
+    const SwarmMetricsSample& sample = metrics->getCurrent();
+    const auto& rows = swarmMetricRows();
 
-        }
+    ui->swarmMetricsTable->setRowCount(rows.size());
 
-        series->setLabelsVisible(true);
-        chart->addSeries(series);
-        chart->createDefaultAxes();
-    }
-    else
+    for(size_t i = 0; i < rows.size(); ++i)
     {
-        if (chartType==ValueType::Array)
-        {
-            chart->removeAllSeries();
-
-            for(int i = 0; i<dataModel->getRobotCount(); i++)
-            {
-                dataModel->getRobotByIndex(i)->colour= QColor(255,255,255);
-            }
+        QString time;
+        if(rows[i].timing == COMM_GRAPH_TIMING)
+            time = QString::number(dataModel->getCommGraph()->getUpdateTime(), 'f', 1);
+        else if(rows[i].timing >= 0)
+            time = QString::number(metrics->getComputeTime((SwarmMetric)rows[i].timing), 'f', 1);
 
-            QtCharts::QBarSeries *series = new QtCharts::QBarSeries();
-            QtCharts::QBarSet *set = new QtCharts::QBarSet(chartEntry) ;
+        QString texts[] = {rows[i].name, QString::number(rows[i].value(sample), 'f', rows[i].decimals), time};
 
-            series->append(set);
-
-            RobotData* robot = dataModel->getRobotByID(dataModel->selectedRobotID);
-            if (robot->getValueType(chartEntry)==ValueType::Array)
-            {
-
-                auto arr = robot->getArrayValue(chartEntry);
-
-                for(int i = 0; i < arr.size(); ++i)
-                {
-
-                    auto item = arr[i];
-                    if(item.type == Double)
-                    {
-                        *set<<item.doubleValue;
-                        if (ChartMaxY< item.doubleValue)
-                        {
-                            ChartMaxY=item.doubleValue;
-                        }
-                    }
-                }
-                //                series->setLabelsVisible(true);
-                chart->addSeries(series);
-                chart->createDefaultAxes();
-                chart->axisY()->setMax(ChartMaxY*1.05);
-            }
-
-        }
-        else if (chartType==ValueType::Double)
+        for(int column = 0; column < 3; ++column)
         {
-            RobotData* robot = dataModel->getRobotByID(dataModel->selectedRobotID);
-            if(chart->series().isEmpty())
-            {
-                QtCharts::QLineSeries *series = new QtCharts::QLineSeries();
-                series->setUseOpenGL(true);
-
-                if (robot->getValueType(chartEntry)==ValueType::Double)
-                {
-                    double value = robot->getDoubleValue(chartEntry);
-                    series->append(1,value);
-                }
-                chart->addSeries(series);
-                chart->createDefaultAxes();
-            }
+            if(ui->swarmMetricsTable->item(i, column))
+                ui->swarmMetricsTable->item(i, column)->setText(texts[column]);
             else
-            {
-                if (robot->getValueType(chartEntry)==ValueType::Double)
-                {
-                    double value = robot->getDoubleValue(chartEntry);
-                    auto lineSeries = (QtCharts::QLineSeries*)chart->series().at(0);
-
-                    const int maxValueCount = 150;
-                    int setSize = lineSeries->count();
-
-                    if(setSize > maxValueCount)
-                    {
-                        lineSeries->removePoints(0, setSize-maxValueCount);
-                        setSize = lineSeries->count();
-                    }
-
-                    lineSeries->append(lineSeries->at(setSize-1).x()+1, value);
-
-                    ChartMaxX = lineSeries->at(setSize).x();
-                    if(ChartMaxX > maxValueCount)
-                        chart->axisX()->setMin(ChartMaxX-maxValueCount);
-
-                    chart->axisX()->setMax(ChartMaxX);
-
-                    double minY = std::numeric_limits<double>::max();
-                    double maxY = -std::numeric_limits<double>::max();
-
-                    for(int i = 0; i < setSize; ++i)
-                    {
-                        minY = std::min(minY, lineSeries->at(i).y());
-                        maxY = std::max(maxY, lineSeries->at(i).y());
-                    }
-
-                    double range = fabs(maxY - minY);
-
-                    chart->axisY()->setMin(minY - (range * 0.1));
-                    chart->axisY()->setMax(maxY + (range * 0.1));
-                }
-            }
+                ui->swarmMetricsTable->setItem(i, column, new QTableWidgetItem{texts[column]});
         }
     }
 }
 
-void MainWindow::resettingChart()
+/* on_swarmMetricsTable_itemDoubleClicked
+ * Chart the history of the swarm metric that was double clicked.
+ */
+void MainWindow::on_swarmMetricsTable_itemDoubleClicked(QTableWidgetItem *item)
 {
-    static QString oldID = "";
-    if (oldID !=dataModel->selectedRobotID)
-    {
-        chartReset = true;
-        redrawChart();
-
-    }
-    oldID =dataModel->selectedRobotID;
-}
-
-void MainWindow::updateBluetoothlist(){
-    ui->bluetoothlist->viewport()->update();
+    if(item->row() < (int)swarmMetricRows().size())
+        chartModel->showMetric(swarmMetricRows()[item->row()].value);
 }
@@ -8,20 +8,15 @@
 
 #include "../Networking/Bluetooth/bluetoothconfig.h"
 #include "../Visualiser/visualiser.h"
+#include "../Visualiser/glvisualiser.h"
 #include "../DataModel/datamodel.h"
+#include "../UI/chartmodel.h"
 
 #include <QtCharts/QChartView>
 
-#include "Application/Tracking/aruco.h"
+#include "Application/Tracking/camerarig.h"
 #include "Application/Networking/Wifi/datathread.h"
 
-#ifdef CVB_CAMERA_PRESENT
-#include "Application/Tracking/cvbcamerathread.h"
-#else
-#include "Application/Tracking/usbcamerathread.h"
-#endif
-
-#define NR_OF_COLOURS 10
 namespace Ui {
 class MainWindow;
 }
@@ -30,7 +25,8 @@ class MainWindow : public QMainWindow
 {
     Q_OBJECT
     QThread bluetoothThread;
-    Visualiser* visualiser = nullptr;
+    QThread compositorThread;
+    QWidget* visualiser = nullptr;
     DataModel* dataModel = nullptr;
     DataThread* dataThread = nullptr;
 
@@ -38,24 +34,17 @@ class MainWindow : public QMainWindow
     Bluetoothconfig * btConfig = nullptr;
 
 
-    std::map<int, QString> arucoNameMapping;
-
-    ARCameraThread* cameraThread = nullptr;
+    MarkerTable markerTable;
 
-    ArUco* arucoTracker = nullptr;
+    CameraRig* cameraRig = nullptr;
+    VideoCompositor* videoCompositor = nullptr;
 
     QDialog* addIDMappingDialog = nullptr;
     QDialog* bluetoothConfigDialog = nullptr;
     QDialog* chartDialog = nullptr;
-    bool chartReset = false;
 
     QtCharts::QChart* chart = nullptr;
-    QString chartEntry="";
-    ValueType chartType = ValueType::Unknown;
-
-    QColor colourmap[NR_OF_COLOURS];
-    QMap<QString, QColor> colourList;
-    int colourCounter = 0;
+    ChartModel* chartModel = nullptr;
 
 public:
     explicit MainWindow(QWidget *parent = 0);
@@ -84,11 +73,9 @@ public slots:
 
     void resettingChart();
 
-    void updateChart(bool listChanged, QString robotId, std::vector<QString> changedData);
-
 private slots:
 
-    void redrawChart();
+    void updateSwarmMetrics();
 
     void updateBluetoothlist();
 
@@ -108,12 +95,13 @@ private slots:
 
     void on_customDataTable_itemDoubleClicked(QTableWidgetItem *item);
 
+    void on_swarmMetricsTable_itemDoubleClicked(QTableWidgetItem *item);
+
 private:
     Ui::MainWindow* ui = nullptr;
 
     void setVideo(bool enabled);
     void updateCustomData();
-    //void redrawChart();
     void idMappingTableSetup(void);
 };
 
@@ -6,6 +6,8 @@
  */
 #include "settings.h"
 
+#include <opencv2/aruco.hpp>
+
 /* Constructor
  * Set defaults.
  */
@@ -16,11 +18,51 @@ Settings::Settings(void) {
     trackingAngleCorrection = 90;
 
     videoEnabled = true;
+    grayscaleCaptureEnabled = false;
     robotColourEnabled = false;
     imageFlip = true;
     showAverageRobotPos = false;
+    motionGatingEnabled = true;
+    poseFilterEnabled = true;
+    poseCoastTime = 0.5;
+    markerDictionary = cv::aruco::DICT_6X6_50;
+
+    cameraSource = CAMERA_SOURCE_USB;
+
+    syntheticScene.markerCount = 8;
+    syntheticScene.width = 1280;
+    syntheticScene.height = 720;
+    syntheticScene.fps = 30;
+    syntheticScene.markerSize = 80;
+    syntheticScene.speed = 0.1;
+    syntheticScene.backgroundLevel = 200;
+    syntheticScene.noiseSigma = 0;
+    syntheticScene.blurKernel = 0;
+    syntheticScene.seed = 1;
+    syntheticScene.dictionary = markerDictionary;
+
+    videoFile.fast = false;
+    videoFile.loop = false;
+    videoFile.startFrame = 0;
+
+    calibrationFile = "./CameraCalibration.yml";
+    arenaSize.x = 1.0;
+    arenaSize.y = 1.0;
 
-    posHistorySampleInterval = 10;
+    latencyOverlayEnabled = false;
+    openGLVisualiserEnabled = false;
+    visualiserDetail = VISUALISER_DETAIL_AUTO;
+    occupancyOverlayEnabled = false;
+
+    poseHistoryDuration = 60;
+    poseHistoryInterval = 50;
+    trailLength = 10;
+    valueHistoryDuration = 7200;
+    valueHistorySamples = 1 << 23;
+    chartWindow = 120;
+    clusterDistance = 0.05;
+    proximityDistance = 0.05;
+    commRadius = 0;
 
     idMapping.reserve(2);
 }
@@ -86,6 +128,21 @@ void Settings::setVideoEnabled(bool enable) {
     this->videoEnabled = enable;
 }
 
+/* isGrayscaleCaptureEnabled
+ * Returns true if cameras publish only the luma plane of each frame.
+ */
+bool Settings::isGrayscaleCaptureEnabled(void) {
+    return this->grayscaleCaptureEnabled;
+}
+
+/* setGrayscaleCaptureEnabled
+ * Enables or disables grayscale capture. Marker detection only needs luma,
+ * so colour is only worth capturing while the video is shown.
+ */
+void Settings::setGrayscaleCaptureEnabled(bool enable) {
+    this->grayscaleCaptureEnabled = enable;
+}
+
 /* isRobotColourEnabled
  * Returns true if robots should have different colours.
  */
@@ -100,18 +157,145 @@ void Settings::setRobotColourEnabled(bool enable) {
     this->robotColourEnabled = enable;
 }
 
-/* getPosHistorySampleInterval
- * Returns the interval for robot position history sampling.
+/* getPoseHistoryDuration
+ * Returns how long, in seconds, the position history of each robot covers.
+ */
+double Settings::getPoseHistoryDuration(void) {
+    return this->poseHistoryDuration;
+}
+
+/* setPoseHistoryDuration
+ * Sets how long, in seconds, the position history of each robot covers.
+ * Only applies to robots seen after the change.
+ */
+void Settings::setPoseHistoryDuration(double seconds) {
+    this->poseHistoryDuration = seconds > 0 ? seconds : 0;
+}
+
+/* getPoseHistoryInterval
+ * Returns the shortest time, in milliseconds, between two recorded positions.
+ */
+int Settings::getPoseHistoryInterval(void) {
+    return this->poseHistoryInterval;
+}
+
+/* setPoseHistoryInterval
+ * Sets the shortest time, in milliseconds, between two recorded positions.
+ * Only applies to robots seen after the change.
+ */
+void Settings::setPoseHistoryInterval(int milliseconds) {
+    this->poseHistoryInterval = milliseconds > 0 ? milliseconds : 0;
+}
+
+/* getTrailLength
+ * Returns how many seconds of movement the trail behind each robot shows.
+ */
+double Settings::getTrailLength(void) {
+    return this->trailLength;
+}
+
+/* setTrailLength
+ * Sets how many seconds of movement the trail behind each robot shows, at
+ * most the length of the position history.
+ */
+void Settings::setTrailLength(double seconds) {
+    this->trailLength = seconds > 0 ? seconds : 0;
+}
+
+/* getValueHistoryDuration
+ * Returns how long, in seconds, the numbers received from each robot are
+ * kept for charting.
+ */
+double Settings::getValueHistoryDuration(void) {
+    return this->valueHistoryDuration;
+}
+
+/* setValueHistoryDuration
+ * Sets how long, in seconds, the numbers received from each robot are kept
+ * for charting.
+ */
+void Settings::setValueHistoryDuration(double seconds) {
+    this->valueHistoryDuration = seconds > 0 ? seconds : 0;
+}
+
+/* getValueHistorySamples
+ * Returns the most numbers kept for charting over all robots and keys
+ * together.
+ */
+int Settings::getValueHistorySamples(void) {
+    return this->valueHistorySamples;
+}
+
+/* setValueHistorySamples
+ * Sets the most numbers kept for charting over all robots and keys
+ * together.
+ */
+void Settings::setValueHistorySamples(int samples) {
+    this->valueHistorySamples = samples > 1 ? samples : 1;
+}
+
+/* getChartWindow
+ * Returns how many seconds of robot values the line chart shows.
+ */
+double Settings::getChartWindow(void) {
+    return this->chartWindow;
+}
+
+/* setChartWindow
+ * Sets how many seconds of robot values the line chart shows, at most the
+ * value history duration.
+ */
+void Settings::setChartWindow(double seconds) {
+    this->chartWindow = seconds > 0 ? seconds : 0;
+}
+
+/* getClusterDistance
+ * Returns the distance, as a proportion of the longer side of the arena,
+ * below which two robots count as part of the same cluster.
+ */
+double Settings::getClusterDistance(void) {
+    return this->clusterDistance;
+}
+
+/* setClusterDistance
+ * Sets the distance, as a proportion of the longer side of the arena, below
+ * which two robots count as part of the same cluster.
+ */
+void Settings::setClusterDistance(double distance) {
+    this->clusterDistance = distance > 0 ? distance : 0;
+}
+
+/* getProximityDistance
+ * Returns the distance, as a proportion of the longer side of the arena,
+ * below which two robots coming together is logged as an event.
+ */
+double Settings::getProximityDistance(void) {
+    return this->proximityDistance;
+}
+
+/* setProximityDistance
+ * Sets the distance, as a proportion of the longer side of the arena, below
+ * which two robots coming together is logged as an event. Zero turns these
+ * events off.
  */
-int Settings::getPosHistorySampleInterval(void) {
-    return this->posHistorySampleInterval;
+void Settings::setProximityDistance(double distance) {
+    this->proximityDistance = distance > 0 ? distance : 0;
 }
 
-/* setPosHistorySampleInterval
- * Set the interval used for robot position histoy sampling.
+/* getCommRadius
+ * Returns the communication range of the robots, as a proportion of the
+ * longer side of the arena. Zero when the communication graph is not built.
  */
-void Settings::setPosHistorySampleInterval(int interval) {
-    this->posHistorySampleInterval = interval;
+double Settings::getCommRadius(void) {
+    return this->commRadius;
+}
+
+/* setCommRadius
+ * Sets the communication range of the robots, as a proportion of the
+ * longer side of the arena. Zero turns the communication graph off.
+ */
+void Settings::setCommRadius(double radius) {
+    this->commRadius = radius > 0 ? radius : 0;
 }
 
 /* isImageFlipped
@@ -142,6 +326,236 @@ void Settings::setShowAveragePos(bool enable) {
     this->showAverageRobotPos = enable;
 }
 
+/* isMotionGatingEnabled
+ * Returns true if marker detection is restricted to regions that changed
+ */
+bool Settings::isMotionGatingEnabled(void) {
+    return this->motionGatingEnabled;
+}
+
+/* setMotionGatingEnabled
+ * Enables or disables motion gated marker detection
+ */
+void Settings::setMotionGatingEnabled(bool enable) {
+    this->motionGatingEnabled = enable;
+}
+
+/* isPoseFilterEnabled
+ * Returns true if tracked poses are smoothed over time
+ */
+bool Settings::isPoseFilterEnabled(void) {
+    return this->poseFilterEnabled;
+}
+
+/* setPoseFilterEnabled
+ * Enables or disables temporal filtering of tracked poses
+ */
+void Settings::setPoseFilterEnabled(bool enable) {
+    this->poseFilterEnabled = enable;
+}
+
+/* getPoseCoastTime
+ * Returns how long, in seconds, a robot keeps being predicted after its
+ * marker is lost
+ */
+double Settings::getPoseCoastTime(void) {
+    return this->poseCoastTime;
+}
+
+/* setPoseCoastTime
+ * Sets how long, in seconds, a robot keeps being predicted after its marker
+ * is lost
+ */
+void Settings::setPoseCoastTime(double seconds) {
+    this->poseCoastTime = seconds > 0 ? seconds : 0.001;
+}
+
+/* getMarkerDictionary
+ * Returns the predefined ArUco dictionary that markers are decoded with.
+ */
+int Settings::getMarkerDictionary(void) {
+    return this->markerDictionary;
+}
+
+/* setMarkerDictionary
+ * Sets the predefined ArUco dictionary. Larger dictionaries allow more
+ * robots, smaller marker grids decode faster.
+ */
+void Settings::setMarkerDictionary(int dictionary) {
+    this->markerDictionary = dictionary;
+}
+
+/* getCameraSource
+ * Returns the kind of camera that frames are read from
+ */
+CameraSource Settings::getCameraSource(void) {
+    return this->cameraSource;
+}
+
+/* setCameraSource
+ * Sets the kind of camera that frames are read from
+ */
+void Settings::setCameraSource(CameraSource source) {
+    this->cameraSource = source;
+}
+
+/* getSyntheticSceneConfig
+ * Returns the configuration of the synthetic marker scene camera
+ */
+SyntheticSceneConfig Settings::getSyntheticSceneConfig(void) {
+    return this->syntheticScene;
+}
+
+/* setSyntheticSceneConfig
+ * Sets the configuration of the synthetic marker scene camera
+ */
+void Settings::setSyntheticSceneConfig(SyntheticSceneConfig config) {
+    this->syntheticScene = config;
+}
+
+/* getVideoFileConfig
+ * Returns the configuration of the video file camera
+ */
+VideoFileConfig Settings::getVideoFileConfig(void) {
+    return this->videoFile;
+}
+
+/* setVideoFileConfig
+ * Sets the configuration of the video file camera
+ */
+void Settings::setVideoFileConfig(VideoFileConfig config) {
+    this->videoFile = config;
+}
+
+/* getCalibrationFile
+ * Returns the path of the camera calibration file
+ */
+QString Settings::getCalibrationFile(void) {
+    return this->calibrationFile;
+}
+
+/* setCalibrationFile
+ * Sets the path of the camera calibration file
+ */
+void Settings::setCalibrationFile(QString file) {
+    this->calibrationFile = file;
+}
+
+/* getArenaSize
+ * Returns the size of the arena in metres. Without a camera calibration
+ * positions are proportions of the image and the arena is 1 x 1.
+ */
+Vector2D Settings::getArenaSize(void) {
+    return this->arenaSize;
+}
+
+/* setArenaSize
+ * Sets the size of the arena in metres.
+ */
+void Settings::setArenaSize(Vector2D size) {
+    this->arenaSize = size;
+}
+
+/* getCameras
+ * Returns the cameras that cover the arena. Unless cameras have been listed
+ * this is the single camera given by the camera source and calibration file.
+ */
+std::vector<CameraConfig> Settings::getCameras(void) {
+    if (!this->cameras.empty()) {
+        return this->cameras;
+    }
+
+    CameraConfig camera;
+    camera.source = this->cameraSource;
+    camera.argument = this->cameraSource == CAMERA_SOURCE_VIDEO_FILE ? this->videoFile.file : QString();
+    camera.calibrationFile = this->calibrationFile;
+    return {camera};
+}
+
+/* setCameras
+ * Sets the cameras that cover the arena. All calibrations must map to the
+ * same arena frame.
+ */
+void Settings::setCameras(std::vector<CameraConfig> cameras) {
+    this->cameras = cameras;
+}
+
+/* isLatencyOverlayEnabled
+ * Returns true if tracking latency statistics are drawn over the video.
+ */
+bool Settings::isLatencyOverlayEnabled(void) {
+    return this->latencyOverlayEnabled;
+}
+
+/* setLatencyOverlayEnabled
+ * Enables or disables the tracking latency overlay.
+ */
+void Settings::setLatencyOverlayEnabled(bool enable) {
+    this->latencyOverlayEnabled = enable;
+}
+
+/* getLatencyExportFile
+ * Returns the CSV file that latency histograms are written to on exit.
+ * Empty if they are not exported.
+ */
+QString Settings::getLatencyExportFile(void) {
+    return this->latencyExportFile;
+}
+
+/* setLatencyExportFile
+ * Sets the CSV file that latency histograms are written to on exit.
+ */
+void Settings::setLatencyExportFile(QString file) {
+    this->latencyExportFile = file;
+}
+
+/* isOpenGLVisualiserEnabled
+ * Returns true if robots are drawn by the OpenGL visualiser instead of
+ * QPainter.
+ */
+bool Settings::isOpenGLVisualiserEnabled(void) {
+    return this->openGLVisualiserEnabled;
+}
+
+/* setOpenGLVisualiserEnabled
+ * Chooses between the OpenGL and QPainter visualisers. Only read when the
+ * main window is created.
+ */
+void Settings::setOpenGLVisualiserEnabled(bool enable) {
+    this->openGLVisualiserEnabled = enable;
+}
+
+/* getVisualiserDetail
+ * Returns how robots are drawn by the visualiser. In auto mode the detail is
+ * chosen from the on screen spacing of the robots.
+ */
+VisualiserDetail Settings::getVisualiserDetail(void) {
+    return this->visualiserDetail;
+}
+
+/* setVisualiserDetail
+ * Sets how robots are drawn by the visualiser.
+ */
+void Settings::setVisualiserDetail(VisualiserDetail detail) {
+    this->visualiserDetail = detail;
+}
+
+/* isOccupancyOverlayEnabled
+ * Returns true if the map of where robots have spent their time is shown
+ * when the visualiser starts.
+ */
+bool Settings::isOccupancyOverlayEnabled(void) {
+    return this->occupancyOverlayEnabled;
+}
+
+/* setOccupancyOverlayEnabled
+ * Shows or hides the occupancy map when the visualiser starts. Time is
+ * accumulated either way.
+ */
+void Settings::setOccupancyOverlayEnabled(bool enable) {
+    this->occupancyOverlayEnabled = enable;
+}
+
 /* setTrackingAngleCorrection
  * sets the correction angle for tracking tags
  */
@@ -9,6 +9,47 @@ typedef struct {
     int robotID;
 } ArucoIDPair;
 
+typedef enum {
+    CAMERA_SOURCE_USB,
+    CAMERA_SOURCE_SYNTHETIC,
+    CAMERA_SOURCE_VIDEO_FILE
+} CameraSource;
+
+typedef enum {
+    VISUALISER_DETAIL_AUTO,
+    VISUALISER_DETAIL_GLYPHS,
+    VISUALISER_DETAIL_POINTS,
+    VISUALISER_DETAIL_DENSITY
+} VisualiserDetail;
+
+typedef struct {
+    int markerCount;
+    int width;
+    int height;
+    double fps;
+    int markerSize;
+    double speed;
+    int backgroundLevel;
+    QString backgroundFile;
+    double noiseSigma;
+    int blurKernel;
+    unsigned int seed;
+    int dictionary;
+} SyntheticSceneConfig;
+
+typedef struct {
+    QString file;
+    bool fast;
+    bool loop;
+    qint64 startFrame;
+} VideoFileConfig;
+
+typedef struct {
+    CameraSource source;
+    QString argument;
+    QString calibrationFile;
+} CameraConfig;
+
 class Settings
 {
     static Settings* s_instance;
@@ -16,12 +57,42 @@ class Settings
     Vector2D cameraImageSize;
     int trackingAngleCorrection;
     bool videoEnabled;
+    bool grayscaleCaptureEnabled;
     bool robotColourEnabled;
     bool imageFlip;
 
-    int posHistorySampleInterval;
+    double poseHistoryDuration;
+    int poseHistoryInterval;
+    double trailLength;
+    double valueHistoryDuration;
+    int valueHistorySamples;
+    double chartWindow;
+    double clusterDistance;
+    double proximityDistance;
+    double commRadius;
     bool showAverageRobotPos;
 
+    bool motionGatingEnabled;
+    bool poseFilterEnabled;
+    double poseCoastTime;
+    int markerDictionary;
+
+    CameraSource cameraSource;
+    SyntheticSceneConfig syntheticScene;
+    VideoFileConfig videoFile;
+
+    QString calibrationFile;
+    Vector2D arenaSize;
+
+    std::vector<CameraConfig> cameras;
+
+    bool latencyOverlayEnabled;
+    QString latencyExportFile;
+
+    bool openGLVisualiserEnabled;
+    VisualiserDetail visualiserDetail;
+    bool occupancyOverlayEnabled;
+
     Settings(void);
     ~Settings(void);
 
@@ -54,17 +125,89 @@ public:
     bool isVideoEnabled(void);
     void setVideoEnabled(bool enable);
 
+    bool isGrayscaleCaptureEnabled(void);
+    void setGrayscaleCaptureEnabled(bool enable);
+
     bool isRobotColourEnabled(void);
     void setRobotColourEnabled(bool enable);
 
-    int getPosHistorySampleInterval(void);
-    void setPosHistorySampleInterval(int interval);
+    double getPoseHistoryDuration(void);
+    void setPoseHistoryDuration(double seconds);
+
+    int getPoseHistoryInterval(void);
+    void setPoseHistoryInterval(int milliseconds);
+
+    double getTrailLength(void);
+    void setTrailLength(double seconds);
+
+    double getValueHistoryDuration(void);
+    void setValueHistoryDuration(double seconds);
+
+    int getValueHistorySamples(void);
+    void setValueHistorySamples(int samples);
+
+    double getChartWindow(void);
+    void setChartWindow(double seconds);
+
+    double getClusterDistance(void);
+    void setClusterDistance(double distance);
+
+    double getProximityDistance(void);
+    void setProximityDistance(double distance);
+
+    double getCommRadius(void);
+    void setCommRadius(double radius);
 
     bool isImageFlipped(void);
     void setImageFlipEnabled(bool enable);
 
     bool isShowAveragePos(void);
     void setShowAveragePos(bool enable);
+
+    bool isMotionGatingEnabled(void);
+    void setMotionGatingEnabled(bool enable);
+
+    bool isPoseFilterEnabled(void);
+    void setPoseFilterEnabled(bool enable);
+
+    double getPoseCoastTime(void);
+    void setPoseCoastTime(double seconds);
+
+    int getMarkerDictionary(void);
+    void setMarkerDictionary(int dictionary);
+
+    CameraSource getCameraSource(void);
+    void setCameraSource(CameraSource source);
+
+    SyntheticSceneConfig getSyntheticSceneConfig(void);
+    void setSyntheticSceneConfig(SyntheticSceneConfig config);
+
+    VideoFileConfig getVideoFileConfig(void);
+    void setVideoFileConfig(VideoFileConfig config);
+
+    QString getCalibrationFile(void);
+    void setCalibrationFile(QString file);
+
+    Vector2D getArenaSize(void);
+    void setArenaSize(Vector2D size);
+
+    std::vector<CameraConfig> getCameras(void);
+    void setCameras(std::vector<CameraConfig> cameras);
+
+    bool isLatencyOverlayEnabled(void);
+    void setLatencyOverlayEnabled(bool enable);
+
+    QString getLatencyExportFile(void);
+    void setLatencyExportFile(QString file);
+
+    bool isOpenGLVisualiserEnabled(void);
+    void setOpenGLVisualiserEnabled(bool enable);
+
+    VisualiserDetail getVisualiserDetail(void);
+    void setVisualiserDetail(VisualiserDetail detail);
+
+    bool isOccupancyOverlayEnabled(void);
+    void setOccupancyOverlayEnabled(bool enable);
 };
 
 #endif // SETTINGS_H
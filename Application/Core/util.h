@@ -3,6 +3,9 @@
 
 #include <QString>
 #include <QTime>
+#include <QMetaType>
+
+#include <vector>
 
 struct Vector2D {
     double x;
@@ -18,6 +21,21 @@ struct Pose
 struct TrackResult {
     QString id;
     Pose pose;
+    double quality;
+};
+
+// All poses found by the tracking system in one camera frame
+struct FrameResult {
+    int camera;
+    quint64 frameId;
+    qint64 captureTime;
+    qint64 captureTick;
+    qint64 detectedTick;
+    std::vector<TrackResult> results;
+
+    // Size of the area the positions are proportions of: the arena in
+    // metres if the camera is calibrated, otherwise the image in pixels
+    Vector2D arenaSize;
 };
 
 struct StateTransition {
@@ -30,4 +48,6 @@ void sendClosePacket(int port);
 
 double square(double val);
 
+Q_DECLARE_METATYPE(FrameResult)
+
 #endif // UTIL_H
@@ -0,0 +1,404 @@
+/* chartbenchmark.cpp
+ *
+ * Checks the structures the charts are drawn from against simple
+ * references, and times them: the sample budget of the value history,
+ * downsampling a full series, the fleet histogram as the values spread,
+ * move and bunch up, and the quantile sketch.
+ */
+
+#include "chartbenchmark.h"
+#include "valuehistory.h"
+#include "fleethistogram.h"
+#include "quantilesketch.h"
+#include "../Core/settings.h"
+#include "../Core/benchmarkstats.h"
+
+#include <QElapsedTimer>
+#include <QMap>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Sample budget of the value history check, the robots that share it and
+// the samples each robot reports before the next one joins
+static const int BUDGET_SAMPLES = 10000;
+static const int BUDGET_ROBOTS = 100;
+static const int BUDGET_STEPS = 100;
+
+// Samples in a full series, and the width of a wide chart in pixels
+static const int SERIES_SAMPLES = 1 << 17;
+static const int CHART_WIDTH = 1920;
+
+// Spikes added to each series, far enough apart to fall in separate buckets
+static const int SPIKE_COUNT = 8;
+static const double SPIKE_HEIGHT = 1000;
+
+// Robots and bins of the histogram, and how many updates are made between
+// comparisons with the reference counts
+static const int HISTOGRAM_ROBOTS = 500;
+static const int HISTOGRAM_BINS = 20;
+static const int CHECK_INTERVAL = 10;
+
+// Values added to the sketch, of which half are removed again
+static const int SKETCH_VALUES = 10000;
+static const double SKETCH_ACCURACY = 0.01;
+
+// Quantiles compared with the exact values
+static const double QUANTILES[] = {0, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 1};
+
+// Centre and spread of the values of the fleet in each phase of the
+// histogram check: spread out, far away and wide, moved below zero, bunched
+// up, and all equal
+static const double HISTOGRAM_PHASES[][2] = {{0.5, 0.2}, {1e6, 1e5}, {-3, 0.01}, {0.001, 1e-5}, {42, 0}};
+
+/* exactQuantile
+ * Returns the value at the rank the quantile sketch reports for a quantile
+ * of sorted values.
+ */
+static double exactQuantile(const std::vector<double>& sorted, double quantile) {
+    return sorted[(size_t)(quantile * (sorted.size() - 1))];
+}
+
+/* quantileMatches
+ * Returns true if an estimated quantile is within the accuracy of the
+ * sketch of the exact value.
+ */
+static bool quantileMatches(double estimate, double exact) {
+    return fabs(estimate - exact) <= SKETCH_ACCURACY * 1.0001 * fabs(exact);
+}
+
+/* checkBudget
+ * Add robots to the value history one at a time, each reporting two keys,
+ * while every robot keeps reporting, so that series start while the sample
+ * budget is full. Check that the samples of all series stay within the
+ * budget, that each series keeps its newest samples within its share, and
+ * that a robot leaving gives its samples back. Returns false on failure.
+ */
+static bool checkBudget(void) {
+    Settings* settings = Settings::instance();
+    int budget = settings->getValueHistorySamples();
+    settings->setValueHistorySamples(BUDGET_SAMPLES);
+
+    ValueHistory history;
+    bool passed = true;
+    qint64 time = 0;
+
+    for (int robots = 1; robots <= BUDGET_ROBOTS; robots++) {
+        for (int step = 0; step < BUDGET_STEPS; step++) {
+            time++;
+            for (int robot = 0; robot < robots; robot++) {
+                history.append("robot_" + QString::number(robot), "value", time, time);
+                history.append("robot_" + QString::number(robot), "other", time, -time);
+            }
+
+            passed &= history.getSampleCount() <= BUDGET_SAMPLES;
+        }
+    }
+
+    qint64 total = 0;
+    size_t share = BUDGET_SAMPLES / (2 * BUDGET_ROBOTS);
+    for (int robot = 0; robot < BUDGET_ROBOTS; robot++) {
+        for (const char* key : {"value", "other"}) {
+            const ValueSeries* series = history.getSeries("robot_" + QString::number(robot), key);
+            passed &= series != nullptr && !series->empty() && series->size() <= share && series->back().time == time;
+            total += series ? series->size() : 0;
+        }
+    }
+
+    passed &= total == history.getSampleCount();
+
+    const ValueSeries* leaving = history.getSeries("robot_0", "value");
+    qint64 remaining = history.getSampleCount() - 2 * (leaving ? leaving->size() : 0);
+    history.removeRobot("robot_0");
+    passed &= history.getSeries("robot_0", "value") == nullptr && history.getSampleCount() == remaining;
+
+    printf("Value history of %d robots with 2 keys in a budget of %d samples: %lld kept, %s\n",
+           BUDGET_ROBOTS, BUDGET_SAMPLES, total, passed ? "passed" : "failed");
+
+    settings->setValueHistorySamples(budget);
+    return passed;
+}
+
+/* checkDownsample
+ * Downsample random walks with spikes over random windows, and check that
+ * the result is no wider than the chart, is taken from the series in order,
+ * starts and ends with the window and keeps every spike. Returns false on
+ * failure.
+ */
+static bool checkDownsample(int rounds) {
+    std::mt19937 random{1};
+    std::uniform_int_distribution<int> gap(1, 20);
+    std::uniform_real_distribution<double> noise(-1, 1);
+    std::uniform_int_distribution<int> offset(-100, 100);
+    std::uniform_int_distribution<int> edge(0, SERIES_SAMPLES / 8);
+
+    int failures = 0;
+    std::vector<double> downsampleTimes;
+    ValueSeries series;
+    std::vector<int> spikes;
+    std::vector<ValueSample> result;
+    QElapsedTimer timer;
+
+    for (int round = 0; round < rounds; round++) {
+        series.clear();
+        qint64 time = 0;
+        double value = 0;
+
+        for (int i = 0; i < SERIES_SAMPLES; i++) {
+            time += gap(random);
+            value += noise(random);
+            series.push_back(ValueSample{time, value});
+        }
+
+        spikes.clear();
+        for (int i = 0; i < SPIKE_COUNT; i++) {
+            int spike = (i + 1) * SERIES_SAMPLES / (SPIKE_COUNT + 1) + offset(random);
+            series[spike].value += i % 2 ? -SPIKE_HEIGHT : SPIKE_HEIGHT;
+            spikes.push_back(spike);
+        }
+
+        // The window starts and ends part way through the series, between
+        // samples
+        int first = edge(random);
+        int last = SERIES_SAMPLES - 1 - edge(random);
+        qint64 from = first > 0 ? series[first - 1].time + 1 : series[first].time;
+        qint64 to = series[last].time;
+
+        timer.start();
+        ValueHistory::downsample(series, from, to, CHART_WIDTH, result);
+        downsampleTimes.push_back(timer.nsecsElapsed() / 1e6);
+
+        bool passed = (int)result.size() == CHART_WIDTH &&
+                      result.front().time == series[first].time &&
+                      result.back().time == series[last].time;
+
+        for (size_t i = 0; passed && i < result.size(); i++) {
+            auto sample = std::lower_bound(series.begin(), series.end(), result[i].time,
+                                           [](const ValueSample& s, qint64 t){ return s.time < t; });
+            passed = sample != series.end() && sample->time == result[i].time && sample->value == result[i].value &&
+                     (i == 0 || result[i - 1].time < result[i].time);
+        }
+
+        for (int spike : spikes) {
+            if (passed && spike >= first && spike <= last) {
+                passed = std::any_of(result.begin(), result.end(),
+                                     [&](const ValueSample& s){ return s.time == series[spike].time; });
+            }
+        }
+
+        // A window with fewer samples than pixels is kept whole
+        ValueHistory::downsample(series, series[first].time, series[first + 10].time, CHART_WIDTH, result);
+        passed &= result.size() == 11 && result.front().time == series[first].time && result.back().time == series[first + 10].time;
+
+        failures += !passed;
+    }
+
+    BenchmarkStats stats = getBenchmarkStats(downsampleTimes);
+    printf("Downsample %d samples to %d: mean %.3f ms, p95 %.3f ms per line, %d of %d rounds failed\n",
+           SERIES_SAMPLES, CHART_WIDTH, stats.mean, stats.p95, failures, rounds);
+
+    return failures == 0;
+}
+
+/* histogramMatches
+ * Returns true if every bin of the histogram counts exactly the values that
+ * fall in it, and its percentiles are within the accuracy of the sketch.
+ */
+static bool histogramMatches(const FleetHistogram& histogram, const QMap<QString, double>& values) {
+    if (histogram.getRobotCount() != values.size()) {
+        return false;
+    }
+
+    // Bin widths are powers of two, so the bin numbers are exact
+    std::vector<int> counts(histogram.getBinCount(), 0);
+    double width = histogram.getBinWidth();
+    double first = std::floor(histogram.getBinStart(0) / width);
+    std::vector<double> sorted;
+
+    for (double value : values) {
+        double bin = std::floor(value / width) - first;
+        if (bin < 0 || bin >= counts.size()) {
+            return false;
+        }
+
+        counts[(int)bin]++;
+        sorted.push_back(value);
+    }
+
+    for (int bin = 0; bin < histogram.getBinCount(); bin++) {
+        if (counts[bin] != histogram.getCount(bin)) {
+            return false;
+        }
+    }
+
+    std::sort(sorted.begin(), sorted.end());
+    for (double quantile : QUANTILES) {
+        if (!sorted.empty() && !quantileMatches(histogram.getQuantile(quantile), exactQuantile(sorted, quantile))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* checkHistogram
+ * Move a fleet's values through phases that make the histogram widen and
+ * shift its bins to fit new values and rebuild them narrower as the values
+ * bunch up, removing and adding robots on the way. The counts are compared
+ * with counting every value, and once the values have settled in each
+ * phase they must span more than a quarter of the bins. Returns false on
+ * failure.
+ */
+static bool checkHistogram(int rounds) {
+    std::mt19937 random{1};
+    std::uniform_int_distribution<int> robot(0, HISTOGRAM_ROBOTS - 1);
+    std::uniform_int_distribution<int> chance(0, 49);
+
+    int failures = 0;
+    int updates = 0;
+    qint64 updateTime = 0;
+    QElapsedTimer timer;
+
+    for (int round = 0; round < rounds; round++) {
+        FleetHistogram histogram{HISTOGRAM_BINS};
+        QMap<QString, double> values;
+        bool passed = true;
+
+        for (const auto& phase : HISTOGRAM_PHASES) {
+            std::normal_distribution<double> value(phase[0], phase[1]);
+
+            // Every robot is moved to the new phase, in a random order, and
+            // a few leave and return
+            std::vector<int> order(HISTOGRAM_ROBOTS);
+            for (int i = 0; i < HISTOGRAM_ROBOTS; i++) {
+                order[i] = i;
+            }
+            std::shuffle(order.begin(), order.end(), random);
+
+            for (int step = 0; step < 2 * HISTOGRAM_ROBOTS; step++) {
+                QString robotId = "robot_" + QString::number(step < HISTOGRAM_ROBOTS ? order[step] : robot(random));
+
+                timer.start();
+                if (chance(random) == 0) {
+                    histogram.remove(robotId);
+                    values.remove(robotId);
+                } else {
+                    double next = phase[1] > 0 ? value(random) : phase[0];
+                    histogram.set(robotId, next);
+                    values[robotId] = next;
+                }
+                updateTime += timer.nsecsElapsed();
+                updates++;
+
+                if (step % CHECK_INTERVAL == 0) {
+                    passed &= histogramMatches(histogram, values);
+                }
+            }
+
+            passed &= histogramMatches(histogram, values);
+
+            int low = 0;
+            int high = histogram.getBinCount() - 1;
+            while (low < high && histogram.getCount(low) == 0) {
+                low++;
+            }
+            while (high > low && histogram.getCount(high) == 0) {
+                high--;
+            }
+
+            if (phase[1] > 0 && high - low < histogram.getBinCount() / 4) {
+                printf("Values centred on %g spread over only %d of %d bins\n", phase[0], high - low + 1, histogram.getBinCount());
+                passed = false;
+            }
+        }
+
+        failures += !passed;
+    }
+
+    printf("Histogram of %d robots in %d bins: %.3f us per update, %d of %d rounds failed\n",
+           HISTOGRAM_ROBOTS, HISTOGRAM_BINS, updateTime / 1e3 / std::max(updates, 1), failures, rounds);
+
+    return failures == 0;
+}
+
+/* checkSketch
+ * Add values of both signs spread over several orders of magnitude, and
+ * zeros, to the quantile sketch, remove half of them again, and compare its
+ * quantiles with the exact ones. Returns false on failure.
+ */
+static bool checkSketch(int rounds) {
+    std::mt19937 random{1};
+    std::lognormal_distribution<double> magnitude(0, 4);
+    std::uniform_int_distribution<int> kind(0, 9);
+
+    int failures = 0;
+    qint64 updateTime = 0;
+    qint64 quantileTime = 0;
+    std::vector<double> added;
+    std::vector<double> kept;
+    QElapsedTimer timer;
+
+    for (int round = 0; round < rounds; round++) {
+        QuantileSketch sketch{SKETCH_ACCURACY};
+        added.clear();
+
+        for (int i = 0; i < SKETCH_VALUES; i++) {
+            int k = kind(random);
+            added.push_back(k == 0 ? 0 : k < 4 ? -magnitude(random) : magnitude(random));
+        }
+
+        timer.start();
+        for (double value : added) {
+            sketch.add(value);
+        }
+        std::shuffle(added.begin(), added.end(), random);
+        for (int i = 0; i < SKETCH_VALUES / 2; i++) {
+            sketch.remove(added[i]);
+        }
+        updateTime += timer.nsecsElapsed();
+
+        kept.assign(added.begin() + SKETCH_VALUES / 2, added.end());
+        std::sort(kept.begin(), kept.end());
+        bool passed = sketch.getCount() == (qint64)kept.size();
+
+        for (double quantile : QUANTILES) {
+            timer.start();
+            double estimate = sketch.getQuantile(quantile);
+            quantileTime += timer.nsecsElapsed();
+
+            if (!quantileMatches(estimate, exactQuantile(kept, quantile))) {
+                printf("Quantile %g was %g rather than %g\n", quantile, estimate, exactQuantile(kept, quantile));
+                passed = false;
+            }
+        }
+
+        failures += !passed;
+    }
+
+    int quantileCount = sizeof(QUANTILES) / sizeof(QUANTILES[0]);
+    printf("Quantile sketch of %d values: %.3f us per update, %.3f us per quantile, %d of %d rounds failed\n",
+           SKETCH_VALUES / 2, updateTime / 1e3 / (rounds * 1.5 * SKETCH_VALUES),
+           quantileTime / 1e3 / (rounds * quantileCount), failures, rounds);
+
+    return failures == 0;
+}
+
+/* runChartBenchmark
+ * Check and time the value history, fleet histogram and quantile sketch,
+ * each over a number of random rounds. Returns zero if every check passed.
+ */
+int runChartBenchmark(int frames) {
+    frames = std::max(1, frames);
+    bool passed = true;
+
+    printf("Chart benchmark: %d rounds of each check\n", frames);
+    passed &= checkBudget();
+    passed &= checkDownsample(frames);
+    passed &= checkHistogram(frames);
+    passed &= checkSketch(frames);
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,6 @@
+#ifndef CHARTBENCHMARK_H
+#define CHARTBENCHMARK_H
+
+int runChartBenchmark(int frames);
+
+#endif // CHARTBENCHMARK_H
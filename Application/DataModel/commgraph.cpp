@@ -0,0 +1,420 @@
+/* commgraph.cpp
+ *
+ * Communication range graph of the swarm and its connected components.
+ */
+
+#include "commgraph.h"
+#include "spatialindex.h"
+#include "robotdata.h"
+#include "../Core/settings.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <functional>
+
+// Weight of the newest measurement in the mean update time
+static const double UPDATE_TIME_WEIGHT = 0.1;
+
+/* Constructor
+ * Empty graph.
+ */
+CommGraph::CommGraph(const SpatialIndex* index)
+{
+    this->index = index;
+    radius = 0;
+    scaleX = 1;
+    scaleY = 1;
+    edgeCount = 0;
+    searchCount = 0;
+    mark = 0;
+    updateTime = 0;
+}
+
+/* moved
+ * Called with each new pose of a robot. The robot's edges are checked in the
+ * next update. A robot's first pose adds it to the graph as a component of
+ * its own.
+ */
+void CommGraph::moved(RobotData* robot)
+{
+    auto existing = nodeIndex.find(robot);
+    int node;
+
+    if(existing == nodeIndex.end())
+    {
+        node = nodes.size();
+        nodes.push_back(Node{robot, false, {}});
+        nodeIndex.insert(robot, node);
+        marks.push_back(0);
+        componentOf.push_back(-1);
+        positionOf.push_back(-1);
+        addMember(newComponent(), node);
+    }
+    else
+    {
+        node = *existing;
+    }
+
+    if(!nodes[node].moved)
+    {
+        nodes[node].moved = true;
+        movedNodes.push_back(node);
+    }
+}
+
+/* remove
+ * Called when a robot is deleted. Its edges are dropped one at a time, each
+ * checked for splitting its component, which leaves the robot in a
+ * component of its own. The last node takes its place.
+ */
+void CommGraph::remove(RobotData* robot)
+{
+    auto existing = nodeIndex.find(robot);
+    if(existing == nodeIndex.end())
+        return;
+
+    int node = *existing;
+    nodeIndex.erase(existing);
+
+    while(!nodes[node].neighbours.empty())
+    {
+        int neighbour = nodes[node].neighbours.back();
+        unlink(node, neighbour);
+        separate(node, neighbour);
+    }
+
+    // A robot alone in its component takes the component with it
+    int component = componentOf[node];
+    removeMember(node);
+    if(members[component].empty())
+        freeComponents.push_back(component);
+
+    int last = nodes.size() - 1;
+    if(node != last)
+    {
+        nodes[node] = std::move(nodes[last]);
+        nodeIndex[nodes[node].robot] = node;
+
+        for(int neighbour : nodes[node].neighbours)
+            std::replace(nodes[neighbour].neighbours.begin(), nodes[neighbour].neighbours.end(), last, node);
+
+        componentOf[node] = componentOf[last];
+        positionOf[node] = positionOf[last];
+        members[componentOf[node]][positionOf[node]] = node;
+    }
+
+    nodes.pop_back();
+    marks.pop_back();
+    componentOf.pop_back();
+    positionOf.pop_back();
+
+    // Moved nodes are renumbered the same way
+    movedNodes.erase(std::remove(movedNodes.begin(), movedNodes.end(), node), movedNodes.end());
+    std::replace(movedNodes.begin(), movedNodes.end(), last, node);
+
+    countComponents();
+}
+
+/* unlink
+ * Remove the edge between two nodes. Returns false if there was none.
+ */
+bool CommGraph::unlink(int node, int neighbour)
+{
+    auto& a = nodes[node].neighbours;
+    auto& b = nodes[neighbour].neighbours;
+
+    auto edge = std::find(a.begin(), a.end(), neighbour);
+    if(edge == a.end())
+        return false;
+
+    a.erase(edge);
+    b.erase(std::find(b.begin(), b.end(), node));
+    --edgeCount;
+    return true;
+}
+
+/* clearEdges
+ * Remove every edge, leaving each node in a component of its own, and mark
+ * every node as moved, so the graph is rebuilt in the next update. Used
+ * when the range or the arena proportions change.
+ */
+void CommGraph::clearEdges(void)
+{
+    movedNodes.clear();
+    members.clear();
+    freeComponents.clear();
+    droppedEdges.clear();
+
+    for(size_t i = 0; i < nodes.size(); ++i)
+    {
+        nodes[i].neighbours.clear();
+        nodes[i].moved = true;
+        movedNodes.push_back(i);
+        addMember(newComponent(), i);
+    }
+
+    edgeCount = 0;
+}
+
+/* newComponent
+ * Returns an empty component, reusing one that was emptied if possible.
+ */
+int CommGraph::newComponent(void)
+{
+    if(!freeComponents.empty())
+    {
+        int component = freeComponents.back();
+        freeComponents.pop_back();
+        return component;
+    }
+
+    members.emplace_back();
+    return members.size() - 1;
+}
+
+/* addMember
+ * Put a node in a component.
+ */
+void CommGraph::addMember(int component, int node)
+{
+    componentOf[node] = component;
+    positionOf[node] = members[component].size();
+    members[component].push_back(node);
+}
+
+/* removeMember
+ * Take a node out of its component, moving the component's last node into
+ * its place.
+ */
+void CommGraph::removeMember(int node)
+{
+    std::vector<int>& own = members[componentOf[node]];
+    int last = own.back();
+    own[positionOf[node]] = last;
+    positionOf[last] = positionOf[node];
+    own.pop_back();
+}
+
+/* join
+ * Merge the components of two linked nodes by moving the nodes of the
+ * smaller one into the larger.
+ */
+void CommGraph::join(int a, int b)
+{
+    int into = componentOf[a];
+    int from = componentOf[b];
+    if(into == from)
+        return;
+
+    if(members[into].size() < members[from].size())
+        std::swap(into, from);
+
+    for(int node : members[from])
+        addMember(into, node);
+
+    members[from].clear();
+    freeComponents.push_back(from);
+}
+
+/* separate
+ * Called with the ends of an edge just dropped, which were in the same
+ * component. Search outwards from both ends in turn, one node at a time.
+ * If the searches meet, the ends are still connected. Otherwise the search
+ * that runs out of nodes first has found the smaller part, which becomes a
+ * component of its own. Either way the cost follows the smaller part
+ * rather than the whole component.
+ */
+void CommGraph::separate(int a, int b)
+{
+    int markA = ++mark;
+    int markB = ++mark;
+    marks[a] = markA;
+    marks[b] = markB;
+    searchA.assign(1, a);
+    searchB.assign(1, b);
+
+    for(size_t next = 0; ; ++next)
+    {
+        if(next == searchA.size())
+        {
+            splitOff(searchA);
+            return;
+        }
+
+        if(expand(searchA, searchA[next], markA, markB))
+            return;
+
+        if(next == searchB.size())
+        {
+            splitOff(searchB);
+            return;
+        }
+
+        if(expand(searchB, searchB[next], markB, markA))
+            return;
+    }
+}
+
+/* expand
+ * Add the neighbours of a node to a search. Returns true if one was reached
+ * by the other search.
+ */
+bool CommGraph::expand(std::vector<int>& search, int node, int own, int other)
+{
+    searchCount++;
+
+    for(int neighbour : nodes[node].neighbours)
+    {
+        if(marks[neighbour] == other)
+            return true;
+
+        if(marks[neighbour] != own)
+        {
+            marks[neighbour] = own;
+            search.push_back(neighbour);
+        }
+    }
+
+    return false;
+}
+
+/* splitOff
+ * Move nodes found to be cut off from the rest of their component into a
+ * component of their own.
+ */
+void CommGraph::splitOff(const std::vector<int>& part)
+{
+    int component = newComponent();
+
+    for(int node : part)
+    {
+        removeMember(node);
+        addMember(component, node);
+    }
+}
+
+/* update
+ * Called once per batch of poses. Brings the edges of every robot that moved
+ * up to date, then the components.
+ */
+void CommGraph::update(void)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Every edge is checked again when the range or the arena proportions change
+    double range = Settings::instance()->getCommRadius();
+    if(range != radius || index->getScaleX() != scaleX || index->getScaleY() != scaleY)
+    {
+        radius = range;
+        scaleX = index->getScaleX();
+        scaleY = index->getScaleY();
+        clearEdges();
+    }
+
+    if(!(radius > 0))
+    {
+        for(int node : movedNodes)
+            nodes[node].moved = false;
+
+        movedNodes.clear();
+        droppedEdges.clear();
+        componentSizes.clear();
+        return;
+    }
+
+    for(int node : movedNodes)
+    {
+        Node& own = nodes[node];
+        Pose pose = own.robot->getPos();
+        own.moved = false;
+
+        // Note the edges to robots out of range, and mark the rest. Edges
+        // are only dropped once the new ones are joined, and both ends of
+        // an edge may note it.
+        ++mark;
+        for(int neighbour : own.neighbours)
+        {
+            Pose other = nodes[neighbour].robot->getPos();
+
+            if(index->distanceSquared(other.position.x - pose.position.x, other.position.y - pose.position.y) > radius * radius)
+                droppedEdges.push_back(std::make_pair(node, neighbour));
+            else
+                marks[neighbour] = mark;
+        }
+
+        // Link the robots in range that are not linked yet. The index also
+        // holds robots without a position, which are not in the graph.
+        found.clear();
+        index->queryRadius(pose.position.x, pose.position.y, radius, found);
+
+        for(RobotData* robot : found)
+        {
+            auto other = nodeIndex.find(robot);
+            if(other == nodeIndex.end() || *other == node || marks[*other] == mark)
+                continue;
+
+            own.neighbours.push_back(*other);
+            nodes[*other].neighbours.push_back(node);
+            ++edgeCount;
+            addedEdges.push_back(std::make_pair(node, *other));
+        }
+    }
+
+    movedNodes.clear();
+
+    // New edges are joined first, as they may hold together a component
+    // that loses an edge. Then each dropped edge can only split its own
+    // component in two, one part holding each end.
+    for(auto& edge : addedEdges)
+        join(edge.first, edge.second);
+
+    searchCount = 0;
+    for(auto& edge : droppedEdges)
+    {
+        if(unlink(edge.first, edge.second))
+            separate(edge.first, edge.second);
+    }
+
+    addedEdges.clear();
+    droppedEdges.clear();
+    countComponents();
+
+    double microseconds = timer.nsecsElapsed() / 1e3;
+    updateTime += UPDATE_TIME_WEIGHT * (microseconds - updateTime);
+}
+
+/* countComponents
+ * List the size of each component, largest first.
+ */
+void CommGraph::countComponents(void)
+{
+    componentSizes.clear();
+
+    for(auto& component : members)
+    {
+        if(!component.empty())
+            componentSizes.push_back(component.size());
+    }
+
+    std::sort(componentSizes.begin(), componentSizes.end(), std::greater<int>());
+}
+
+/* getEdges
+ * Replace edges with every pair of robots in range of each other, each pair
+ * once.
+ */
+void CommGraph::getEdges(std::vector<std::pair<RobotData*, RobotData*>>& edges) const
+{
+    edges.clear();
+
+    for(size_t node = 0; node < nodes.size(); ++node)
+    {
+        for(int neighbour : nodes[node].neighbours)
+        {
+            if(neighbour > (int)node)
+                edges.push_back(std::make_pair(nodes[node].robot, nodes[neighbour].robot));
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef COMMGRAPH_H
+#define COMMGRAPH_H
+
+#include <QHash>
+
+#include <utility>
+#include <vector>
+
+class RobotData;
+class SpatialIndex;
+
+/* CommGraph
+ * Unit disc graph of which robots are within communication range of each
+ * other, and its connected components. Each frame only the robots that
+ * moved are checked: edges to robots now out of range are dropped and
+ * robots newly in range, found through the spatial index, are linked. Each
+ * node is labelled with its component. A new edge merges two components by
+ * moving the nodes of the smaller. Edges are dropped after the new ones are
+ * joined, one at a time: searches from the two ends take turns until they
+ * meet or one runs out of nodes, in which case it has found a part that
+ * split off. The cost of a dropped edge
+ * therefore follows the smaller part rather than the whole graph. The range
+ * is a proportion of the longer side of the arena, as are all distances of
+ * the spatial index.
+ */
+class CommGraph
+{
+public:
+    CommGraph(const SpatialIndex* index);
+
+    void moved(RobotData* robot);
+    void remove(RobotData* robot);
+    void update(void);
+
+    int getEdgeCount(void) const { return edgeCount; }
+    int getComponentCount(void) const { return componentSizes.size(); }
+    int getLargestComponent(void) const { return componentSizes.empty() ? 0 : componentSizes.front(); }
+    const std::vector<int>& getComponentSizes(void) const { return componentSizes; }
+    void getEdges(std::vector<std::pair<RobotData*, RobotData*>>& edges) const;
+
+    double getUpdateTime(void) const { return updateTime; }
+    int getSearchCount(void) const { return searchCount; }
+
+private:
+    struct Node
+    {
+        RobotData* robot;
+        bool moved;
+        std::vector<int> neighbours;
+    };
+
+    void clearEdges(void);
+    bool unlink(int node, int neighbour);
+    int newComponent(void);
+    void addMember(int component, int node);
+    void removeMember(int node);
+    void join(int a, int b);
+    void separate(int a, int b);
+    bool expand(std::vector<int>& search, int node, int own, int other);
+    void splitOff(const std::vector<int>& part);
+    void countComponents(void);
+
+    const SpatialIndex* index;
+    double radius;
+    double scaleX;
+    double scaleY;
+
+    std::vector<Node> nodes;
+    QHash<RobotData*, int> nodeIndex;
+    std::vector<int> movedNodes;
+    int edgeCount;
+
+    // Component of each node, its place in the component's list of nodes,
+    // and the nodes of each component. Emptied components are reused.
+    std::vector<int> componentOf;
+    std::vector<int> positionOf;
+    std::vector<std::vector<int>> members;
+    std::vector<int> freeComponents;
+    std::vector<std::pair<int, int>> addedEdges;
+    std::vector<std::pair<int, int>> droppedEdges;
+    std::vector<int> componentSizes;
+    int searchCount;
+
+    // Kept between updates to avoid allocating
+    std::vector<RobotData*> found;
+    std::vector<int> marks;
+    int mark;
+    std::vector<int> searchA;
+    std::vector<int> searchB;
+
+    double updateTime;
+};
+
+#endif // COMMGRAPH_H
@@ -10,21 +10,39 @@
 #include "../Core/util.h"
 #include "../Core/log.h"
 #include "../Core/settings.h"
+#include "../Core/latencymonitor.h"
 
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QJsonValue>
+#include <QDateTime>
 
+#include <algorithm>
 #include <iostream>
 #include <stdio.h>
 
 using namespace  std;
 
+// Cells along each side of the arena occupancy grid
+static const int OCCUPANCY_GRID_SIZE = 128;
+
+// Cells along each side of the grid that robots are looked up by position in
+static const int SPATIAL_INDEX_SIZE = 64;
+
+// Longest time, in milliseconds, between two poses of a robot that is
+// counted as time spent at the first
+static const qint64 OCCUPANCY_MAX_GAP = 1000;
+
 /* Constructor
  * Set up the list of robot data (vector).
  */
-DataModel::DataModel(QObject *parent) : QObject(parent)
+DataModel::DataModel(QObject *parent) : QObject(parent),
+    occupancy(OCCUPANCY_GRID_SIZE, OCCUPANCY_GRID_SIZE),
+    spatialIndex(SPATIAL_INDEX_SIZE),
+    commGraph(&spatialIndex),
+    metrics(&spatialIndex, &commGraph),
+    eventDetector(&spatialIndex, &events)
 {
     // Instantiate the data model here
     robotDataList.reserve(10);
@@ -35,9 +53,13 @@ DataModel::DataModel(QObject *parent) : QObject(parent)
     // Initially no robot selected
     selectedRobotID = -1;
 
-    // Initialise the average position
-    averageRobotPos.x = 0.0f;
-    averageRobotPos.y = 0.0f;
+    modelTime = 0;
+    clockOffset = 0;
+
+    // Distances are measured in the calibrated arena until tracking frames
+    // say otherwise
+    Vector2D arenaSize = Settings::instance()->getArenaSize();
+    spatialIndex.setArenaSize(arenaSize.x, arenaSize.y);
 }
 
 /* Destructor
@@ -66,11 +88,7 @@ void DataModel::sort(std::function<int(RobotData*,RobotData*)> sortFunc)
  * if ID cannot be found.
  */
 RobotData* DataModel::getRobotByID(QString id) {
-    auto matchingRobot = std::find_if(robotDataList.begin(), robotDataList.end(), [&id](RobotData* r){return r->getID() == id;});
-    if(matchingRobot != robotDataList.end())
-        return *matchingRobot;
-
-    return nullptr;
+    return robotIndex.value(id, nullptr);
 }
 
 /* getRobotList
@@ -302,9 +320,10 @@ void DataModel::newData(const QString &dataString) {
 
     QString robotId = message["id"].toString();
     message.remove("id");
-    addRobotIfNotExist(robotId);
+    bool listChanged = addRobotIfNotExist(robotId);
     RobotData* robot = getRobotByID(robotId);
     std::vector<QString> receivedKeys;
+    qint64 received = receiveTime();
 
     if(message.contains("pose"))
     {
@@ -313,8 +332,11 @@ void DataModel::newData(const QString &dataString) {
         p.orientation = jsonPose["orientation"].toDouble();
         p.position.x = jsonPose["x"].toDouble();
         p.position.y = jsonPose["y"].toDouble();
-        robot->setPos(p.position.x, p.position.y);
-        robot->setAngle(p.orientation);
+
+        moveRobot(robot, p, received);
+        commGraph.update();
+        metrics.update(received);
+        eventDetector.detect(received);
 
         message.remove("pose");
         receivedKeys.push_back("pose");
@@ -334,6 +356,7 @@ void DataModel::newData(const QString &dataString) {
         case Double:
         {
             robot->setDoubleValue(key, val.toDouble());
+            valueHistory.append(robotId, key, received, val.toDouble());
             break;
         }
         case String:
@@ -345,6 +368,7 @@ void DataModel::newData(const QString &dataString) {
         {
             auto& v = robot->getObjectValue(key);
             populateObjectFromJson(v, val.toObject());
+            robot->markValueChanged(key);
             break;
         }
         case Array:
@@ -352,6 +376,7 @@ void DataModel::newData(const QString &dataString) {
             auto& v = robot->getArrayValue(key);
             v.clear();
             populateListFromJson(v, val.toArray());
+            robot->markValueChanged(key);
             break;
         }
         default:
@@ -362,26 +387,87 @@ void DataModel::newData(const QString &dataString) {
     }
 
     // Signal to the UI that new data is available
-    emit modelChanged(true, robotId, receivedKeys);
+    emit modelChanged(listChanged, robotId, receivedKeys);
 }
 
-void DataModel::newRobotPosition(QString id, Pose p)
+/* newTrackingFrame
+ * Slot. Called once per camera frame with every pose found by the tracking
+ * system. All poses are applied before a single change notification. The
+ * quality of a pose falls below one while the tracker is predicting a robot
+ * whose marker is hidden.
+ */
+void DataModel::newTrackingFrame(FrameResult frame)
 {
-    addRobotIfNotExist(id);
-    RobotData* robot = getRobotByID(id);
-    robot->setPos(p.position.x, p.position.y);
-    robot->setAngle(p.orientation);
-    emit modelChanged(true, id, {"pose"});
+    bool listChanged = false;
+    bool selectedChanged = false;
+    qint64 time = frameTime(frame.captureTime);
+
+    // Positions are proportions of each side, distances are measured with
+    // the sides in their true ratio
+    spatialIndex.setArenaSize(frame.arenaSize.x, frame.arenaSize.y);
+
+    for(auto& result : frame.results)
+    {
+        RobotData* robot = getRobotByID(result.id);
+        if(robot == nullptr)
+        {
+            robot = new RobotData{result.id};
+            robotDataList.push_back(robot);
+            robotIndex.insert(result.id, robot);
+            spatialIndex.update(robot, 0, 0);
+            listChanged = true;
+        }
+
+        // The selected robot's details are only refreshed when its pose
+        // changes. The stored pose is compared, as it is rounded when stored.
+        bool selected = !selectedRobotID.isEmpty() && result.id == selectedRobotID;
+        Pose previous = robot->getPos();
+
+        moveRobot(robot, result.pose, time);
+        robot->setTrackingConfidence(result.quality);
+
+        if(selected)
+        {
+            Pose current = robot->getPos();
+            selectedChanged |= previous.position.x != current.position.x || previous.position.y != current.position.y ||
+                    previous.orientation != current.orientation;
+        }
+    }
+
+    if(listChanged)
+        sort([](RobotData* a, RobotData* b) { return a->getID() < b->getID(); });
+
+    commGraph.update();
+    metrics.update(time);
+    eventDetector.detect(time);
+
+    LatencyMonitor::instance()->record(LATENCY_MODEL_UPDATE, LatencyMonitor::now() - frame.detectedTick);
+    LatencyMonitor::instance()->frameApplied(frame.captureTick);
+
+    // Only the selected robot's data is shown in detail, so name it only if
+    // it moved. An empty id names no robot.
+    if(!frame.results.empty())
+        emit modelChanged(listChanged, selectedChanged ? selectedRobotID : QString{}, {"pose"});
 }
 
-void DataModel::addRobotIfNotExist(QString id)
+/* addRobotIfNotExist
+ * Add a robot with the given ID unless it is already known. Returns true if
+ * a robot was added.
+ */
+bool DataModel::addRobotIfNotExist(QString id)
 {
     RobotData* r = getRobotByID(id);
     if(r == nullptr)
     {
-        robotDataList.push_back(new RobotData{id});
+        r = new RobotData{id};
+        robotDataList.push_back(r);
+        robotIndex.insert(id, r);
+        spatialIndex.update(r, 0, 0);
         sort([](RobotData* a, RobotData* b) { return a->getID() < b->getID(); });
+        return true;
     }
+
+    return false;
 }
 
 /* parsePositionPacket
@@ -407,10 +493,11 @@ void DataModel::parsePositionPacket(RobotData* robot, QString xString, QString y
         return;
     }
 
-    robot->setPos(x, y);
-    robot->setAngle(a);
-
-    updateAveragePosition();
+    qint64 time = receiveTime();
+    moveRobot(robot, Pose{Vector2D{x, y}, (double)a}, time);
+    commGraph.update();
+    metrics.update(time);
+    eventDetector.detect(time);
 }
 
 /* deleteRobot
@@ -422,25 +509,65 @@ void DataModel::deleteRobot(QString id) {
         this->selectedRobotID = "";
     }
 
-    // Retrieve the index of the robot to be deleted. Do not create it not found.
-    std::remove_if(robotDataList.begin(), robotDataList.end(), [&id](RobotData* r){ return r->getID() == id; });
+    // Retrieve the robot to be deleted. Do nothing if not found.
+    RobotData* robot = robotIndex.take(id);
+    if (robot == nullptr) {
+        return;
+    }
+
+    robotDataList.erase(std::remove(robotDataList.begin(), robotDataList.end(), robot), robotDataList.end());
+    spatialIndex.remove(robot);
+    commGraph.remove(robot);
+    metrics.remove(robot);
+    eventDetector.remove(robot);
+    valueHistory.removeRobot(id);
+    delete robot;
 }
 
-/* updateAveragePosition
- * Updates the average position.
+/* frameTime
+ * Returns the time of a tracking frame on the clock of the data model. Data
+ * is stamped with the capture time of the newest tracking frame, which runs
+ * ahead of the wall clock when a video is played faster than real time, so
+ * every consumer sees one time base. The time never goes back, even when
+ * cameras deliver their frames out of order.
  */
-void DataModel::updateAveragePosition(void) {
-    float x = 0.0f;
-    float y = 0.0f;
-    int robotCount = (int)robotDataList.size();
+qint64 DataModel::frameTime(qint64 captureTime)
+{
+    clockOffset = captureTime - QDateTime::currentMSecsSinceEpoch();
+    modelTime = std::max(modelTime, captureTime);
+    return modelTime;
+}
 
-    for (int idx = 0; idx < robotCount; idx++) {
-        RobotData* d = (RobotData*)robotDataList.at(idx);
+/* receiveTime
+ * Returns the time of data received from a robot on the clock of the data
+ * model: the wall clock, moved by as much as the tracking frames run ahead
+ * of it.
+ */
+qint64 DataModel::receiveTime(void)
+{
+    modelTime = std::max(modelTime, QDateTime::currentMSecsSinceEpoch() + clockOffset);
+    return modelTime;
+}
+
+/* moveRobot
+ * Set the pose of a robot at a time, in milliseconds since the epoch.
+ * The time since its previous position is added to the occupancy of that
+ * position, unless the robot was lost for too long in between. All pose
+ * changes go through here to keep the spatial index, the communication
+ * graph, the swarm metrics and the event detector up to date.
+ */
+void DataModel::moveRobot(RobotData* robot, Pose pose, qint64 time) {
+    Pose previous = robot->getPos();
+    qint64 elapsed = time - robot->getPoseTime();
 
-        x += d->getPos().position.x;
-        y += d->getPos().position.y;
+    if (robot->getPoseTime() > 0 && elapsed <= OCCUPANCY_MAX_GAP) {
+        occupancy.add(previous.position.x, previous.position.y, elapsed / 1000.0f);
     }
 
-    averageRobotPos.x = x/robotCount;
-    averageRobotPos.y = y/robotCount;
+    robot->setPos(pose.position.x, pose.position.y, time);
+    robot->setAngle(pose.orientation);
+    spatialIndex.update(robot, pose.position.x, pose.position.y);
+    commGraph.moved(robot);
+    metrics.moved(robot, pose);
+    eventDetector.moved(robot);
 }
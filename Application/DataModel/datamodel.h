@@ -8,11 +8,18 @@
 #include <QString>
 #include <QStringList>
 #include <QStringListModel>
+#include <QHash>
 
 #include <QMutex>
 #include <QMutexLocker>
 
 #include "robotdata.h"
+#include "occupancygrid.h"
+#include "spatialindex.h"
+#include "swarmmetrics.h"
+#include "eventdetector.h"
+#include "commgraph.h"
+#include "valuehistory.h"
 
 #define PACKET_TYPE_WATCHDOG        0
 #define PACKET_TYPE_STATE           1
@@ -28,12 +35,23 @@ class DataModel : public QObject
     Q_OBJECT
     QStringListModel* robotListModel;
     std::vector<RobotData*> robotDataList;
+    QHash<QString, RobotData*> robotIndex;
+    OccupancyGrid occupancy;
+    SpatialIndex spatialIndex;
+    CommGraph commGraph;
+    SwarmMetrics metrics;
+    EventLog events;
+    EventDetector eventDetector;
+    ValueHistory valueHistory;
+
+    // Time of the newest data applied, and how far the capture times of
+    // tracking frames run ahead of the wall clock
+    qint64 modelTime;
+    qint64 clockOffset;
 
 public:
     QString selectedRobotID;
 
-    Vector2D averageRobotPos;
-
     explicit DataModel(QObject *parent = 0);
     ~DataModel(void);
 
@@ -47,11 +65,21 @@ public:
 
     void sort(std::function<int(RobotData*,RobotData*)> sortFunc = nullptr);
 
+    OccupancyGrid* getOccupancyGrid(void) { return &occupancy; }
+    const SpatialIndex* getSpatialIndex(void) { return &spatialIndex; }
+    const SwarmMetrics* getSwarmMetrics(void) { return &metrics; }
+    EventLog* getEventLog(void) { return &events; }
+    const CommGraph* getCommGraph(void) { return &commGraph; }
+    const ValueHistory* getValueHistory(void) { return &valueHistory; }
+    qint64 getTime(void) const { return modelTime; }
+
 private:
     void parsePositionPacket(RobotData* robot, QString xString, QString yString, QString aString);
     void parseProximityPacket(RobotData* robot, QStringList data, bool background);
-    void updateAveragePosition(void);
-    void addRobotIfNotExist(QString id);
+    void moveRobot(RobotData* robot, Pose pose, qint64 time);
+    qint64 frameTime(qint64 captureTime);
+    qint64 receiveTime(void);
+    bool addRobotIfNotExist(QString id);
 
 signals:
     void modelChanged(bool listChanged, QString robotId, std::vector<QString> changedData);
@@ -59,7 +87,7 @@ signals:
 public slots:
     void newData(const QString &);
     void deleteRobot(QString ID);
-    void newRobotPosition(QString, Pose);
+    void newTrackingFrame(FrameResult frame);
 };
 
 #endif // DATAMODEL_H
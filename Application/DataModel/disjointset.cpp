@@ -0,0 +1,79 @@
+/* disjointset.cpp
+ *
+ * Union-find used to count connected groups of robots.
+ */
+
+#include "disjointset.h"
+
+#include <utility>
+
+/* Constructor
+ * Empty set.
+ */
+DisjointSet::DisjointSet(void)
+{
+    sets = 0;
+}
+
+/* reset
+ * Put each of the elements in a set of its own. Keeps the memory of earlier
+ * uses.
+ */
+void DisjointSet::reset(int size)
+{
+    parents.resize(size);
+    sizes.assign(size, 1);
+
+    for(int i = 0; i < size; ++i)
+        parents[i] = i;
+
+    sets = size;
+}
+
+/* add
+ * Add an element in a set of its own. Returns the element.
+ */
+int DisjointSet::add(void)
+{
+    int element = parents.size();
+    parents.push_back(element);
+    sizes.push_back(1);
+    ++sets;
+    return element;
+}
+
+/* find
+ * Returns the representative of an element's set. Each element on the way
+ * is pointed at its grandparent, which keeps the trees flat.
+ */
+int DisjointSet::find(int element)
+{
+    while(parents[element] != element)
+    {
+        parents[element] = parents[parents[element]];
+        element = parents[element];
+    }
+
+    return element;
+}
+
+/* join
+ * Merge the sets of two elements, hanging the smaller under the larger.
+ * Returns false if they were already in the same set.
+ */
+bool DisjointSet::join(int a, int b)
+{
+    a = find(a);
+    b = find(b);
+
+    if(a == b)
+        return false;
+
+    if(sizes[a] < sizes[b])
+        std::swap(a, b);
+
+    parents[b] = a;
+    sizes[a] += sizes[b];
+    --sets;
+    return true;
+}
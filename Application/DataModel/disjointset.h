@@ -0,0 +1,31 @@
+#ifndef DISJOINTSET_H
+#define DISJOINTSET_H
+
+#include <vector>
+
+/* DisjointSet
+ * Union-find over the integers 0 to size-1, with path halving and union by
+ * size, so that joining and finding are nearly constant time. Keeps a count
+ * of the sets.
+ */
+class DisjointSet
+{
+public:
+    DisjointSet(void);
+
+    void reset(int size);
+    int add(void);
+
+    int find(int element);
+    bool join(int a, int b);
+
+    int getSetCount(void) const { return sets; }
+    int getSetSize(int element) { return sizes[find(element)]; }
+
+private:
+    std::vector<int> parents;
+    std::vector<int> sizes;
+    int sets;
+};
+
+#endif // DISJOINTSET_H
@@ -0,0 +1,164 @@
+/* eventdetector.cpp
+ *
+ * Finds proximity and arena events in each batch of pose updates.
+ */
+
+#include "eventdetector.h"
+#include "spatialindex.h"
+#include "robotdata.h"
+#include "../Core/settings.h"
+
+#include <algorithm>
+
+// Factor of the proximity distance two robots must move apart to before
+// they count as separated, so pairs near the distance do not flicker
+static const double SEPARATION_FACTOR = 1.2;
+
+/* Constructor
+ * No robots known yet.
+ */
+EventDetector::EventDetector(const SpatialIndex* index, EventLog* log)
+{
+    this->index = index;
+    this->log = log;
+}
+
+/* moved
+ * Called with each new pose of a robot. The robot is checked in the next
+ * call to detect. A robot's first pose only sets whether it is in the arena.
+ */
+void EventDetector::moved(RobotData* robot)
+{
+    auto state = states.find(robot);
+
+    if(state == states.end())
+    {
+        Pose pose = robot->getPos();
+        RobotState added;
+        added.number = log->getRobotNumber(robot->getID());
+        added.moved = false;
+        added.outside = pose.position.x < 0 || pose.position.x > 1 || pose.position.y < 0 || pose.position.y > 1;
+        state = states.insert(robot, added);
+    }
+
+    if(!state->moved)
+    {
+        state->moved = true;
+        movedRobots.push_back(robot);
+    }
+}
+
+/* remove
+ * Called when a robot is deleted. Forgets it without logging events.
+ */
+void EventDetector::remove(RobotData* robot)
+{
+    auto state = states.find(robot);
+    if(state == states.end())
+        return;
+
+    for(RobotData* other : state->near)
+    {
+        auto& near = states[other].near;
+        near.erase(std::remove(near.begin(), near.end(), robot), near.end());
+    }
+
+    movedRobots.erase(std::remove(movedRobots.begin(), movedRobots.end(), robot), movedRobots.end());
+    states.erase(state);
+}
+
+/* detect
+ * Called after each batch of pose updates. Checks every robot that moved for
+ * leaving or entering the arena, for separating from the robots it was near,
+ * and for coming near others, and logs the events at the given time.
+ */
+void EventDetector::detect(qint64 time)
+{
+    double distance = Settings::instance()->getProximityDistance();
+    double separation = distance * SEPARATION_FACTOR;
+
+    for(RobotData* robot : movedRobots)
+    {
+        RobotState& state = states[robot];
+        Pose pose = robot->getPos();
+        state.moved = false;
+
+        bool outside = pose.position.x < 0 || pose.position.x > 1 || pose.position.y < 0 || pose.position.y > 1;
+        if(outside != state.outside)
+        {
+            state.outside = outside;
+            logEvent(outside ? EVENT_LEFT_ARENA : EVENT_ENTERED_ARENA, time, robot, nullptr);
+        }
+
+        // Pairs that moved apart, which may include pairs from an earlier distance
+        for(size_t i = 0; i < state.near.size(); )
+        {
+            RobotData* other = state.near[i];
+            Pose otherPose = other->getPos();
+
+            if(index->distanceSquared(otherPose.position.x - pose.position.x, otherPose.position.y - pose.position.y) > separation * separation)
+            {
+                auto& otherNear = states[other].near;
+                otherNear.erase(std::remove(otherNear.begin(), otherNear.end(), robot), otherNear.end());
+                state.near[i] = state.near.back();
+                state.near.pop_back();
+                logEvent(EVENT_SEPARATION, time, robot, other);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        if(!(distance > 0))
+            continue;
+
+        // Pairs that came close. The index also holds robots without a
+        // position, which are not in the states.
+        neighbours.clear();
+        index->queryRadius(pose.position.x, pose.position.y, distance, neighbours);
+
+        for(RobotData* other : neighbours)
+        {
+            if(other == robot || std::find(state.near.begin(), state.near.end(), other) != state.near.end())
+                continue;
+
+            auto otherState = states.find(other);
+            if(otherState == states.end())
+                continue;
+
+            state.near.push_back(other);
+            otherState->near.push_back(robot);
+            logEvent(EVENT_PROXIMITY, time, robot, other);
+        }
+    }
+
+    movedRobots.clear();
+}
+
+/* logEvent
+ * Add an event about one robot, or a pair, to the log at the robot's
+ * position or the midpoint of the pair.
+ */
+void EventDetector::logEvent(SwarmEventType type, qint64 time, RobotData* robot, RobotData* other)
+{
+    Pose pose = robot->getPos();
+
+    SwarmEvent event;
+    event.time = time;
+    event.type = type;
+    event.robot = states[robot].number;
+    event.other = EVENT_NO_ROBOT;
+    event.x = pose.position.x;
+    event.y = pose.position.y;
+
+    if(other)
+    {
+        Pose otherPose = other->getPos();
+        event.other = states[other].number;
+        event.x = 0.5 * (pose.position.x + otherPose.position.x);
+        event.y = 0.5 * (pose.position.y + otherPose.position.y);
+    }
+
+    log->append(event);
+}
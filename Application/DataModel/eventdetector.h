@@ -0,0 +1,51 @@
+#ifndef EVENTDETECTOR_H
+#define EVENTDETECTOR_H
+
+#include <QHash>
+
+#include <vector>
+
+#include "eventlog.h"
+
+class RobotData;
+class SpatialIndex;
+
+/* EventDetector
+ * Logs when two robots come within the proximity distance of each other and
+ * when they separate again, and when a robot leaves or re-enters the arena.
+ * Only robots that moved since the last batch of poses are checked, each
+ * against its neighbours from the spatial index and the robots it is
+ * already close to, so the cost follows the number of moving robots. The
+ * proximity distance is a proportion of the longer side of the arena.
+ */
+class EventDetector
+{
+public:
+    EventDetector(const SpatialIndex* index, EventLog* log);
+
+    void moved(RobotData* robot);
+    void remove(RobotData* robot);
+    void detect(qint64 time);
+
+private:
+    struct RobotState
+    {
+        quint32 number;
+        bool moved;
+        bool outside;
+
+        // Robots currently within the proximity distance
+        std::vector<RobotData*> near;
+    };
+
+    void logEvent(SwarmEventType type, qint64 time, RobotData* robot, RobotData* other);
+
+    const SpatialIndex* index;
+    EventLog* log;
+
+    QHash<RobotData*, RobotState> states;
+    std::vector<RobotData*> movedRobots;
+    std::vector<RobotData*> neighbours;
+};
+
+#endif // EVENTDETECTOR_H
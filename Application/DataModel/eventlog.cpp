@@ -0,0 +1,110 @@
+/* eventlog.cpp
+ *
+ * Time ordered log of proximity and arena events.
+ */
+
+#include "eventlog.h"
+
+#include <algorithm>
+
+// Most events kept before the oldest are dropped
+static const size_t EVENT_LOG_CAPACITY = 1000000;
+
+/* Constructor
+ * Empty log.
+ */
+EventLog::EventLog(void)
+{
+}
+
+/* getRobotNumber
+ * Returns the number events use for a robot ID, giving it one if it has
+ * none yet. Numbers are never reused, so events outlive deleted robots.
+ */
+quint32 EventLog::getRobotNumber(const QString& id)
+{
+    auto existing = robotNumbers.find(id);
+    if(existing != robotNumbers.end())
+        return *existing;
+
+    quint32 number = robotNames.size();
+    robotNames.append(id);
+    robotNumbers.insert(id, number);
+    return number;
+}
+
+/* getRobotName
+ * Returns the ID of a robot number.
+ */
+QString EventLog::getRobotName(quint32 number) const
+{
+    return number < (quint32)robotNames.size() ? robotNames[number] : QString{};
+}
+
+/* getTypeName
+ * Returns the name of an event type for display.
+ */
+QString EventLog::getTypeName(SwarmEventType type)
+{
+    switch(type)
+    {
+    case EVENT_PROXIMITY:
+        return "Proximity";
+    case EVENT_SEPARATION:
+        return "Separation";
+    case EVENT_LEFT_ARENA:
+        return "Left arena";
+    case EVENT_ENTERED_ARENA:
+        return "Entered arena";
+    default:
+        return "";
+    }
+}
+
+/* append
+ * Add an event. Events normally arrive in time order, one that is older than
+ * the newest is inserted in its place.
+ */
+void EventLog::append(const SwarmEvent& event)
+{
+    if(events.empty() || events.back().time <= event.time)
+    {
+        events.push_back(event);
+    }
+    else
+    {
+        auto place = std::upper_bound(events.begin(), events.end(), event.time,
+                                      [](qint64 time, const SwarmEvent& e){ return time < e.time; });
+        events.insert(place, event);
+    }
+
+    if(events.size() > EVENT_LOG_CAPACITY)
+        events.pop_front();
+}
+
+/* clear
+ * Remove every event. Robot numbers are kept.
+ */
+void EventLog::clear(void)
+{
+    events.clear();
+}
+
+/* query
+ * Replace result with the events from one time to another, inclusive, in
+ * time order. If a robot number is given, only events involving that robot
+ * are returned.
+ */
+void EventLog::query(qint64 from, qint64 to, std::vector<SwarmEvent>& result, quint32 robot) const
+{
+    result.clear();
+
+    auto first = std::lower_bound(events.begin(), events.end(), from,
+                                  [](const SwarmEvent& e, qint64 time){ return e.time < time; });
+
+    for(auto event = first; event != events.end() && event->time <= to; ++event)
+    {
+        if(robot == EVENT_NO_ROBOT || event->robot == robot || event->other == robot)
+            result.push_back(*event);
+    }
+}
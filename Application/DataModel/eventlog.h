@@ -0,0 +1,62 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+#include <deque>
+#include <vector>
+
+// Value of SwarmEvent::other for events about a single robot
+#define EVENT_NO_ROBOT      0xffffffffu
+
+enum SwarmEventType : quint8 {
+    EVENT_PROXIMITY,
+    EVENT_SEPARATION,
+    EVENT_LEFT_ARENA,
+    EVENT_ENTERED_ARENA
+};
+
+/* SwarmEvent
+ * Something that happened to one or two robots. Robots are stored as
+ * numbers from the event log rather than by ID to keep events small. The
+ * position, as proportions of the arena, is the robot's or the midpoint of
+ * the pair.
+ */
+struct SwarmEvent {
+    qint64 time;
+    float x;
+    float y;
+    quint32 robot;
+    quint32 other;
+    SwarmEventType type;
+};
+
+/* EventLog
+ * Events in time order, looked up by time range with a binary search. The
+ * oldest events are dropped once the log is full.
+ */
+class EventLog
+{
+public:
+    EventLog(void);
+
+    quint32 getRobotNumber(const QString& id);
+    QString getRobotName(quint32 number) const;
+    static QString getTypeName(SwarmEventType type);
+
+    void append(const SwarmEvent& event);
+    void clear(void);
+
+    void query(qint64 from, qint64 to, std::vector<SwarmEvent>& result, quint32 robot = EVENT_NO_ROBOT) const;
+    size_t size(void) const { return events.size(); }
+
+private:
+    std::deque<SwarmEvent> events;
+
+    QStringList robotNames;
+    QHash<QString, quint32> robotNumbers;
+};
+
+#endif // EVENTLOG_H
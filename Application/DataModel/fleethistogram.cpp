@@ -0,0 +1,273 @@
+/* fleethistogram.cpp
+ *
+ * Incremental histogram of a value over the whole fleet.
+ */
+
+#include "fleethistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Largest bin number used, well within the range doubles hold exactly
+static const double MAX_BIN_NUMBER = 1e15;
+
+/* floorShift
+ * Returns a bin number at a width 2^shift times larger, rounding down.
+ */
+static qint64 floorShift(qint64 bin, int shift)
+{
+    if(shift >= 62)
+        return bin >= 0 ? 0 : -1;
+
+    qint64 divisor = (qint64)1 << shift;
+    return bin >= 0 ? bin / divisor : -((-bin + divisor - 1) / divisor);
+}
+
+/* Constructor
+ * Empty histogram with the given number of bins.
+ */
+FleetHistogram::FleetHistogram(int binCount)
+{
+    counts.assign(std::max(8, binCount), 0);
+    first = 0;
+    exponent = 0;
+    laidOut = false;
+    version = 0;
+    layoutVersion = 0;
+}
+
+/* clear
+ * Forget every robot.
+ */
+void FleetHistogram::clear(void)
+{
+    values.clear();
+    sketch.clear();
+    std::fill(counts.begin(), counts.end(), 0);
+    laidOut = false;
+    version++;
+    layoutVersion++;
+}
+
+/* set
+ * Set the value of a robot, moving it from the bin of its previous value.
+ * Values that are not finite remove the robot.
+ */
+void FleetHistogram::set(const QString& robotId, double value)
+{
+    if(!std::isfinite(value))
+    {
+        remove(robotId);
+        return;
+    }
+
+    bool emptied = false;
+
+    auto previous = values.find(robotId);
+    if(previous != values.end())
+    {
+        if(*previous == value)
+            return;
+
+        emptied = removeValue(*previous);
+        *previous = value;
+    }
+    else
+    {
+        values.insert(robotId, value);
+    }
+
+    addValue(value);
+
+    if(emptied)
+        narrow();
+
+    version++;
+}
+
+/* remove
+ * Stop counting a robot.
+ */
+void FleetHistogram::remove(const QString& robotId)
+{
+    auto previous = values.find(robotId);
+    if(previous == values.end())
+        return;
+
+    bool emptied = removeValue(*previous);
+    values.erase(previous);
+
+    if(emptied)
+        narrow();
+
+    version++;
+}
+
+/* getBinStart
+ * Returns the lowest value counted in a bin.
+ */
+double FleetHistogram::getBinStart(int bin) const
+{
+    return std::ldexp((double)(first + bin), exponent);
+}
+
+/* getBinWidth
+ * Returns the width of every bin.
+ */
+double FleetHistogram::getBinWidth(void) const
+{
+    return std::ldexp(1.0, exponent);
+}
+
+/* binOf
+ * Returns the number of the bin a value falls in at a bin width of
+ * 2^exponent, counted from zero.
+ */
+qint64 FleetHistogram::binOf(double value, int exponent) const
+{
+    return (qint64)std::floor(std::ldexp(value, -exponent));
+}
+
+/* layOut
+ * Place the bins around a value, each a thirty-second of it wide.
+ */
+void FleetHistogram::layOut(double value)
+{
+    exponent = (int)std::floor(std::log2(std::max(fabs(value), 1e-9))) - 5;
+    first = binOf(value, exponent) - (qint64)counts.size() / 2;
+    laidOut = true;
+    layoutVersion++;
+}
+
+/* addValue
+ * Count a value, first fitting the bins around it if needed.
+ */
+void FleetHistogram::addValue(double value)
+{
+    if(!laidOut)
+        layOut(value);
+
+    double position = std::floor(std::ldexp(value, -exponent)) - first;
+    if(position < 0 || position >= counts.size())
+        fit(value);
+
+    counts[binOf(value, exponent) - first]++;
+    sketch.add(value);
+}
+
+/* removeValue
+ * Stop counting a value. Returns true if its bin is left empty.
+ */
+bool FleetHistogram::removeValue(double value)
+{
+    qint64 bin = binOf(value, exponent) - first;
+    if(bin < 0 || bin >= (qint64)counts.size() || counts[bin] == 0)
+        return false;
+
+    counts[bin]--;
+    sketch.remove(value);
+    return counts[bin] == 0;
+}
+
+/* narrow
+ * Rebuild the bins narrower once the values in them span no more than a
+ * quarter of them. Only checked when a bin is emptied.
+ */
+void FleetHistogram::narrow(void)
+{
+    int size = counts.size();
+    auto low = std::find_if(counts.begin(), counts.end(), [](int count){ return count > 0; });
+    auto high = std::find_if(counts.rbegin(), counts.rend(), [](int count){ return count > 0; });
+
+    if(values.size() < 2 || low == counts.end())
+        return;
+
+    if((counts.rend() - high) - (low - counts.begin()) <= size / 4)
+        rebuild();
+}
+
+/* fit
+ * Move and widen the bins until they hold a value as well as every value
+ * already counted. Widening merges pairs of bins, so each count stays exact.
+ */
+void FleetHistogram::fit(double value)
+{
+    int size = counts.size();
+    auto low = std::find_if(counts.begin(), counts.end(), [](int count){ return count > 0; });
+
+    if(low == counts.end())
+    {
+        layOut(value);
+        return;
+    }
+
+    qint64 lowBin = first + (low - counts.begin());
+    qint64 highBin = first + (size - 1 - (std::find_if(counts.rbegin(), counts.rend(), [](int count){ return count > 0; }) - counts.rbegin()));
+
+    int newExponent = exponent;
+    while(fabs(std::ldexp(value, -newExponent)) > MAX_BIN_NUMBER)
+        newExponent++;
+
+    qint64 start;
+    qint64 end;
+
+    for(;; newExponent++)
+    {
+        qint64 bin = binOf(value, newExponent);
+        start = std::min(floorShift(lowBin, newExponent - exponent), bin);
+        end = std::max(floorShift(highBin, newExponent - exponent), bin);
+
+        if(end - start < size)
+            break;
+    }
+
+    // Centre the values in the new bins, leaving room on both sides
+    qint64 newFirst = start - (size - 1 - (end - start)) / 2;
+    std::vector<int> merged(size, 0);
+
+    for(int i = 0; i < size; ++i)
+    {
+        if(counts[i] > 0)
+            merged[floorShift(first + i, newExponent - exponent) - newFirst] += counts[i];
+    }
+
+    counts.swap(merged);
+    first = newFirst;
+    exponent = newExponent;
+    layoutVersion++;
+}
+
+/* rebuild
+ * Lay the bins out again from the values of the robots, so that the values
+ * span about half of the bins.
+ */
+void FleetHistogram::rebuild(void)
+{
+    int size = counts.size();
+    double minimum = values.begin().value();
+    double maximum = minimum;
+
+    for(double value : values)
+    {
+        minimum = std::min(minimum, value);
+        maximum = std::max(maximum, value);
+    }
+
+    int newExponent;
+    if(maximum > minimum)
+        newExponent = (int)std::ceil(std::log2((maximum - minimum) / (size / 2)));
+    else
+        newExponent = (int)std::floor(std::log2(std::max(fabs(maximum), 1e-9))) - 5;
+
+    if(newExponent >= exponent)
+        return;
+
+    exponent = newExponent;
+    first = binOf((minimum + maximum) / 2, exponent) - size / 2;
+    std::fill(counts.begin(), counts.end(), 0);
+
+    for(double value : values)
+        counts[binOf(value, exponent) - first]++;
+
+    layoutVersion++;
+}
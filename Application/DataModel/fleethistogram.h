@@ -0,0 +1,63 @@
+#ifndef FLEETHISTOGRAM_H
+#define FLEETHISTOGRAM_H
+
+#include <QHash>
+#include <QString>
+
+#include <vector>
+
+#include "quantilesketch.h"
+
+/* FleetHistogram
+ * Distribution of the current value of one key over every robot. When a
+ * robot's value changes it is taken out of its old bin and put in its new
+ * one, so an update costs the same however large the fleet. Bins have a
+ * width that is a power of two and edges on multiples of it. When a value
+ * falls outside the bins they are merged in pairs and shifted, which keeps
+ * the counts exact without looking at the robots again. The bins are only
+ * rebuilt from the robots' values when the values have narrowed to a
+ * quarter of them. Percentiles come from a quantile sketch kept alongside.
+ */
+class FleetHistogram
+{
+public:
+    FleetHistogram(int binCount = 20);
+
+    void clear(void);
+    void set(const QString& robotId, double value);
+    void remove(const QString& robotId);
+
+    int getBinCount(void) const { return counts.size(); }
+    int getCount(int bin) const { return counts[bin]; }
+    double getBinStart(int bin) const;
+    double getBinWidth(void) const;
+    int getRobotCount(void) const { return values.size(); }
+    double getQuantile(double quantile) const { return sketch.getQuantile(quantile); }
+
+    // Change whenever a count changes, and whenever the bin edges change
+    quint64 getVersion(void) const { return version; }
+    quint64 getLayoutVersion(void) const { return layoutVersion; }
+
+private:
+    qint64 binOf(double value, int exponent) const;
+    void layOut(double value);
+    void addValue(double value);
+    bool removeValue(double value);
+    void narrow(void);
+    void fit(double value);
+    void rebuild(void);
+
+    QHash<QString, double> values;
+    std::vector<int> counts;
+
+    // Bin i covers [(first + i) * 2^exponent, (first + i + 1) * 2^exponent)
+    qint64 first;
+    int exponent;
+    bool laidOut;
+
+    QuantileSketch sketch;
+    quint64 version;
+    quint64 layoutVersion;
+};
+
+#endif // FLEETHISTOGRAM_H
@@ -0,0 +1,84 @@
+/* occupancygrid.cpp
+ *
+ * Accumulated robot occupancy of the arena.
+ */
+
+#include "occupancygrid.h"
+
+// Largest cell value, in seconds, before the colour scale first doubles
+static const float INITIAL_SCALE = 1;
+
+/* Constructor
+ * Empty grid over the whole arena.
+ */
+OccupancyGrid::OccupancyGrid(int columns, int rows)
+{
+    this->columns = columns;
+    this->rows = rows;
+    tileColumns = (columns + OCCUPANCY_TILE_SIZE - 1) / OCCUPANCY_TILE_SIZE;
+    tileRows = (rows + OCCUPANCY_TILE_SIZE - 1) / OCCUPANCY_TILE_SIZE;
+
+    cells.assign(columns * rows, 0);
+    tileDirty.assign(tileColumns * tileRows, false);
+    scale = INITIAL_SCALE;
+    allDirty = true;
+}
+
+/* add
+ * Add time spent at a position, given as proportions of the arena.
+ * Positions outside the arena are ignored.
+ */
+void OccupancyGrid::add(double x, double y, float seconds)
+{
+    if(x < 0 || x >= 1 || y < 0 || y >= 1 || seconds <= 0)
+        return;
+
+    int column = x * columns;
+    int row = y * rows;
+
+    float& cell = cells[row * columns + column];
+    cell += seconds;
+
+    if(cell > scale)
+    {
+        while(cell > scale)
+            scale *= 2;
+
+        allDirty = true;
+    }
+
+    int tile = (row / OCCUPANCY_TILE_SIZE) * tileColumns + column / OCCUPANCY_TILE_SIZE;
+    if(!tileDirty[tile])
+    {
+        tileDirty[tile] = true;
+        dirtyTiles.push_back(tile);
+    }
+}
+
+/* clear
+ * Forget all accumulated time.
+ */
+void OccupancyGrid::clear(void)
+{
+    cells.assign(cells.size(), 0);
+    scale = INITIAL_SCALE;
+    allDirty = true;
+}
+
+/* takeDirtyTiles
+ * Fill a list with the tiles changed since the last call, as row major tile
+ * indices, and mark them clean. Returns true if the whole grid must be
+ * redrawn instead, because the colour scale changed or the grid was cleared.
+ */
+bool OccupancyGrid::takeDirtyTiles(std::vector<int>& tiles)
+{
+    tiles.swap(dirtyTiles);
+    dirtyTiles.clear();
+
+    for(int tile : tiles)
+        tileDirty[tile] = false;
+
+    bool all = allDirty;
+    allDirty = false;
+    return all;
+}
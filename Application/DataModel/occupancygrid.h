@@ -0,0 +1,47 @@
+#ifndef OCCUPANCYGRID_H
+#define OCCUPANCYGRID_H
+
+#include <vector>
+
+// Side length, in cells, of the tiles that changes are tracked in
+#define OCCUPANCY_TILE_SIZE     16
+
+/* OccupancyGrid
+ * Accumulates how many seconds robots have spent in each cell of a fixed
+ * grid over the arena. Each pose update touches one cell, and the tiles
+ * that changed are remembered so that a display only redraws those.
+ */
+class OccupancyGrid
+{
+public:
+    OccupancyGrid(int columns, int rows);
+
+    void add(double x, double y, float seconds);
+    void clear(void);
+
+    int getColumns(void) const { return columns; }
+    int getRows(void) const { return rows; }
+    float getCell(int column, int row) const { return cells[row * columns + column]; }
+    float getScale(void) const { return scale; }
+
+    int getTileColumns(void) const { return tileColumns; }
+    int getTileRows(void) const { return tileRows; }
+    bool takeDirtyTiles(std::vector<int>& tiles);
+
+private:
+    int columns;
+    int rows;
+    int tileColumns;
+    int tileRows;
+
+    std::vector<float> cells;
+
+    // Power of two at least the largest cell, so colours only shift when it doubles
+    float scale;
+
+    std::vector<bool> tileDirty;
+    std::vector<int> dirtyTiles;
+    bool allDirty;
+};
+
+#endif // OCCUPANCYGRID_H
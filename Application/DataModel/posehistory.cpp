@@ -0,0 +1,111 @@
+/* posehistory.cpp
+ *
+ * Time-indexed position history of a single robot.
+ */
+
+#include "posehistory.h"
+
+#include <algorithm>
+
+// Ring buffer capacity allocated by the first sample
+static const int INITIAL_CAPACITY = 64;
+
+/* Constructor
+ * Empty history keeping one minute of samples, one every update.
+ */
+PoseHistory::PoseHistory(void)
+{
+    first = 0;
+    count = 0;
+    duration = 60000;
+    interval = 0;
+}
+
+/* setDuration
+ * Sets how long, in milliseconds, samples are kept for.
+ */
+void PoseHistory::setDuration(qint64 milliseconds)
+{
+    duration = milliseconds;
+}
+
+/* setInterval
+ * Sets the shortest time, in milliseconds, between two kept samples. Updates
+ * that arrive sooner are not recorded.
+ */
+void PoseHistory::setInterval(qint64 milliseconds)
+{
+    interval = milliseconds;
+}
+
+/* add
+ * Record a position. Samples older than the newest one are ignored so that
+ * the history stays ordered, and samples that have left the window are
+ * dropped.
+ */
+void PoseHistory::add(qint64 time, double x, double y)
+{
+    if(count > 0 && time - at(count - 1).time < std::max<qint64>(interval, 0))
+        return;
+
+    while(count > 0 && at(0).time < time - duration)
+    {
+        first = (first + 1) & (samples.size() - 1);
+        count--;
+    }
+
+    if(count == (int)samples.size())
+        grow();
+
+    PoseSample& sample = samples[(first + count) & (samples.size() - 1)];
+    sample.time = time;
+    sample.x = x;
+    sample.y = y;
+    count++;
+}
+
+/* clear
+ * Forget every sample, keeping the allocated buffer.
+ */
+void PoseHistory::clear(void)
+{
+    first = 0;
+    count = 0;
+}
+
+/* firstAtOrAfter
+ * Returns the index of the oldest sample recorded at or after a time, or
+ * the size of the history if there is none.
+ */
+int PoseHistory::firstAtOrAfter(qint64 time) const
+{
+    int low = 0;
+    int high = count;
+
+    while(low < high)
+    {
+        int middle = (low + high) / 2;
+
+        if(at(middle).time < time)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+/* grow
+ * Double the ring buffer, unwrapping the samples to the start of the new
+ * buffer.
+ */
+void PoseHistory::grow(void)
+{
+    std::vector<PoseSample> larger(samples.empty() ? INITIAL_CAPACITY : 2 * samples.size());
+
+    for(int i = 0; i < count; ++i)
+        larger[i] = at(i);
+
+    samples.swap(larger);
+    first = 0;
+}
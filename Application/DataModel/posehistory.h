@@ -0,0 +1,49 @@
+#ifndef POSEHISTORY_H
+#define POSEHISTORY_H
+
+#include <QtGlobal>
+
+#include <vector>
+
+// One recorded position, time in milliseconds since the epoch
+struct PoseSample
+{
+    qint64 time;
+    float x;
+    float y;
+};
+
+/* PoseHistory
+ * Positions of one robot over a sliding window of time, oldest first. The
+ * samples are kept in a ring buffer that grows as needed, and are ordered by
+ * time so that the samples after any moment are found by binary search.
+ */
+class PoseHistory
+{
+public:
+    PoseHistory(void);
+
+    void setDuration(qint64 milliseconds);
+    void setInterval(qint64 milliseconds);
+
+    void add(qint64 time, double x, double y);
+    void clear(void);
+
+    int size(void) const { return count; }
+    const PoseSample& at(int i) const { return samples[(first + i) & (samples.size() - 1)]; }
+
+    int firstAtOrAfter(qint64 time) const;
+
+private:
+    void grow(void);
+
+    // Capacity is a power of two so that indices wrap with a mask
+    std::vector<PoseSample> samples;
+    int first;
+    int count;
+
+    qint64 duration;
+    qint64 interval;
+};
+
+#endif // POSEHISTORY_H
@@ -0,0 +1,143 @@
+/* quantilesketch.cpp
+ *
+ * Relative error quantile sketch used for percentiles of fleet values.
+ */
+
+#include "quantilesketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Magnitudes below this are counted as zero
+static const double SKETCH_MIN_MAGNITUDE = 1e-9;
+
+/* decrement
+ * Take one from the count of a bucket, forgetting the bucket once empty.
+ * Returns false if the bucket was empty.
+ */
+static bool decrement(std::map<int, qint64>& buckets, int index)
+{
+    auto bucket = buckets.find(index);
+    if(bucket == buckets.end())
+        return false;
+
+    if(--bucket->second == 0)
+        buckets.erase(bucket);
+
+    return true;
+}
+
+/* Constructor
+ * Empty sketch whose quantiles are within the given fraction of the true
+ * values.
+ */
+QuantileSketch::QuantileSketch(double relativeAccuracy)
+{
+    gamma = (1 + relativeAccuracy) / (1 - relativeAccuracy);
+    logGamma = std::log(gamma);
+    zeros = 0;
+    count = 0;
+}
+
+/* add
+ * Count a value.
+ */
+void QuantileSketch::add(double value)
+{
+    if(!std::isfinite(value))
+        return;
+
+    if(value > SKETCH_MIN_MAGNITUDE)
+        positive[indexOf(value)]++;
+    else if(value < -SKETCH_MIN_MAGNITUDE)
+        negative[indexOf(-value)]++;
+    else
+        zeros++;
+
+    count++;
+}
+
+/* remove
+ * Stop counting a value that was added before.
+ */
+void QuantileSketch::remove(double value)
+{
+    if(!std::isfinite(value))
+        return;
+
+    bool removed = zeros > 0;
+    if(value > SKETCH_MIN_MAGNITUDE)
+        removed = decrement(positive, indexOf(value));
+    else if(value < -SKETCH_MIN_MAGNITUDE)
+        removed = decrement(negative, indexOf(-value));
+    else if(removed)
+        zeros--;
+
+    if(removed)
+        count--;
+}
+
+/* clear
+ * Forget every value.
+ */
+void QuantileSketch::clear(void)
+{
+    positive.clear();
+    negative.clear();
+    zeros = 0;
+    count = 0;
+}
+
+/* getQuantile
+ * Returns the value below which the given fraction of the values lie, or
+ * NaN if the sketch is empty. The buckets are walked from the most negative
+ * value up, so the cost follows the number of buckets in use.
+ */
+double QuantileSketch::getQuantile(double quantile) const
+{
+    if(count == 0)
+        return std::numeric_limits<double>::quiet_NaN();
+
+    quantile = std::min(1.0, std::max(0.0, quantile));
+    qint64 rank = (qint64)(quantile * (count - 1));
+    qint64 seen = 0;
+
+    for(auto bucket = negative.rbegin(); bucket != negative.rend(); ++bucket)
+    {
+        seen += bucket->second;
+        if(seen > rank)
+            return -valueOf(bucket->first);
+    }
+
+    seen += zeros;
+    if(seen > rank)
+        return 0;
+
+    for(const auto& bucket : positive)
+    {
+        seen += bucket.second;
+        if(seen > rank)
+            return valueOf(bucket.first);
+    }
+
+    return valueOf(positive.rbegin()->first);
+}
+
+/* indexOf
+ * Returns the bucket of a positive magnitude. Bucket i holds magnitudes
+ * between gamma^(i-1) and gamma^i.
+ */
+int QuantileSketch::indexOf(double magnitude) const
+{
+    return (int)std::ceil(std::log(magnitude) / logGamma);
+}
+
+/* valueOf
+ * Returns the magnitude a bucket stands for, which is within the relative
+ * accuracy of every magnitude in it.
+ */
+double QuantileSketch::valueOf(int index) const
+{
+    return 2 * std::pow(gamma, index) / (gamma + 1);
+}
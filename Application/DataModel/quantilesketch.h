@@ -0,0 +1,41 @@
+#ifndef QUANTILESKETCH_H
+#define QUANTILESKETCH_H
+
+#include <QtGlobal>
+
+#include <map>
+
+/* QuantileSketch
+ * Streaming quantile estimate with a bounded relative error, in the manner
+ * of DDSketch. Values are counted in buckets whose bounds grow
+ * geometrically, so any quantile is within the relative accuracy of the
+ * true value. Values can be removed as well as added, which lets the sketch
+ * follow values that change over time.
+ */
+class QuantileSketch
+{
+public:
+    QuantileSketch(double relativeAccuracy = 0.01);
+
+    void add(double value);
+    void remove(double value);
+    void clear(void);
+
+    qint64 getCount(void) const { return count; }
+    double getQuantile(double quantile) const;
+
+private:
+    int indexOf(double magnitude) const;
+    double valueOf(int index) const;
+
+    // Buckets of positive values and of the magnitude of negative values
+    std::map<int, qint64> positive;
+    std::map<int, qint64> negative;
+    qint64 zeros;
+    qint64 count;
+
+    double gamma;
+    double logGamma;
+};
+
+#endif // QUANTILESKETCH_H
@@ -12,6 +12,9 @@
 
 
 #include <QTableWidgetItem>
+#include <QDateTime>
+
+quint64 RobotData::lastDisplayVersion = 0;
 
 /* Construtor
  * Create a robot instance, with an ID and a name. Set other values to
@@ -21,16 +24,19 @@ RobotData::RobotData(QString id) {
     // Initialise identifiers
     this->id = id;
 
-    this->posHistoryIndex = 0;
-    this->posHistoryFrameCount = 0;
+    this->trackingConfidence = 1.0;
+    this->displayVersion = ++lastDisplayVersion;
 
     colour.setRgb(255,255,255);
 
-    // Initialise odometry
-    setPos(0.0f, 0.0f);
+    // Initialise odometry, nothing is recorded until the first real pose
+    this->pos.position.x = 0;
+    this->pos.position.y = 0;
+    this->poseTime = 0;
     setAngle(0);
 
-    bzero(this->posHistory, sizeof(Vector2D) * POS_HISTORY_COUNT);
+    history.setDuration(1000 * Settings::instance()->getPoseHistoryDuration());
+    history.setInterval(Settings::instance()->getPoseHistoryInterval());
 
 
     // Generate colour
@@ -51,15 +57,22 @@ RobotData::~RobotData(void) {
 }
 
 /* setPos
- * Update the position with new coords.
+ * Update the position with new coords, recorded at the current time.
  */
 void RobotData::setPos(float x, float y) {
-    // Then update the current position
+    setPos(x, y, QDateTime::currentMSecsSinceEpoch());
+}
+
+/* setPos
+ * Update the position with new coords measured at a time, in milliseconds
+ * since the epoch, and record them in the position history.
+ */
+void RobotData::setPos(float x, float y, qint64 time) {
     this->pos.position.x = x;
     this->pos.position.y = y;
+    this->poseTime = time;
 
-    // First update the history
-    updatePositionHistory();
+    history.add(time, x, y);
 }
 
 /* getPos
@@ -69,54 +82,6 @@ Pose RobotData::getPos(void) {
     return this->pos;
 }
 
-/* getPosHistory
- * Gets the historical position data in order of ascending age
- */
-void RobotData::getPosHistory(Pose* result) {
-    int i = 0;
-    int idx = posHistoryIndex - 1;
-
-    if (idx < 0) {
-        idx = POS_HISTORY_COUNT - 1;
-    }
-
-    while (idx != posHistoryIndex) {
-        result[i] = posHistory[idx];
-
-        i++;
-        idx--;
-
-        if (idx < 0) {
-            idx = POS_HISTORY_COUNT - 1;
-        }
-    }
-
-    result[i] = posHistory[posHistoryIndex];
-}
-
-/* updatePositionHistory
- * Check if enough frames have elapsed to insert the current position
- * into the position history array.
- */
-void RobotData::updatePositionHistory(void) {
-    if (posHistoryFrameCount == 0) {
-        posHistory[posHistoryIndex].position.x = pos.position.x;
-        posHistory[posHistoryIndex].position.y = pos.position.y;
-
-        posHistoryIndex++;
-
-        if (posHistoryIndex >= POS_HISTORY_COUNT) {
-            posHistoryIndex = 0;
-        }
-    }
-
-    posHistoryFrameCount++;
-
-    if (posHistoryFrameCount >= Settings::instance()->getPosHistorySampleInterval()) {
-        posHistoryFrameCount = 0;
-    }
-}
-
 /* getID
  * Get the robot ID number.
  */
@@ -129,6 +94,7 @@ QString RobotData::getID(void) {
  */
 void RobotData::setID(QString newId) {
     this->id = newId;
+    this->displayVersion = ++lastDisplayVersion;
 }
 
 /* getIDConst
@@ -141,13 +107,13 @@ QString RobotData::getIDConst(void) const {
 /* getAngle
  * Get the angle the robot is facing.
  */
-int RobotData::getAngle(void) {
+double RobotData::getAngle(void) {
     return this->pos.orientation;
 }
 
 /* setAngle
  * Set the robot's angle.
  */
-void RobotData::setAngle(int angle) {
+void RobotData::setAngle(double angle) {
     this->pos.orientation = angle;
 }
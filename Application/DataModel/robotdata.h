@@ -7,13 +7,11 @@
 #include <QColor>
 
 #include "../Core/util.h"
+#include "posehistory.h"
 
 #define STATE_HISTORY_COUNT     10
-#define POS_HISTORY_COUNT       30
 #define PROX_SENS_COUNT         8
 
-#define POS_HISTORY_INTERVAL    10
-
 enum ValueType
 {
     String,
@@ -46,10 +44,14 @@ class RobotData
 
     // Position
     Pose pos;
-    Pose posHistory[POS_HISTORY_COUNT];
-    int posHistoryIndex;
-    int posHistoryFrameCount;
+    qint64 poseTime;
+    PoseHistory history;
+    double trackingConfidence;
 
+    // Replaced when anything shown in the text overlay changes. Versions are
+    // unique across all robots, so one number identifies the overlay text.
+    quint64 displayVersion;
+    static quint64 lastDisplayVersion;
 
 
 public:
@@ -62,11 +64,16 @@ public:
     QString getIDConst(void) const;
 
     Pose getPos(void);
-    void getPosHistory(Pose* result);
+    const PoseHistory& getPoseHistory(void) { return history; }
     void setPos(float x, float y);
+    void setPos(float x, float y, qint64 time);
+    qint64 getPoseTime(void) { return poseTime; }
+
+    double getAngle(void);
+    void setAngle(double angle);
 
-    int getAngle(void);
-    void setAngle(int angle);
+    double getTrackingConfidence(void) { return trackingConfidence; }
+    void setTrackingConfidence(double confidence) { trackingConfidence = confidence; }
 
     ValueType getValueType(QString key)
     {
@@ -93,22 +100,41 @@ public:
     void setBoolValue(QString name, bool value)
     {
         auto& val = values[name];
+        if(val.type == Bool && val.boolValue == value)
+            return;
+
         val.type = Bool;
         val.boolValue = value;
+        valueChanged(val);
     }
 
     void setDoubleValue(QString name, double value)
     {
         auto& val = values[name];
+        if(val.type == Double && val.doubleValue == value)
+            return;
+
         val.type = Double;
         val.doubleValue = value;
+        valueChanged(val);
     }
 
     void setStringValue(QString name, QString value)
     {
         auto& val = values[name];
+        if(val.type == String && val.stringValue == value)
+            return;
+
         val.type = String;
         val.stringValue = value;
+        valueChanged(val);
+    }
+
+    // Call after changing an array or object value in place
+    void markValueChanged(QString name)
+    {
+        if(values.contains(name))
+            valueChanged(values[name]);
     }
 
     bool getBoolValue(QString name) { return values[name].boolValue; }
@@ -147,17 +173,27 @@ public:
 
     void setValueDisplayed(QString key, bool displayed)
     {
-        if(values.contains(key))
+        if(values.contains(key) && values[key].isDisplayed != displayed)
+        {
             values[key].isDisplayed = displayed;
+            displayVersion = ++lastDisplayVersion;
+        }
     }
 
+    // Changes whenever the ID or a displayed value changes, never zero
+    quint64 getDisplayVersion(void) { return displayVersion; }
+
     bool operator<(const RobotData& other)
     {
         return this->id < other.id;
     }
 
 private:
-    void updatePositionHistory(void);
+    void valueChanged(const RobotStateValue& val)
+    {
+        if(val.isDisplayed)
+            displayVersion = ++lastDisplayVersion;
+    }
 };
 
 #endif // ROBOTDATA_H
@@ -0,0 +1,44 @@
+/* slidingrange.cpp
+ *
+ * Running minimum and maximum of the samples shown on a chart.
+ */
+
+#include "slidingrange.h"
+
+/* push
+ * Add a sample. Keys must not decrease. Samples that can no longer be the
+ * minimum or maximum, because this one is newer and at least as extreme,
+ * are dropped.
+ */
+void SlidingRange::push(double key, double value)
+{
+    while(!minimums.empty() && minimums.back().second >= value)
+        minimums.pop_back();
+
+    while(!maximums.empty() && maximums.back().second <= value)
+        maximums.pop_back();
+
+    minimums.emplace_back(key, value);
+    maximums.emplace_back(key, value);
+}
+
+/* expire
+ * Forget every sample with a key before the given one.
+ */
+void SlidingRange::expire(double key)
+{
+    while(!minimums.empty() && minimums.front().first < key)
+        minimums.pop_front();
+
+    while(!maximums.empty() && maximums.front().first < key)
+        maximums.pop_front();
+}
+
+/* clear
+ * Forget every sample.
+ */
+void SlidingRange::clear(void)
+{
+    minimums.clear();
+    maximums.clear();
+}
@@ -0,0 +1,29 @@
+#ifndef SLIDINGRANGE_H
+#define SLIDINGRANGE_H
+
+#include <deque>
+#include <utility>
+
+/* SlidingRange
+ * Minimum and maximum of a window of samples that are added at one end and
+ * expire at the other, in order of a key such as time. Each side keeps a
+ * monotonic deque of the samples that can still become the extreme, so
+ * adding and expiring are amortised constant time.
+ */
+class SlidingRange
+{
+public:
+    void push(double key, double value);
+    void expire(double key);
+    void clear(void);
+
+    bool isEmpty(void) const { return minimums.empty(); }
+    double getMin(void) const { return minimums.front().second; }
+    double getMax(void) const { return maximums.front().second; }
+
+private:
+    std::deque<std::pair<double, double>> minimums;
+    std::deque<std::pair<double, double>> maximums;
+};
+
+#endif // SLIDINGRANGE_H
@@ -0,0 +1,242 @@
+/* spatialindex.cpp
+ *
+ * Uniform grid index of robot positions.
+ */
+
+#include "spatialindex.h"
+#include "robotdata.h"
+
+#include <algorithm>
+
+/* Constructor
+ * Empty index with the given number of cells along each side of the arena.
+ */
+SpatialIndex::SpatialIndex(int cellsPerSide)
+{
+    this->cellsPerSide = std::max(1, cellsPerSide);
+    cells.resize(this->cellsPerSide * this->cellsPerSide);
+    scaleX = 1;
+    scaleY = 1;
+}
+
+/* setArenaSize
+ * Set the proportions of the arena that distances are measured in. Any
+ * unit will do, only the ratio of the sides matters.
+ */
+void SpatialIndex::setArenaSize(double width, double height)
+{
+    if(!(width > 0) || !(height > 0))
+        return;
+
+    double longer = std::max(width, height);
+    scaleX = width / longer;
+    scaleY = height / longer;
+}
+
+/* update
+ * Insert a robot at a position, or move it there. Only touches the old and
+ * new cells.
+ */
+void SpatialIndex::update(RobotData* robot, double x, double y)
+{
+    int cell = cellIndex(x, y);
+    auto location = locations.find(robot);
+
+    if(location != locations.end())
+    {
+        if(location->cell == cell)
+            return;
+
+        remove(robot);
+    }
+
+    locations.insert(robot, Location{cell, (int)cells[cell].size()});
+    cells[cell].push_back(robot);
+}
+
+/* remove
+ * Take a robot out of the index. The last robot of its cell fills the gap.
+ */
+void SpatialIndex::remove(RobotData* robot)
+{
+    auto location = locations.find(robot);
+    if(location == locations.end())
+        return;
+
+    std::vector<RobotData*>& cell = cells[location->cell];
+    RobotData* last = cell.back();
+    cell[location->slot] = last;
+    cell.pop_back();
+
+    if(last != robot)
+        locations[last].slot = location->slot;
+
+    locations.remove(robot);
+}
+
+/* query
+ * Append to result every robot whose current position is inside a box,
+ * given as proportions of the arena.
+ */
+void SpatialIndex::query(double left, double top, double right, double bottom, std::vector<RobotData*>& result) const
+{
+    int firstColumn = toCell(left);
+    int lastColumn = toCell(right);
+    int firstRow = toCell(top);
+    int lastRow = toCell(bottom);
+
+    for(int row = firstRow; row <= lastRow; ++row)
+    {
+        for(int column = firstColumn; column <= lastColumn; ++column)
+        {
+            for(RobotData* robot : cells[row * cellsPerSide + column])
+            {
+                Pose pose = robot->getPos();
+
+                if(pose.position.x >= left && pose.position.x <= right && pose.position.y >= top && pose.position.y <= bottom)
+                    result.push_back(robot);
+            }
+        }
+    }
+}
+
+/* queryRadius
+ * Append to result every robot whose current position is within a distance
+ * of a point. The point is given as proportions of the arena, the distance
+ * as a proportion of its longer side.
+ */
+void SpatialIndex::queryRadius(double x, double y, double radius, std::vector<RobotData*>& result) const
+{
+    int firstColumn = toCell(x - radius / scaleX);
+    int lastColumn = toCell(x + radius / scaleX);
+    int firstRow = toCell(y - radius / scaleY);
+    int lastRow = toCell(y + radius / scaleY);
+    double radiusSquared = radius * radius;
+
+    for(int row = firstRow; row <= lastRow; ++row)
+    {
+        for(int column = firstColumn; column <= lastColumn; ++column)
+        {
+            for(RobotData* robot : cells[row * cellsPerSide + column])
+            {
+                Pose pose = robot->getPos();
+
+                if(distanceSquared(pose.position.x - x, pose.position.y - y) <= radiusSquared)
+                    result.push_back(robot);
+            }
+        }
+    }
+}
+
+/* nearest
+ * Replace result with up to count robots closest to a point and no further
+ * than maxDistance, a proportion of the longer side of the arena, from it,
+ * closest first. Rings of cells around the point
+ * are searched in turn until the next ring is further than the furthest
+ * robot kept.
+ */
+void SpatialIndex::nearest(double x, double y, size_t count, double maxDistance, std::vector<RobotData*>& result) const
+{
+    result.clear();
+    if(count == 0)
+        return;
+
+    std::vector<std::pair<double, RobotData*>> found;
+    double maxSquared = maxDistance * maxDistance;
+    int centreColumn = toCell(x);
+    int centreRow = toCell(y);
+
+    for(int ring = 0; ring < cellsPerSide; ++ring)
+    {
+        // Every robot outside the rings searched so far is at least this far away
+        double gap = nearestGap(x, y, centreColumn, centreRow, ring);
+        if(gap < 0 || gap * gap > maxSquared)
+            break;
+
+        if(found.size() >= count && gap * gap > found[count - 1].first)
+            break;
+
+        for(int row = centreRow - ring; row <= centreRow + ring; ++row)
+        {
+            if(row < 0 || row >= cellsPerSide)
+                continue;
+
+            // Inner rows of the ring only have their two end cells
+            int step = (row == centreRow - ring || row == centreRow + ring) ? 1 : std::max(1, 2 * ring);
+
+            for(int column = centreColumn - ring; column <= centreColumn + ring; column += step)
+            {
+                if(column < 0 || column >= cellsPerSide)
+                    continue;
+
+                for(RobotData* robot : cells[row * cellsPerSide + column])
+                {
+                    Pose pose = robot->getPos();
+                    double distance = distanceSquared(pose.position.x - x, pose.position.y - y);
+
+                    if(distance <= maxSquared)
+                        found.push_back(std::make_pair(distance, robot));
+                }
+            }
+        }
+
+        // Keep the closest, sorted, so the furthest kept is known
+        size_t keep = std::min(count, found.size());
+        std::partial_sort(found.begin(), found.begin() + keep, found.end(),
+                          [](const std::pair<double, RobotData*>& a, const std::pair<double, RobotData*>& b){ return a.first < b.first; });
+        found.resize(keep);
+    }
+
+    for(auto& robot : found)
+        result.push_back(robot.second);
+}
+
+/* nearestGap
+ * Shortest distance from a point to anything outside the square of cells
+ * searched before a ring, or -1 if that square already covers the grid. A
+ * robot outside the arena is kept in a border cell but is no closer than
+ * that cell, so this is a lower bound on the distance of any robot not yet
+ * searched.
+ */
+double SpatialIndex::nearestGap(double x, double y, int column, int row, int ring) const
+{
+    if(ring == 0)
+        return 0;
+
+    double cellSize = 1.0 / cellsPerSide;
+    double gap = -1;
+
+    auto closer = [&gap](bool open, double distance){
+        if(open && (gap < 0 || distance < gap))
+            gap = distance;
+    };
+
+    closer(column - ring + 1 > 0, scaleX * (x - (column - ring + 1) * cellSize));
+    closer(column + ring < cellsPerSide, scaleX * ((column + ring) * cellSize - x));
+    closer(row - ring + 1 > 0, scaleY * (y - (row - ring + 1) * cellSize));
+    closer(row + ring < cellsPerSide, scaleY * ((row + ring) * cellSize - y));
+
+    return std::max(-1.0, gap);
+}
+
+/* cellIndex
+ * Row major index of the cell containing a position.
+ */
+int SpatialIndex::cellIndex(double x, double y) const
+{
+    return toCell(y) * cellsPerSide + toCell(x);
+}
+
+/* toCell
+ * Column or row of a coordinate, clamped to the grid.
+ */
+int SpatialIndex::toCell(double value) const
+{
+    if(!(value > 0))
+        return 0;
+
+    if(value >= 1)
+        return cellsPerSide - 1;
+
+    return (int)(value * cellsPerSide);
+}
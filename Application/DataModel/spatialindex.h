@@ -0,0 +1,67 @@
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <QHash>
+
+#include <cstddef>
+#include <vector>
+
+class RobotData;
+
+/* SpatialIndex
+ * Uniform grid over the arena holding the robots in each cell. Moving a
+ * robot is constant time, and box and radius queries only look at the cells
+ * they overlap. Nearest neighbour queries search outwards ring by ring and
+ * stop once no closer robot can be found. Positions are proportions of the
+ * arena, robots outside it are kept in the border cells. Distances are
+ * proportions of the longer side of the arena: each coordinate is scaled by
+ * the length of its side over the longer one, so that radii are not
+ * stretched along the longer side of an arena that is not square.
+ */
+class SpatialIndex
+{
+public:
+    SpatialIndex(int cellsPerSide);
+
+    void update(RobotData* robot, double x, double y);
+    void remove(RobotData* robot);
+
+    void query(double left, double top, double right, double bottom, std::vector<RobotData*>& result) const;
+    void queryRadius(double x, double y, double radius, std::vector<RobotData*>& result) const;
+    void nearest(double x, double y, size_t count, double maxDistance, std::vector<RobotData*>& result) const;
+
+    int size(void) const { return locations.size(); }
+
+    void setArenaSize(double width, double height);
+    double getScaleX(void) const { return scaleX; }
+    double getScaleY(void) const { return scaleY; }
+
+    /* distanceSquared
+     * Returns the square of the distance spanned by a difference of two
+     * positions, in proportions of the longer side of the arena.
+     */
+    double distanceSquared(double dx, double dy) const {
+        dx *= scaleX;
+        dy *= scaleY;
+        return dx*dx + dy*dy;
+    }
+
+private:
+    struct Location
+    {
+        int cell;
+        int slot;
+    };
+
+    double nearestGap(double x, double y, int column, int row, int ring) const;
+    int cellIndex(double x, double y) const;
+    int toCell(double value) const;
+
+    int cellsPerSide;
+    double scaleX;
+    double scaleY;
+    std::vector<std::vector<RobotData*>> cells;
+    QHash<RobotData*, Location> locations;
+};
+
+#endif // SPATIALINDEX_H
@@ -0,0 +1,326 @@
+/* spatialindexbenchmark.cpp
+ *
+ * Compares box, radius and nearest neighbour queries through the spatial
+ * index with scanning every robot, for fleets of several sizes, and times
+ * building the communication graph, which is built on the index.
+ */
+
+#include "spatialindexbenchmark.h"
+#include "spatialindex.h"
+#include "commgraph.h"
+#include "robotdata.h"
+#include "../Core/settings.h"
+#include "../Core/benchmarkstats.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Fleet sizes compared
+static const int FLEET_SIZES[] = {100, 1000, 10000};
+
+// Cells along each side of the index, as used by the data model
+static const int INDEX_SIZE = 64;
+
+// Queries of each kind made after each step of the fleet
+static const int QUERIES_PER_FRAME = 20;
+
+// Size of the queries, as proportions of the arena
+static const double BOX_SIZE = 0.1;
+static const double QUERY_RADIUS = 0.05;
+static const size_t NEIGHBOUR_COUNT = 8;
+
+// Largest step of the random walk, as a fraction of the arena
+static const double MAX_STEP = 0.002;
+
+// Communication range used when none is set
+static const double DEFAULT_COMM_RADIUS = 0.1;
+
+// Fleet size the communication graph's per-frame cost is reported for
+static const int REPORTED_FLEET_SIZE = 1000;
+
+// Frame time at the tracking rate the communication graph must keep up with
+static const double TRACKING_FRAME_TIME = 1000.0 / 30;
+
+// Time spent on each kind of query with and without the index, in
+// nanoseconds, and the number of queries where the two disagreed
+typedef struct QueryTimes {
+    qint64 indexTime = 0;
+    qint64 scanTime = 0;
+    int mismatches = 0;
+} QueryTimes;
+
+/* squaredDistance
+ * Squared distance from a robot to a point.
+ */
+static double squaredDistance(RobotData* robot, double x, double y) {
+    Pose pose = robot->getPos();
+    double dx = pose.position.x - x;
+    double dy = pose.position.y - y;
+    return dx*dx + dy*dy;
+}
+
+/* scanBox
+ * Find the robots inside a box by checking every robot.
+ */
+static void scanBox(const std::vector<RobotData*>& fleet, double left, double top, double right, double bottom, std::vector<RobotData*>& result) {
+    for (auto robot : fleet) {
+        Pose pose = robot->getPos();
+
+        if (pose.position.x >= left && pose.position.x <= right && pose.position.y >= top && pose.position.y <= bottom) {
+            result.push_back(robot);
+        }
+    }
+}
+
+/* scanRadius
+ * Find the robots within a distance of a point by checking every robot.
+ */
+static void scanRadius(const std::vector<RobotData*>& fleet, double x, double y, double radius, std::vector<RobotData*>& result) {
+    for (auto robot : fleet) {
+        if (squaredDistance(robot, x, y) <= radius * radius) {
+            result.push_back(robot);
+        }
+    }
+}
+
+/* scanNearest
+ * Find the closest robots to a point by sorting the distances of every
+ * robot.
+ */
+static void scanNearest(const std::vector<RobotData*>& fleet, double x, double y, size_t count, std::vector<std::pair<double, RobotData*>>& distances, std::vector<RobotData*>& result) {
+    distances.clear();
+    for (auto robot : fleet) {
+        distances.push_back(std::make_pair(squaredDistance(robot, x, y), robot));
+    }
+
+    size_t keep = std::min(count, distances.size());
+    std::partial_sort(distances.begin(), distances.begin() + keep, distances.end(),
+                      [](const std::pair<double, RobotData*>& a, const std::pair<double, RobotData*>& b){ return a.first < b.first; });
+
+    result.clear();
+    for (size_t i = 0; i < keep; i++) {
+        result.push_back(distances[i].second);
+    }
+}
+
+/* printTimes
+ * Print the mean time per query with and without the index. Returns false
+ * if the two ever disagreed.
+ */
+static bool printTimes(int robots, const char* name, const QueryTimes& times, int queries) {
+    double indexTime = times.indexTime / 1e3 / queries;
+    double scanTime = times.scanTime / 1e3 / queries;
+    printf("%8d %-8s %12.2f %12.2f %10.1f\n", robots, name, scanTime, indexTime, scanTime / std::max(indexTime, 1e-3));
+
+    if (times.mismatches > 0) {
+        printf("The index and the scan disagreed on %d %s queries\n", times.mismatches, name);
+        return false;
+    }
+
+    return true;
+}
+
+/* runSpatialIndexBenchmark
+ * Move fleets of robots on a random walk, updating the index as the data
+ * model does, and after each step time random queries of each kind through
+ * the index and by scanning the fleet. Returns zero if both always agreed
+ * and the index was faster for the largest fleet.
+ */
+int runSpatialIndexBenchmark(int frames) {
+    frames = std::max(1, frames);
+    bool passed = true;
+
+    printf("Spatial index benchmark: %dx%d cells, %d frames of %d queries\n", INDEX_SIZE, INDEX_SIZE, frames, QUERIES_PER_FRAME);
+    printf("%8s %-8s %12s %12s %10s\n", "robots", "query", "scan us", "index us", "speedup");
+
+    for (int robots : FLEET_SIZES) {
+        std::mt19937 random{1};
+        std::uniform_real_distribution<double> place(0, 1);
+        std::uniform_real_distribution<double> step(-MAX_STEP, MAX_STEP);
+
+        SpatialIndex index{INDEX_SIZE};
+        std::vector<std::unique_ptr<RobotData>> owned;
+        std::vector<RobotData*> fleet;
+
+        for (int i = 0; i < robots; i++) {
+            owned.emplace_back(new RobotData("robot_" + QString::number(i)));
+            RobotData* robot = owned.back().get();
+            robot->setPos(place(random), place(random));
+            index.update(robot, robot->getPos().position.x, robot->getPos().position.y);
+            fleet.push_back(robot);
+        }
+
+        QueryTimes box, radius, nearest;
+        qint64 updateTime = 0;
+        std::vector<RobotData*> result;
+        std::vector<std::pair<double, RobotData*>> distances;
+        QElapsedTimer timer;
+
+        for (int frame = 0; frame < frames; frame++) {
+            for (auto robot : fleet) {
+                Pose pose = robot->getPos();
+                robot->setPos(std::min(1.0, std::max(0.0, pose.position.x + step(random))),
+                              std::min(1.0, std::max(0.0, pose.position.y + step(random))));
+            }
+
+            timer.start();
+            for (auto robot : fleet) {
+                index.update(robot, robot->getPos().position.x, robot->getPos().position.y);
+            }
+            updateTime += timer.nsecsElapsed();
+
+            for (int query = 0; query < QUERIES_PER_FRAME; query++) {
+                double x = place(random);
+                double y = place(random);
+
+                // Results are compared by count, and by the furthest neighbour,
+                // since robots at equal distances may come in either order
+                result.clear();
+                timer.start();
+                index.query(x - 0.5 * BOX_SIZE, y - 0.5 * BOX_SIZE, x + 0.5 * BOX_SIZE, y + 0.5 * BOX_SIZE, result);
+                box.indexTime += timer.nsecsElapsed();
+                size_t found = result.size();
+
+                result.clear();
+                timer.start();
+                scanBox(fleet, x - 0.5 * BOX_SIZE, y - 0.5 * BOX_SIZE, x + 0.5 * BOX_SIZE, y + 0.5 * BOX_SIZE, result);
+                box.scanTime += timer.nsecsElapsed();
+                box.mismatches += found != result.size();
+
+                result.clear();
+                timer.start();
+                index.queryRadius(x, y, QUERY_RADIUS, result);
+                radius.indexTime += timer.nsecsElapsed();
+                found = result.size();
+
+                result.clear();
+                timer.start();
+                scanRadius(fleet, x, y, QUERY_RADIUS, result);
+                radius.scanTime += timer.nsecsElapsed();
+                radius.mismatches += found != result.size();
+
+                timer.start();
+                index.nearest(x, y, NEIGHBOUR_COUNT, 2, result);
+                nearest.indexTime += timer.nsecsElapsed();
+                found = result.size();
+                double furthest = result.empty() ? 0 : squaredDistance(result.back(), x, y);
+
+                timer.start();
+                scanNearest(fleet, x, y, NEIGHBOUR_COUNT, distances, result);
+                nearest.scanTime += timer.nsecsElapsed();
+                nearest.mismatches += found != result.size() || (!result.empty() && furthest != squaredDistance(result.back(), x, y));
+            }
+        }
+
+        int queries = frames * QUERIES_PER_FRAME;
+        passed &= printTimes(robots, "box", box, queries);
+        passed &= printTimes(robots, "radius", radius, queries);
+        passed &= printTimes(robots, "nearest", nearest, queries);
+        printf("%8d %-8s %12s %12.3f\n", robots, "update", "", updateTime / 1e3 / (frames * (double)robots));
+
+        if (robots == FLEET_SIZES[sizeof(FLEET_SIZES) / sizeof(FLEET_SIZES[0]) - 1]) {
+            if (box.indexTime >= box.scanTime || radius.indexTime >= radius.scanTime || nearest.indexTime >= nearest.scanTime) {
+                printf("The index is slower than scanning %d robots\n", robots);
+                passed = false;
+            }
+        }
+    }
+
+    return passed ? 0 : 1;
+}
+
+/* timeCommGraph
+ * Move a fleet on a random walk, every robot moving every frame as when all
+ * are tracked, and time bringing the communication graph and its components
+ * up to date. Prints the cost per frame and returns its 95th percentile in
+ * milliseconds.
+ */
+static double timeCommGraph(int robots, int frames, double radius) {
+    std::mt19937 random{1};
+    std::uniform_real_distribution<double> place(0, 1);
+    std::uniform_real_distribution<double> step(-MAX_STEP, MAX_STEP);
+
+    SpatialIndex index{INDEX_SIZE};
+    CommGraph graph{&index};
+    std::vector<std::unique_ptr<RobotData>> fleet;
+
+    for (int i = 0; i < robots; i++) {
+        fleet.emplace_back(new RobotData("robot_" + QString::number(i)));
+        fleet.back()->setPos(place(random), place(random));
+    }
+
+    std::vector<double> frameTimes;
+    QElapsedTimer timer;
+    double firstFrame = 0;
+    long long searched = 0;
+
+    for (int frame = 0; frame < frames; frame++) {
+        for (auto& robot : fleet) {
+            Pose pose = robot->getPos();
+            robot->setPos(std::min(1.0, std::max(0.0, pose.position.x + step(random))),
+                          std::min(1.0, std::max(0.0, pose.position.y + step(random))));
+            index.update(robot.get(), robot->getPos().position.x, robot->getPos().position.y);
+            graph.moved(robot.get());
+        }
+
+        timer.start();
+        graph.update();
+        double milliseconds = timer.nsecsElapsed() / 1e6;
+
+        // The first frame builds the whole graph
+        if (frame == 0) {
+            firstFrame = milliseconds;
+        } else {
+            frameTimes.push_back(milliseconds);
+            searched += graph.getSearchCount();
+        }
+    }
+
+    printf("%d robots, range %.3f, %d frames\n", robots, radius, frames);
+    printf("First frame %.2f ms, then %d edges, %d components, largest %d\n", firstFrame, graph.getEdgeCount(),
+           graph.getComponentCount(), graph.getLargestComponent());
+
+    if (frameTimes.empty()) {
+        return firstFrame;
+    }
+
+    BenchmarkStats stats = getBenchmarkStats(frameTimes);
+    printf("Mean %.3f ms, 95th percentile %.3f ms, max %.3f ms per frame\n", stats.mean, stats.p95, stats.max);
+    printf("Nodes searched for broken links %.1f per frame\n\n", (double)searched / frameTimes.size());
+
+    return stats.p95;
+}
+
+/* runCommGraphBenchmark
+ * Time the communication graph for a fleet of 1000 robots, for which the
+ * per-frame cost is reported, and for the fleet size asked for if it
+ * differs. Returns zero if the 95th percentile kept up with 30 Hz tracking.
+ */
+int runCommGraphBenchmark(int robots, int frames) {
+    robots = std::max(1, robots);
+    frames = std::max(1, frames);
+
+    Settings* settings = Settings::instance();
+    if (!(settings->getCommRadius() > 0)) {
+        settings->setCommRadius(DEFAULT_COMM_RADIUS);
+    }
+
+    printf("Communication graph benchmark\n\n");
+
+    double slowest = timeCommGraph(REPORTED_FLEET_SIZE, frames, settings->getCommRadius());
+    if (robots != REPORTED_FLEET_SIZE) {
+        slowest = std::max(slowest, timeCommGraph(robots, frames, settings->getCommRadius()));
+    }
+
+    if (slowest > TRACKING_FRAME_TIME) {
+        printf("The communication graph is slower than 30 Hz tracking\n");
+        return 1;
+    }
+
+    return 0;
+}
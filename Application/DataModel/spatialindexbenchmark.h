@@ -0,0 +1,7 @@
+#ifndef SPATIALINDEXBENCHMARK_H
+#define SPATIALINDEXBENCHMARK_H
+
+int runSpatialIndexBenchmark(int frames);
+int runCommGraphBenchmark(int robots, int frames);
+
+#endif // SPATIALINDEXBENCHMARK_H
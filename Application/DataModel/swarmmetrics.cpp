@@ -0,0 +1,459 @@
+/* swarmmetrics.cpp
+ *
+ * Aggregate measures of the swarm, kept up to date at tracking rate.
+ */
+
+#include "swarmmetrics.h"
+#include "spatialindex.h"
+#include "commgraph.h"
+#include "robotdata.h"
+#include "../Core/settings.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Shortest time, in milliseconds, between two updates of the metrics
+static const qint64 METRICS_MIN_INTERVAL = 20;
+
+// Longest time, in milliseconds, that samples are kept for
+static const qint64 METRICS_HISTORY_DURATION = 300000;
+
+// Pose changes after which the running sums are recomputed, so that
+// rounding errors cannot build up
+static const int METRICS_RESUM_INTERVAL = 100000;
+
+// Largest share of the time that the metrics found through neighbours may
+// take. Large swarms update them less often than every frame to stay below it.
+static const double NEIGHBOUR_METRICS_TIME_SHARE = 0.1;
+
+// Weight of the newest measurement in the mean compute time
+static const double COMPUTE_TIME_WEIGHT = 0.1;
+
+/* Constructor
+ * No robots and no samples yet.
+ */
+SwarmMetrics::SwarmMetrics(const SpatialIndex* index, const CommGraph* commGraph)
+{
+    this->index = index;
+    this->commGraph = commGraph;
+
+    sumX = 0;
+    sumY = 0;
+    sumSquaresX = 0;
+    sumSquaresY = 0;
+    sumCosine = 0;
+    sumSine = 0;
+    changesSinceResum = 0;
+
+    changed = false;
+    lastUpdate = 0;
+    lastNeighbourUpdate = 0;
+
+    std::fill(computeTimes, computeTimes + SWARM_METRIC_COUNT, 0.0);
+}
+
+/* moved
+ * Called with each new pose of a robot. Replaces what the robot adds to the
+ * running sums, so the cost does not depend on the size of the swarm.
+ */
+void SwarmMetrics::moved(RobotData* robot, Pose pose)
+{
+    double angle = pose.orientation * M_PI / 180;
+    Contribution contribution{pose.position.x, pose.position.y, std::cos(angle), std::sin(angle), 0};
+
+    auto existing = contributions.find(robot);
+    if(existing != contributions.end())
+    {
+        add(*existing, -1);
+        contribution.slot = existing->slot;
+        *existing = contribution;
+    }
+    else
+    {
+        contribution.slot = robots.size();
+        robots.push_back(robot);
+        contributions.insert(robot, contribution);
+    }
+
+    add(contribution, 1);
+    changed = true;
+
+    if(++changesSinceResum >= METRICS_RESUM_INTERVAL)
+        resum();
+}
+
+/* remove
+ * Called when a robot is deleted. The last robot takes its slot.
+ */
+void SwarmMetrics::remove(RobotData* robot)
+{
+    auto existing = contributions.find(robot);
+    if(existing == contributions.end())
+        return;
+
+    add(*existing, -1);
+
+    int slot = existing->slot;
+    RobotData* last = robots.back();
+    robots[slot] = last;
+    robots.pop_back();
+
+    if(last != robot)
+        contributions[last].slot = slot;
+
+    contributions.remove(robot);
+    changed = true;
+}
+
+/* add
+ * Add a contribution to the running sums, or take it away with a sign of
+ * minus one.
+ */
+void SwarmMetrics::add(const Contribution& contribution, double sign)
+{
+    sumX += sign * contribution.x;
+    sumY += sign * contribution.y;
+    sumSquaresX += sign * contribution.x * contribution.x;
+    sumSquaresY += sign * contribution.y * contribution.y;
+    sumCosine += sign * contribution.cosine;
+    sumSine += sign * contribution.sine;
+}
+
+/* resum
+ * Recompute the running sums from every robot.
+ */
+void SwarmMetrics::resum(void)
+{
+    sumX = 0;
+    sumY = 0;
+    sumSquaresX = 0;
+    sumSquaresY = 0;
+    sumCosine = 0;
+    sumSine = 0;
+
+    for(const Contribution& contribution : contributions)
+        add(contribution, 1);
+
+    changesSinceResum = 0;
+}
+
+/* update
+ * Called once per tracking frame, or after poses arrive over the network.
+ * Brings every metric up to date and records a sample, unless nothing has
+ * moved or the last update was too recent. Times of both sources are on the
+ * clock of the data model, so neither holds back the other.
+ */
+void SwarmMetrics::update(qint64 time)
+{
+    if(!changed || time - lastUpdate < METRICS_MIN_INTERVAL)
+        return;
+
+    changed = false;
+    lastUpdate = time;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    int count = robots.size();
+    current.time = time;
+    current.robots = count;
+
+    // Root mean square distance from the centroid
+    if(count > 0)
+    {
+        current.centroid.x = sumX / count;
+        current.centroid.y = sumY / count;
+        double varianceX = std::max(0.0, sumSquaresX / count - current.centroid.x * current.centroid.x);
+        double varianceY = std::max(0.0, sumSquaresY / count - current.centroid.y * current.centroid.y);
+        double scaleX = index->getScaleX();
+        double scaleY = index->getScaleY();
+        current.dispersion = std::sqrt(scaleX * scaleX * varianceX + scaleY * scaleY * varianceY);
+    }
+    else
+    {
+        current.centroid = Vector2D{0, 0};
+        current.dispersion = 0;
+    }
+
+    recordTime(SWARM_METRIC_DISPERSION, timer.nsecsElapsed());
+
+    // Length of the mean heading, one when every robot faces the same way
+    timer.start();
+    current.polarisation = count > 0 ? std::sqrt(sumCosine * sumCosine + sumSine * sumSine) / count : 0;
+    recordTime(SWARM_METRIC_POLARISATION, timer.nsecsElapsed());
+
+    // The other metrics keep their last values until there is time for them
+    double neighbourTime = (computeTimes[SWARM_METRIC_NEAREST_NEIGHBOUR] + computeTimes[SWARM_METRIC_CLUSTERS] +
+                            computeTimes[SWARM_METRIC_HULL_AREA]) / 1000;
+
+    if(time - lastNeighbourUpdate >= neighbourTime / NEIGHBOUR_METRICS_TIME_SHARE)
+    {
+        lastNeighbourUpdate = time;
+
+        timer.start();
+        updateNearestNeighbours();
+        recordTime(SWARM_METRIC_NEAREST_NEIGHBOUR, timer.nsecsElapsed());
+
+        timer.start();
+        updateClusters();
+        recordTime(SWARM_METRIC_CLUSTERS, timer.nsecsElapsed());
+
+        timer.start();
+        updateHull();
+        recordTime(SWARM_METRIC_HULL_AREA, timer.nsecsElapsed());
+    }
+
+    // The graph is kept up to date by the data model
+    current.commEdges = commGraph->getEdgeCount();
+    current.commComponents = commGraph->getComponentCount();
+    current.largestComponent = commGraph->getLargestComponent();
+
+    history.push_back(current);
+    while(history.front().time < time - METRICS_HISTORY_DURATION)
+        history.pop_front();
+}
+
+/* updateNearestNeighbours
+ * Find the distance from each robot to its nearest neighbour through the
+ * spatial index, and summarise their distribution. The index also holds
+ * robots that have not been given a position, which are skipped.
+ */
+void SwarmMetrics::updateNearestNeighbours(void)
+{
+    distances.clear();
+
+    if(robots.size() > 1)
+    {
+        for(RobotData* robot : robots)
+        {
+            const Contribution& own = contributions[robot];
+
+            bool found = false;
+
+            // Usually the second robot found is the nearest, unless the first
+            // two include robots without a position
+            for(size_t count = 2; !found; count *= 4)
+            {
+                index->nearest(own.x, own.y, count, std::numeric_limits<double>::infinity(), neighbours);
+
+                for(RobotData* neighbour : neighbours)
+                {
+                    auto other = contributions.find(neighbour);
+
+                    if(neighbour != robot && other != contributions.end())
+                    {
+                        distances.push_back(std::sqrt(index->distanceSquared(other->x - own.x, other->y - own.y)));
+                        found = true;
+                        break;
+                    }
+                }
+
+                if(neighbours.size() < count)
+                    break;
+            }
+        }
+    }
+
+    if(distances.empty())
+    {
+        current.nearestMean = 0;
+        current.nearestMedian = 0;
+        current.nearest90 = 0;
+        return;
+    }
+
+    double total = 0;
+    for(double distance : distances)
+        total += distance;
+    current.nearestMean = total / distances.size();
+
+    auto median = distances.begin() + distances.size() / 2;
+    std::nth_element(distances.begin(), median, distances.end());
+    current.nearestMedian = *median;
+
+    auto ninetieth = distances.begin() + std::min(distances.size() - 1, (size_t)(0.9 * distances.size()));
+    std::nth_element(distances.begin(), ninetieth, distances.end());
+    current.nearest90 = *ninetieth;
+}
+
+/* updateClusters
+ * Count the groups of robots that are connected through chains of robots
+ * no further apart than the cluster distance. Robots are binned into cells
+ * whose diagonal is the cluster distance, so all robots in a cell are
+ * connected. Cells up to two apart are then joined if any pair of their
+ * robots is close enough, and cells that are already joined are skipped,
+ * so dense swarms need few distance checks. The cells are square in the
+ * arena, not in proportions of its sides.
+ */
+void SwarmMetrics::updateClusters(void)
+{
+    double distance = Settings::instance()->getClusterDistance();
+    double side = distance / std::sqrt(2.0);
+    double scaleX = index->getScaleX();
+    double scaleY = index->getScaleY();
+    groups.reset(robots.size());
+
+    if(robots.empty() || !(side > 0))
+    {
+        current.clusters = robots.size();
+        return;
+    }
+
+    clusterCells.clear();
+    for(const Contribution& contribution : contributions)
+    {
+        ClusterEntry entry;
+        entry.column = (int)std::floor(scaleX * contribution.x / side);
+        entry.row = (int)std::floor(scaleY * contribution.y / side);
+        entry.slot = contribution.slot;
+        clusterCells.push_back(entry);
+    }
+
+    std::sort(clusterCells.begin(), clusterCells.end(), [](const ClusterEntry& a, const ClusterEntry& b){
+        return a.column < b.column || (a.column == b.column && a.row < b.row);
+    });
+
+    // Each run of entries with the same cell becomes one group
+    cellRuns.clear();
+    for(size_t start = 0, end; start < clusterCells.size(); start = end)
+    {
+        for(end = start + 1; end < clusterCells.size() && clusterCells[end].column == clusterCells[start].column &&
+                             clusterCells[end].row == clusterCells[start].row; ++end)
+            groups.join(clusterCells[start].slot, clusterCells[end].slot);
+
+        cellRuns.insert(cellKey(clusterCells[start].column, clusterCells[start].row), qMakePair((int)start, (int)end));
+    }
+
+    double distanceSquared = distance * distance;
+
+    for(auto run = cellRuns.begin(); run != cellRuns.end(); ++run)
+    {
+        const ClusterEntry& first = clusterCells[run->first];
+
+        // Each pair of cells is looked at from one of them only
+        for(int dy = -2; dy <= 2; ++dy)
+        {
+            for(int dx = 0; dx <= 2; ++dx)
+            {
+                if(dx == 0 && dy <= 0)
+                    continue;
+
+                auto other = cellRuns.find(cellKey(first.column + dx, first.row + dy));
+                if(other == cellRuns.end() || groups.find(first.slot) == groups.find(clusterCells[other->first].slot))
+                    continue;
+
+                bool joined = false;
+                for(int a = run->first; a < run->second && !joined; ++a)
+                {
+                    const Contribution& own = contributions[robots[clusterCells[a].slot]];
+
+                    for(int b = other->first; b < other->second && !joined; ++b)
+                    {
+                        const Contribution& neighbour = contributions[robots[clusterCells[b].slot]];
+
+                        if(index->distanceSquared(neighbour.x - own.x, neighbour.y - own.y) <= distanceSquared)
+                            joined = groups.join(clusterCells[a].slot, clusterCells[b].slot);
+                    }
+                }
+            }
+        }
+    }
+
+    current.clusters = groups.getSetCount();
+}
+
+/* cellKey
+ * Key of a cell of the cluster grid.
+ */
+qint64 SwarmMetrics::cellKey(int column, int row)
+{
+    return ((qint64)column << 32) ^ (quint32)row;
+}
+
+/* updateHull
+ * Area of the convex hull of the robots, by the monotone chain algorithm.
+ * Scaling both axes scales the area, so the hull is found in proportions
+ * of the sides.
+ */
+void SwarmMetrics::updateHull(void)
+{
+    points.clear();
+    for(const Contribution& contribution : contributions)
+        points.push_back(Vector2D{contribution.x, contribution.y});
+
+    current.hullArea = 0;
+    if(points.size() < 3)
+        return;
+
+    std::sort(points.begin(), points.end(), [](const Vector2D& a, const Vector2D& b){
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+
+    auto cross = [](const Vector2D& o, const Vector2D& a, const Vector2D& b){
+        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    };
+
+    // Lower hull left to right, then upper hull right to left
+    hull.assign(2 * points.size(), Vector2D{0, 0});
+    size_t size = 0;
+
+    for(size_t i = 0; i < points.size(); ++i)
+    {
+        while(size >= 2 && cross(hull[size - 2], hull[size - 1], points[i]) <= 0)
+            --size;
+        hull[size++] = points[i];
+    }
+
+    for(size_t i = points.size() - 1, lower = size + 1; i > 0; --i)
+    {
+        while(size >= lower && cross(hull[size - 2], hull[size - 1], points[i - 1]) <= 0)
+            --size;
+        hull[size++] = points[i - 1];
+    }
+
+    // The first point closes the hull, shoelace formula over its edges
+    double area = 0;
+    for(size_t i = 0; i + 1 < size; ++i)
+        area += hull[i].x * hull[i + 1].y - hull[i + 1].x * hull[i].y;
+
+    current.hullArea = 0.5 * std::abs(area) * index->getScaleX() * index->getScaleY();
+}
+
+/* recordTime
+ * Fold the time one metric took into its mean compute time, in
+ * microseconds.
+ */
+void SwarmMetrics::recordTime(SwarmMetric metric, qint64 nanoseconds)
+{
+    double microseconds = nanoseconds / 1e3;
+
+    if(history.empty())
+        computeTimes[metric] = microseconds;
+    else
+        computeTimes[metric] += COMPUTE_TIME_WEIGHT * (microseconds - computeTimes[metric]);
+}
+
+/* getMetricName
+ * Returns the name of a metric for display.
+ */
+QString SwarmMetrics::getMetricName(SwarmMetric metric)
+{
+    switch(metric)
+    {
+    case SWARM_METRIC_DISPERSION:
+        return "Dispersion";
+    case SWARM_METRIC_NEAREST_NEIGHBOUR:
+        return "Nearest neighbour distance";
+    case SWARM_METRIC_CLUSTERS:
+        return "Clusters";
+    case SWARM_METRIC_HULL_AREA:
+        return "Convex hull area";
+    case SWARM_METRIC_POLARISATION:
+        return "Polarisation";
+    default:
+        return "";
+    }
+}
@@ -0,0 +1,140 @@
+#ifndef SWARMMETRICS_H
+#define SWARMMETRICS_H
+
+#include <QHash>
+#include <QPair>
+#include <QString>
+
+#include <deque>
+#include <vector>
+
+#include "../Core/util.h"
+#include "disjointset.h"
+
+class RobotData;
+class SpatialIndex;
+class CommGraph;
+
+enum SwarmMetric {
+    SWARM_METRIC_DISPERSION,
+    SWARM_METRIC_NEAREST_NEIGHBOUR,
+    SWARM_METRIC_CLUSTERS,
+    SWARM_METRIC_HULL_AREA,
+    SWARM_METRIC_POLARISATION,
+    SWARM_METRIC_COUNT
+};
+
+/* SwarmMetricsSample
+ * Aggregate measures of the swarm at one time. The centroid is in
+ * proportions of each side of the arena, like positions. Distances are
+ * proportions of the longer side of the arena and areas of its square, so
+ * they are not stretched on an arena that is not square.
+ */
+struct SwarmMetricsSample {
+    qint64 time = 0;
+    int robots = 0;
+
+    Vector2D centroid{0, 0};
+    double dispersion = 0;
+
+    double nearestMean = 0;
+    double nearestMedian = 0;
+    double nearest90 = 0;
+
+    int clusters = 0;
+    double hullArea = 0;
+    double polarisation = 0;
+
+    // Communication range graph, zero while it is off
+    int commEdges = 0;
+    int commComponents = 0;
+    int largestComponent = 0;
+};
+
+/* SwarmMetrics
+ * Keeps aggregate measures of the swarm up to date as robots move. The
+ * centroid, dispersion and polarisation come from running sums that each
+ * pose change adjusts in constant time. Nearest neighbour distances are
+ * found through the spatial index, clusters through a grid sized to the
+ * cluster distance, and the convex hull is rebuilt, at most once per tracking frame and only if a robot moved. The
+ * time each metric takes is measured, and is used to update the costlier
+ * ones less often for large swarms. Samples also hold the state of the
+ * communication graph, and every sample is kept for a while.
+ */
+class SwarmMetrics
+{
+public:
+    SwarmMetrics(const SpatialIndex* index, const CommGraph* commGraph);
+
+    void moved(RobotData* robot, Pose pose);
+    void remove(RobotData* robot);
+    void update(qint64 time);
+
+    const SwarmMetricsSample& getCurrent(void) const { return current; }
+    const std::deque<SwarmMetricsSample>& getHistory(void) const { return history; }
+    double getComputeTime(SwarmMetric metric) const { return computeTimes[metric]; }
+
+    static QString getMetricName(SwarmMetric metric);
+
+private:
+    // A robot in the grid used to find clusters
+    struct ClusterEntry
+    {
+        int column;
+        int row;
+        int slot;
+    };
+
+    // What a robot currently adds to the running sums
+    struct Contribution
+    {
+        double x;
+        double y;
+        double cosine;
+        double sine;
+        int slot;
+    };
+
+    void add(const Contribution& contribution, double sign);
+    void resum(void);
+
+    void updateNearestNeighbours(void);
+    void updateClusters(void);
+    void updateHull(void);
+    void recordTime(SwarmMetric metric, qint64 nanoseconds);
+
+    static qint64 cellKey(int column, int row);
+
+    const SpatialIndex* index;
+    const CommGraph* commGraph;
+
+    QHash<RobotData*, Contribution> contributions;
+    std::vector<RobotData*> robots;
+
+    double sumX;
+    double sumY;
+    double sumSquaresX;
+    double sumSquaresY;
+    double sumCosine;
+    double sumSine;
+    int changesSinceResum;
+
+    bool changed;
+    qint64 lastUpdate;
+    qint64 lastNeighbourUpdate;
+
+    SwarmMetricsSample current;
+    std::deque<SwarmMetricsSample> history;
+    double computeTimes[SWARM_METRIC_COUNT];
+
+    // Kept between updates to avoid allocating
+    std::vector<RobotData*> neighbours;
+    std::vector<double> distances;
+    std::vector<Vector2D> points;
+    std::vector<Vector2D> hull;
+    std::vector<ClusterEntry> clusterCells;
+    QHash<qint64, QPair<int, int>> cellRuns;
+    DisjointSet groups;
+};
+
+#endif // SWARMMETRICS_H
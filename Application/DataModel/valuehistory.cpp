@@ -0,0 +1,203 @@
+/* valuehistory.cpp
+ *
+ * History of the numbers received from each robot, and Largest-Triangle-
+ * Three-Buckets downsampling of it for charts.
+ */
+
+#include "valuehistory.h"
+#include "../Core/settings.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Most samples kept for one key of one robot, two hours at 18 Hz
+static const size_t MAX_SERIES_SAMPLES = 1 << 17;
+
+/* firstSampleFrom
+ * Returns the first sample of a series at or after a time.
+ */
+static ValueSeries::const_iterator firstSampleFrom(const ValueSeries& series, qint64 time)
+{
+    return std::lower_bound(series.begin(), series.end(), time,
+                            [](const ValueSample& sample, qint64 t){ return sample.time < t; });
+}
+
+/* Constructor
+ * Empty history.
+ */
+ValueHistory::ValueHistory(void)
+{
+    sampleCount = 0;
+}
+
+/* append
+ * Record a number received for a key of a robot. Samples older than the
+ * value history duration are dropped, as are the oldest once the series is
+ * over its share of the sample budget. Times must not decrease.
+ */
+void ValueHistory::append(const QString& robotId, const QString& key, qint64 time, double value)
+{
+    ValueSeries& samples = series[qMakePair(robotId, key)];
+    samples.push_back(ValueSample{time, value});
+    sampleCount++;
+
+    qint64 oldest = time - (qint64)(Settings::instance()->getValueHistoryDuration() * 1000);
+    size_t limit = getSeriesLimit();
+    trim(samples, oldest, limit);
+
+    // A new series shrinks every share, so once the budget is used up the
+    // other series are trimmed to the new share. This only happens when a
+    // series starts while the budget is full.
+    if(sampleCount > Settings::instance()->getValueHistorySamples())
+    {
+        for(ValueSeries& other : series)
+            trim(other, oldest, limit);
+    }
+}
+
+/* removeRobot
+ * Forget the history of every key of a robot.
+ */
+void ValueHistory::removeRobot(const QString& robotId)
+{
+    for(auto entry = series.begin(); entry != series.end();)
+    {
+        if(entry.key().first == robotId)
+        {
+            sampleCount -= entry.value().size();
+            entry = series.erase(entry);
+        }
+        else
+        {
+            ++entry;
+        }
+    }
+}
+
+/* getSeries
+ * Returns the samples of a key of a robot, or null if none were received.
+ */
+const ValueSeries* ValueHistory::getSeries(const QString& robotId, const QString& key) const
+{
+    auto found = series.find(qMakePair(robotId, key));
+    if(found == series.end())
+        return nullptr;
+
+    return &found.value();
+}
+
+/* getSeriesLimit
+ * Returns the most samples each series may keep, an equal share of the
+ * sample budget.
+ */
+size_t ValueHistory::getSeriesLimit(void) const
+{
+    qint64 share = Settings::instance()->getValueHistorySamples() / std::max(series.size(), 1);
+    return std::min(MAX_SERIES_SAMPLES, (size_t)std::max(share, (qint64)1));
+}
+
+/* trim
+ * Drop the samples of a series older than a time, and the oldest beyond a
+ * number of samples.
+ */
+void ValueHistory::trim(ValueSeries& samples, qint64 oldest, size_t limit)
+{
+    while(!samples.empty() && (samples.size() > limit || samples.front().time < oldest))
+    {
+        samples.pop_front();
+        sampleCount--;
+    }
+}
+
+/* downsample
+ * Reduce the samples of a series between two times, inclusive, to at most
+ * threshold samples with Largest-Triangle-Three-Buckets. The first and last
+ * samples are kept. The samples in between are split into equal buckets,
+ * and from each bucket the sample forming the largest triangle with the
+ * sample kept from the previous bucket and the mean of the next bucket is
+ * kept, which preserves peaks and the shape of the line.
+ */
+void ValueHistory::downsample(const ValueSeries& series, qint64 from, qint64 to, int threshold, std::vector<ValueSample>& result)
+{
+    result.clear();
+
+    auto begin = firstSampleFrom(series, from);
+    auto end = firstSampleFrom(series, to + 1);
+    int count = end - begin;
+
+    if(count <= threshold || threshold < 3)
+    {
+        result.assign(begin, end);
+        return;
+    }
+
+    result.reserve(threshold);
+    result.push_back(*begin);
+
+    // Times are taken relative to the window to keep their precision
+    double bucketSize = (double)(count - 2) / (threshold - 2);
+    int kept = 0;
+
+    for(int bucket = 0; bucket < threshold - 2; ++bucket)
+    {
+        int start = (int)(bucket * bucketSize) + 1;
+        int stop = (int)((bucket + 1) * bucketSize) + 1;
+
+        // Mean of the next bucket, or the last sample after the final bucket
+        int nextStart = stop;
+        int nextStop = std::min((int)((bucket + 2) * bucketSize) + 1, count);
+        double meanTime = 0;
+        double meanValue = 0;
+
+        for(int i = nextStart; i < nextStop; ++i)
+        {
+            meanTime += begin[i].time - from;
+            meanValue += begin[i].value;
+        }
+
+        if(nextStop > nextStart)
+        {
+            meanTime /= nextStop - nextStart;
+            meanValue /= nextStop - nextStart;
+        }
+        else
+        {
+            meanTime = begin[count - 1].time - from;
+            meanValue = begin[count - 1].value;
+        }
+
+        double keptTime = begin[kept].time - from;
+        double keptValue = begin[kept].value;
+        double largestArea = -1;
+        int largest = start;
+
+        for(int i = start; i < stop; ++i)
+        {
+            double area = fabs((keptTime - meanTime) * (begin[i].value - keptValue) -
+                               (keptTime - (begin[i].time - from)) * (meanValue - keptValue));
+            if(area > largestArea)
+            {
+                largestArea = area;
+                largest = i;
+            }
+        }
+
+        result.push_back(begin[largest]);
+        kept = largest;
+    }
+
+    result.push_back(begin[count - 1]);
+}
+
+/* sampleAt
+ * Returns the last sample of a series at or before a time, or null if the
+ * series starts later.
+ */
+const ValueSample* ValueHistory::sampleAt(const ValueSeries& series, qint64 time)
+{
+    auto after = firstSampleFrom(series, time + 1);
+    if(after == series.begin())
+        return nullptr;
+
+    return &*(after - 1);
+}
@@ -0,0 +1,51 @@
+#ifndef VALUEHISTORY_H
+#define VALUEHISTORY_H
+
+#include <QHash>
+#include <QPair>
+#include <QString>
+
+#include <deque>
+#include <vector>
+
+/* ValueSample
+ * A number received from a robot, with the time it arrived in milliseconds
+ * since the epoch.
+ */
+struct ValueSample {
+    qint64 time;
+    double value;
+};
+
+typedef std::deque<ValueSample> ValueSeries;
+
+/* ValueHistory
+ * Every number received for each key of each robot, in time order, kept
+ * for the value history duration so that charts can cover long windows.
+ * The samples of all series together are held within a budget, of which
+ * each series has an equal share, so memory does not grow with the fleet.
+ * Charts draw a series downsampled to their width rather than every sample.
+ */
+class ValueHistory
+{
+public:
+    ValueHistory(void);
+
+    void append(const QString& robotId, const QString& key, qint64 time, double value);
+    void removeRobot(const QString& robotId);
+
+    const ValueSeries* getSeries(const QString& robotId, const QString& key) const;
+    qint64 getSampleCount(void) const { return sampleCount; }
+
+    static void downsample(const ValueSeries& series, qint64 from, qint64 to, int threshold, std::vector<ValueSample>& result);
+    static const ValueSample* sampleAt(const ValueSeries& series, qint64 time);
+
+private:
+    size_t getSeriesLimit(void) const;
+    void trim(ValueSeries& samples, qint64 oldest, size_t limit);
+
+    QHash<QPair<QString, QString>, ValueSeries> series;
+    qint64 sampleCount;
+};
+
+#endif // VALUEHISTORY_H
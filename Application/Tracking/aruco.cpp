@@ -1,56 +1,266 @@
 #include "aruco.h"
 #include "Application/Core/util.h"
+#include "Application/Core/settings.h"
+#include "Application/Core/latencymonitor.h"
 #include <QtMath>
 
+#include <algorithm>
 #include <iostream>
 
-ArUco::ArUco(std::map<int, QString>* idMapping, ARCameraThread* cameraThread)
+// A full detection is forced after this many gated frames, so that slow
+// movement below the motion threshold cannot leave stale poses behind
+static const int FULL_DETECTION_INTERVAL = 30;
+
+// Smallest margin, in pixels, that changed regions are grown by
+static const int MIN_REGION_MARGIN = 32;
+
+ArUco::ArUco(const MarkerTable* markerTable, ARCameraThread* cameraThread, const CameraCalibration* calibration, int cameraIndex)
 {
-    possibleTags = cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_50);
+    possibleTags = cv::aruco::getPredefinedDictionary(Settings::instance()->getMarkerDictionary());
     detectorParameters = cv::aruco::DetectorParameters::create();
-    arucoToStringIdMapping = idMapping;
+    this->markerTable = markerTable;
+    framesSinceFullDetection = 0;
+    poseFilter.resize(possibleTags->bytesList.rows);
     this->cameraThread = cameraThread;
-    connect(cameraThread, SIGNAL(newVideoFrame(cv::Mat&)), this, SLOT(newImageReceived(cv::Mat&)));
+    this->calibration = calibration;
+    this->cameraIndex = cameraIndex;
+    connect(cameraThread, SIGNAL(newVideoFrame(cv::Mat&, FrameInfo)), this, SLOT(newImageReceived(cv::Mat&, FrameInfo)));
 }
 
-void ArUco::newImageReceived(cv::Mat& image)
+/* largestTagSide
+ * Returns the longest side of any of the given tags in pixels.
+ */
+static int largestTagSide(const std::vector<std::vector<cv::Point2f>>& tags)
+{
+    double side = MIN_REGION_MARGIN;
+
+    for(auto& tag : tags)
+        for(size_t i = 0; i < tag.size(); ++i)
+            side = std::max(side, cv::norm(tag[i] - tag[(i + 1) % tag.size()]));
+
+    return std::ceil(side);
+}
+
+/* tagPerimeter
+ * Returns the length in pixels of the outline of a tag.
+ */
+static double tagPerimeter(const std::vector<cv::Point2f>& tag)
+{
+    double perimeter = 0;
+
+    for(size_t i = 0; i < tag.size(); ++i)
+        perimeter += cv::norm(tag[i] - tag[(i + 1) % tag.size()]);
+
+    return perimeter;
+}
+
+/* removeDuplicateIds
+ * Keep one detection of each marker id, the one seen largest, as its
+ * corners are the most precise. Otherwise a marker seen twice in a frame,
+ * such as a spare marker or a reflection, would update the same pose filter
+ * slot twice.
+ */
+static void removeDuplicateIds(std::vector<int>& ids, std::vector<std::vector<cv::Point2f>>& tags)
+{
+    std::vector<size_t> order(ids.size());
+    for(size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b){ return ids[a] < ids[b]; });
+
+    auto duplicate = std::adjacent_find(order.begin(), order.end(), [&](size_t a, size_t b){ return ids[a] == ids[b]; });
+    if(duplicate == order.end())
+        return;
+
+    std::vector<int> keptIds;
+    std::vector<std::vector<cv::Point2f>> keptTags;
+
+    for(size_t first = 0; first < order.size(); )
+    {
+        size_t best = order[first];
+        double bestPerimeter = tagPerimeter(tags[best]);
+        size_t next = first + 1;
+
+        for(; next < order.size() && ids[order[next]] == ids[best]; ++next)
+        {
+            double perimeter = tagPerimeter(tags[order[next]]);
+            if(perimeter > bestPerimeter)
+            {
+                best = order[next];
+                bestPerimeter = perimeter;
+            }
+        }
+
+        keptIds.push_back(ids[best]);
+        keptTags.push_back(tags[best]);
+        first = next;
+    }
+
+    ids.swap(keptIds);
+    tags.swap(keptTags);
+}
+
+/* detect
+ * Run the marker detector over an image or an image region.
+ */
+void ArUco::detect(const cv::Mat& image, std::vector<int>& ids, std::vector<std::vector<cv::Point2f>>& tags)
+{
+    ids.clear();
+    tags.clear();
+    cv::aruco::detectMarkers(image, possibleTags, tags, ids, detectorParameters, cv::noArray());
+}
+
+/* detectInChangedRegions
+ * Keep previous detections that lie outside every changed region and search
+ * only the changed regions for markers.
+ */
+void ArUco::detectInChangedRegions(const cv::Mat& image, const std::vector<cv::Rect>& regions)
 {
     std::vector<int> ids;
-    std::vector<std::vector<cv::Point2f>> detectedTags, junk;
+    std::vector<std::vector<cv::Point2f>> tags;
+
+    for(unsigned int i = 0; i < previousIds.size(); ++i)
+    {
+        cv::Rect bounds = cv::boundingRect(previousTags[i]);
+        bool changed = std::any_of(regions.begin(), regions.end(), [&](const cv::Rect& r){ return (r & bounds).area() > 0; });
+
+        if(!changed)
+        {
+            ids.push_back(previousIds[i]);
+            tags.push_back(previousTags[i]);
+        }
+    }
+
+    std::vector<int> regionIds;
+    std::vector<std::vector<cv::Point2f>> regionTags;
+
+    for(auto& region : regions)
+    {
+        detect(image(region), regionIds, regionTags);
+
+        cv::Point2f offset = region.tl();
+        for(unsigned int i = 0; i < regionIds.size(); ++i)
+        {
+            if(std::find(ids.begin(), ids.end(), regionIds[i]) != ids.end())
+                continue;
+
+            for(auto& corner : regionTags[i])
+                corner += offset;
+
+            ids.push_back(regionIds[i]);
+            tags.push_back(regionTags[i]);
+        }
+    }
+
+    previousIds.swap(ids);
+    previousTags.swap(tags);
+}
+
+void ArUco::newImageReceived(cv::Mat& image, FrameInfo info)
+{
+    bool fullDetection = true;
+    std::vector<cv::Rect> changedRegions;
 
-    cv::aruco::detectMarkers(image, possibleTags, detectedTags, ids, detectorParameters, junk);
+    if(Settings::instance()->isMotionGatingEnabled())
+    {
+        // Regions are grown by the largest marker seen so a marker on a region edge is searched whole
+        bool widespreadChange = motionGate.update(image, largestTagSide(previousTags), changedRegions);
+        fullDetection = widespreadChange || framesSinceFullDetection >= FULL_DETECTION_INTERVAL;
+    }
+
+    if(fullDetection)
+    {
+        detect(image, previousIds, previousTags);
+        framesSinceFullDetection = 0;
+    }
+    else
+    {
+        // With no changed regions the previous detections are reused as they are
+        if(!changedRegions.empty())
+            detectInChangedRegions(image, changedRegions);
+
+        framesSinceFullDetection++;
+    }
 
+    removeDuplicateIds(previousIds, previousTags);
+
+    // Gather the corners of every tag so they can be transformed together
+    std::vector<cv::Point2f> corners;
+
+    for(auto& tag : previousTags)
+        corners.insert(corners.end(), tag.begin(), tag.end());
+
+    // Positions are reported as proportions of the arena, which is the image
+    // itself unless the camera is calibrated
     double width = image.cols;
     double height = image.rows;
 
-    for(unsigned int i = 0; i < ids.size(); ++i)
+    if(calibration && calibration->isValid())
     {
-        int id = ids[i];
-        if(arucoToStringIdMapping->find(id) == arucoToStringIdMapping->end())
-            continue;
+        calibration->toArena(corners, corners, image.size());
+        width = calibration->getArenaSize().x;
+        height = calibration->getArenaSize().y;
+    }
 
-        QString idString = (*arucoToStringIdMapping)[id];
-        auto tag = detectedTags[i];
+    std::vector<Pose> measurements;
 
-        cv::Point2f tagCentre = {0, 0};
-        for(auto& corner : tag)
-            tagCentre += corner * (1.0 / tag.size());
+    for(unsigned int i = 0; i < previousIds.size(); ++i)
+    {
+        const cv::Point2f* tag = &corners[4 * i];
 
+        cv::Point2f tagCentre = 0.25 * (tag[0] + tag[1] + tag[2] + tag[3]);
         cv::Point2f frontOfTag = 0.5 * (tag[0] + tag[1]);
         double orientation = qRadiansToDegrees(std::atan2(frontOfTag.y - tagCentre.y, frontOfTag.x - tagCentre.x));
 
-        tagCentre.x /= width;
-        tagCentre.y /= height;
-
         Pose p;
         p.orientation = orientation;
-        p.position.x = tagCentre.x;
-        p.position.y = tagCentre.y;
+        p.position.x = tagCentre.x / width;
+        p.position.y = tagCentre.y / height;
+
+        measurements.push_back(p);
+    }
 
-        emit newRobotPosition(idString, p);
+    FrameResult frame;
+    frame.camera = cameraIndex;
+    frame.frameId = info.id;
+    frame.captureTime = info.captureTime;
+    frame.captureTick = info.captureTick;
+    frame.arenaSize = Vector2D{width, height};
+    frame.results.reserve(markerTable->mappedCount());
+
+    if(Settings::instance()->isPoseFilterEnabled())
+    {
+        // The filter tracks every marker id, so robots keep moving through short dropouts
+        poseFilter.setCoastTime(Settings::instance()->getPoseCoastTime());
+        poseFilter.update(info.captureTime / 1000.0, previousIds, measurements);
+
+        for(int id = 0; id < poseFilter.size(); ++id)
+        {
+            if(!poseFilter.isActive(id))
+                continue;
+
+            const QString* robot = markerTable->robotFor(id);
+            if(robot != nullptr)
+                frame.results.push_back(TrackResult{*robot, poseFilter.getPose(id), poseFilter.getConfidence(id)});
+        }
     }
+    else
+    {
+        for(unsigned int i = 0; i < previousIds.size(); ++i)
+        {
+            const QString* robot = markerTable->robotFor(previousIds[i]);
+            if(robot != nullptr)
+                frame.results.push_back(TrackResult{*robot, measurements[i], 1.0});
+        }
+    }
+
+    frame.detectedTick = LatencyMonitor::now();
+    LatencyMonitor::instance()->record(LATENCY_DETECTION, frame.detectedTick - frame.captureTick);
+
+    // One signal per frame, so the model applies all poses together
+    emit newTrackingFrame(frame);
 
     cameraThread->addPreEmitCall([&](){
-        connect(cameraThread, SIGNAL(newVideoFrame(cv::Mat&)), this, SLOT(newImageReceived(cv::Mat&)));
+        connect(cameraThread, SIGNAL(newVideoFrame(cv::Mat&, FrameInfo)), this, SLOT(newImageReceived(cv::Mat&, FrameInfo)));
     });
 }
@@ -2,7 +2,6 @@
 #define ARUCO_H
 
 #include <opencv2/aruco.hpp>
-#include <map>
 #include <vector>
 
 #include <QString>
@@ -10,25 +9,42 @@
 
 #include "Application/Core/util.h"
 #include "Application/Tracking/camerathread.h"
+#include "Application/Tracking/motiongate.h"
+#include "Application/Tracking/cameracalibration.h"
+#include "Application/Tracking/posefilter.h"
+#include "Application/Tracking/markertable.h"
 
 class ArUco : public QObject
 {
     Q_OBJECT
 
 public:
-    ArUco(std::map<int, QString>* idMapping, ARCameraThread* cameraThread);
+    ArUco(const MarkerTable* markerTable, ARCameraThread* cameraThread, const CameraCalibration* calibration = nullptr, int cameraIndex = 0);
 
 public slots:
-    void newImageReceived(cv::Mat& image);
+    void newImageReceived(cv::Mat& image, FrameInfo info);
 
 signals:
-    void newRobotPosition(QString id, Pose pose);
+    void newTrackingFrame(FrameResult frame);
 
 private:
+    void detect(const cv::Mat& image, std::vector<int>& ids, std::vector<std::vector<cv::Point2f>>& tags);
+    void detectInChangedRegions(const cv::Mat& image, const std::vector<cv::Rect>& regions);
+
     cv::Ptr<cv::aruco::Dictionary> possibleTags;
     cv::Ptr<cv::aruco::DetectorParameters> detectorParameters;
-    std::map<int, QString>* arucoToStringIdMapping;
+    const MarkerTable* markerTable;
     ARCameraThread* cameraThread;
+    const CameraCalibration* calibration;
+    int cameraIndex;
+
+    MotionGate motionGate;
+    PoseFilter poseFilter;
+    int framesSinceFullDetection;
+
+    // Detections from the previous frame, reused where nothing has moved
+    std::vector<int> previousIds;
+    std::vector<std::vector<cv::Point2f>> previousTags;
 };
 
 #endif // ARUCO_H
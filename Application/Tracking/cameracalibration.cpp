@@ -0,0 +1,179 @@
+/* cameracalibration.cpp
+ *
+ * Maps detected marker corners from raw camera pixels to metric arena
+ * coordinates, and warps camera frames into the arena view for display.
+ */
+
+#include "cameracalibration.h"
+#include "Application/Core/log.h"
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+
+/* Constructor
+ * An uncalibrated camera maps nothing.
+ */
+CameraCalibration::CameraCalibration(void) {
+    valid = false;
+    arenaSize.x = 1.0;
+    arenaSize.y = 1.0;
+}
+
+/* load
+ * Read a calibration written with cv::FileStorage. The file holds
+ * camera_matrix, distortion_coefficients, image_width and image_height as
+ * produced by a standard OpenCV calibration, the arena_width and
+ * arena_height in metres, and either a homography from undistorted pixels to
+ * arena metres or at least four image_points with matching arena_points.
+ */
+bool CameraCalibration::load(QString file) {
+    valid = false;
+
+    cv::FileStorage storage;
+    cv::Mat imagePoints, arenaPoints;
+    int width = 0, height = 0;
+    double arenaWidth = 0, arenaHeight = 0;
+
+    try {
+        if (!storage.open(file.toStdString(), cv::FileStorage::READ)) {
+            return false;
+        }
+
+        storage["camera_matrix"] >> cameraMatrix;
+        storage["distortion_coefficients"] >> distortion;
+        storage["image_width"] >> width;
+        storage["image_height"] >> height;
+        storage["arena_width"] >> arenaWidth;
+        storage["arena_height"] >> arenaHeight;
+        storage["homography"] >> homography;
+        storage["image_points"] >> imagePoints;
+        storage["arena_points"] >> arenaPoints;
+    } catch (cv::Exception& e) {
+        Log::instance()->logMessage("Could not read camera calibration " + file + ": " + QString::fromStdString(e.msg), true);
+        return false;
+    }
+
+    if (cameraMatrix.rows != 3 || cameraMatrix.cols != 3 || width <= 0 || height <= 0 || arenaWidth <= 0 || arenaHeight <= 0) {
+        Log::instance()->logMessage("Camera calibration " + file + " is incomplete", true);
+        return false;
+    }
+
+    cameraMatrix.convertTo(cameraMatrix, CV_64F);
+
+    if (distortion.empty()) {
+        distortion = cv::Mat::zeros(1, 5, CV_64F);
+    }
+
+    // Correspondences are measured on the raw image, so undistort them before fitting
+    if (homography.empty() && imagePoints.rows >= 4 && imagePoints.rows == arenaPoints.rows) {
+        std::vector<cv::Point2f> image, undistorted, arena;
+        imagePoints.convertTo(imagePoints, CV_32F);
+        arenaPoints.convertTo(arenaPoints, CV_32F);
+        imagePoints.reshape(2, imagePoints.rows).copyTo(image);
+        arenaPoints.reshape(2, arenaPoints.rows).copyTo(arena);
+
+        cv::undistortPoints(image, undistorted, cameraMatrix, distortion, cv::noArray(), cameraMatrix);
+        homography = cv::findHomography(undistorted, arena);
+    }
+
+    if (homography.rows != 3 || homography.cols != 3) {
+        Log::instance()->logMessage("Camera calibration " + file + " has no arena homography", true);
+        return false;
+    }
+
+    homography.convertTo(homography, CV_64F);
+    calibratedSize = cv::Size{width, height};
+    arenaSize.x = arenaWidth;
+    arenaSize.y = arenaHeight;
+    remapOutputSize = cv::Size{};
+    valid = true;
+
+    return true;
+}
+
+/* toArena
+ * Convert raw image pixels of a frame of the given size to arena metres.
+ */
+void CameraCalibration::toArena(const std::vector<cv::Point2f>& pixels, std::vector<cv::Point2f>& arena, cv::Size imageSize) const {
+    if (pixels.empty()) {
+        arena.clear();
+        return;
+    }
+
+    // The calibration may have been made at a different resolution
+    float scaleX = (1.0f * calibratedSize.width) / imageSize.width;
+    float scaleY = (1.0f * calibratedSize.height) / imageSize.height;
+
+    std::vector<cv::Point2f> scaled(pixels.size());
+    for (size_t i = 0; i < pixels.size(); i++) {
+        scaled[i] = cv::Point2f{pixels[i].x * scaleX, pixels[i].y * scaleY};
+    }
+
+    std::vector<cv::Point2f> undistorted;
+    cv::undistortPoints(scaled, undistorted, cameraMatrix, distortion, cv::noArray(), cameraMatrix);
+    cv::perspectiveTransform(undistorted, arena, homography);
+}
+
+/* buildRemap
+ * Build the lookup tables from each pixel of the arena view back to the raw
+ * camera image, by applying the inverse homography and then the lens model.
+ */
+void CameraCalibration::buildRemap(cv::Size imageSize, cv::Size outputSize, cv::Rect2d region) {
+    std::vector<cv::Point2f> arena;
+    arena.reserve(outputSize.area());
+
+    for (int v = 0; v < outputSize.height; v++) {
+        for (int u = 0; u < outputSize.width; u++) {
+            arena.push_back(cv::Point2f((region.x + u * region.width / outputSize.width) * arenaSize.x,
+                                        (region.y + v * region.height / outputSize.height) * arenaSize.y));
+        }
+    }
+
+    std::vector<cv::Point2f> undistorted;
+    cv::perspectiveTransform(arena, undistorted, homography.inv());
+
+    // Turn the undistorted pixels into camera rays, then project them through the lens model
+    double fx = cameraMatrix.at<double>(0, 0);
+    double fy = cameraMatrix.at<double>(1, 1);
+    double cx = cameraMatrix.at<double>(0, 2);
+    double cy = cameraMatrix.at<double>(1, 2);
+
+    std::vector<cv::Point3f> rays(undistorted.size());
+    for (size_t i = 0; i < undistorted.size(); i++) {
+        rays[i] = cv::Point3f((undistorted[i].x - cx) / fx, (undistorted[i].y - cy) / fy, 1.0f);
+    }
+
+    std::vector<cv::Point2f> raw;
+    cv::projectPoints(rays, cv::Vec3d{0, 0, 0}, cv::Vec3d{0, 0, 0}, cameraMatrix, distortion, raw);
+
+    float scaleX = (1.0f * imageSize.width) / calibratedSize.width;
+    float scaleY = (1.0f * imageSize.height) / calibratedSize.height;
+
+    cv::Mat map(outputSize, CV_32FC2);
+    for (int v = 0; v < outputSize.height; v++) {
+        cv::Point2f* row = map.ptr<cv::Point2f>(v);
+        for (int u = 0; u < outputSize.width; u++) {
+            const cv::Point2f& p = raw[v * outputSize.width + u];
+            row[u] = cv::Point2f{p.x * scaleX, p.y * scaleY};
+        }
+    }
+
+    cv::convertMaps(map, cv::noArray(), mapXY, mapInterpolation, CV_16SC2);
+
+    remapImageSize = imageSize;
+    remapOutputSize = outputSize;
+    remapRegion = region;
+}
+
+/* warpToArena
+ * Warp a raw camera frame into the arena view at the given size. Region is
+ * the part of the arena to show, as proportions of its size. The lookup
+ * tables are only rebuilt when the frame size, output size or region changes.
+ */
+void CameraCalibration::warpToArena(const cv::Mat& image, cv::Mat& arenaImage, cv::Size outputSize, cv::Rect2d region) {
+    if (image.size() != remapImageSize || outputSize != remapOutputSize || region != remapRegion) {
+        buildRemap(image.size(), outputSize, region);
+    }
+
+    cv::remap(image, arenaImage, mapXY, mapInterpolation, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar::all(200));
+}
@@ -0,0 +1,49 @@
+#ifndef CAMERACALIBRATION_H
+#define CAMERACALIBRATION_H
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+#include <QString>
+
+#include "Application/Core/util.h"
+
+/* CameraCalibration
+ * Lens distortion of a camera and the homography from its undistorted image
+ * to metric arena coordinates. Only detected points are undistorted, so the
+ * per-frame cost is a few point transforms. Lookup tables for warping whole
+ * frames into the arena view are built once per output size for display.
+ */
+class CameraCalibration
+{
+public:
+    CameraCalibration(void);
+
+    bool load(QString file);
+    bool isValid(void) const { return valid; }
+
+    Vector2D getArenaSize(void) const { return arenaSize; }
+
+    void toArena(const std::vector<cv::Point2f>& pixels, std::vector<cv::Point2f>& arena, cv::Size imageSize) const;
+    void warpToArena(const cv::Mat& image, cv::Mat& arenaImage, cv::Size outputSize, cv::Rect2d region = cv::Rect2d{0, 0, 1, 1});
+
+private:
+    void buildRemap(cv::Size imageSize, cv::Size outputSize, cv::Rect2d region);
+
+    bool valid;
+
+    cv::Size calibratedSize;
+    cv::Mat cameraMatrix;
+    cv::Mat distortion;
+    cv::Mat homography;
+    Vector2D arenaSize;
+
+    // Cached arena view lookup tables and the sizes they were built for
+    cv::Mat mapXY;
+    cv::Mat mapInterpolation;
+    cv::Size remapImageSize;
+    cv::Size remapOutputSize;
+    cv::Rect2d remapRegion;
+};
+
+#endif // CAMERACALIBRATION_H
@@ -0,0 +1,145 @@
+/* camerarig.cpp
+ *
+ * Creates the cameras that cover the arena, their calibrations and their
+ * detection workers, and merges the tracking results of all cameras.
+ */
+
+#include "camerarig.h"
+#include "Application/Core/log.h"
+
+#include "usbcamerathread.h"
+#include "syntheticcamerathread.h"
+#include "videofilecamerathread.h"
+#ifdef CVB_CAMERA_PRESENT
+#include "cvbcamerathread.h"
+#endif
+
+#include <QFile>
+
+/* Constructor
+ * Create every camera with its calibration and detection worker. Nothing is
+ * captured until start is called.
+ */
+CameraRig::CameraRig(const MarkerTable* markerTable, std::vector<CameraConfig> configs)
+{
+    bool arenaSizeSet = false;
+
+    for(unsigned int i = 0; i < configs.size(); ++i)
+    {
+        const CameraConfig& config = configs[i];
+        QString name = "camera " + QString::number(i);
+
+        RigCamera c;
+        c.camera = createCamera(config, markerTable);
+        c.calibration = new CameraCalibration;
+
+        if(QFile::exists(config.calibrationFile) && c.calibration->load(config.calibrationFile))
+        {
+            Vector2D arenaSize = c.calibration->getArenaSize();
+
+            // Every camera reports proportions of its own arena size, so they must agree
+            if(!arenaSizeSet)
+            {
+                Settings::instance()->setArenaSize(arenaSize);
+                arenaSizeSet = true;
+            }
+            else if(arenaSize.x != Settings::instance()->getArenaSize().x || arenaSize.y != Settings::instance()->getArenaSize().y)
+            {
+                Log::instance()->logMessage("The arena size of " + name + " does not match the first calibrated camera", true);
+            }
+
+            Log::instance()->logMessage("Loaded camera calibration for " + name + " from " + config.calibrationFile, true);
+        }
+        else if(configs.size() > 1)
+        {
+            Log::instance()->logMessage("No calibration for " + name + ", its poses will not line up with the other cameras", true);
+        }
+
+        c.tracker = new ArUco{markerTable, c.camera, c.calibration, (int)i};
+        c.trackerThread = new QThread;
+        c.tracker->moveToThread(c.trackerThread);
+
+        connect(c.tracker, SIGNAL(newTrackingFrame(FrameResult)), &merger, SLOT(newCameraFrame(FrameResult)));
+
+        cameras.push_back(c);
+    }
+
+    connect(&merger, SIGNAL(newTrackingFrame(FrameResult)), this, SIGNAL(newTrackingFrame(FrameResult)));
+}
+
+/* Destructor
+ * Stop every thread and release the cameras.
+ */
+CameraRig::~CameraRig()
+{
+    stop();
+
+    for(auto& c : cameras)
+    {
+        delete c.tracker;
+        delete c.trackerThread;
+        delete c.camera;
+        delete c.calibration;
+    }
+}
+
+/* start
+ * Start the detection workers, then the cameras that feed them.
+ */
+void CameraRig::start(void)
+{
+    for(auto& c : cameras)
+        c.trackerThread->start();
+
+    for(auto& c : cameras)
+        c.camera->start();
+}
+
+/* stop
+ * Stop the cameras, then the detection workers once they have no more
+ * frames to process.
+ */
+void CameraRig::stop(void)
+{
+    for(auto& c : cameras)
+        c.camera->quit();
+
+    for(auto& c : cameras)
+    {
+        c.camera->wait();
+        c.trackerThread->quit();
+        c.trackerThread->wait();
+    }
+}
+
+/* createCamera
+ * Create the camera thread for one camera. The argument selects the device
+ * of a USB camera, the file of a video source and the seed of a synthetic
+ * scene.
+ */
+ARCameraThread* CameraRig::createCamera(const CameraConfig& config, const MarkerTable* markerTable)
+{
+    if(config.source == CAMERA_SOURCE_SYNTHETIC)
+    {
+        SyntheticSceneConfig scene = Settings::instance()->getSyntheticSceneConfig();
+        if(!config.argument.isEmpty())
+            scene.seed = config.argument.toUInt();
+
+        return new SyntheticCameraThread{scene, markerTable};
+    }
+
+    if(config.source == CAMERA_SOURCE_VIDEO_FILE)
+    {
+        VideoFileConfig video = Settings::instance()->getVideoFileConfig();
+        if(!config.argument.isEmpty())
+            video.file = config.argument;
+
+        return new VideoFileCameraThread{video};
+    }
+
+#ifdef CVB_CAMERA_PRESENT
+    return new CVBCameraThread;
+#else
+    return new USBCameraThread{config.argument.toInt()};
+#endif
+}
@@ -0,0 +1,55 @@
+#ifndef CAMERARIG_H
+#define CAMERARIG_H
+
+#include <vector>
+
+#include <QObject>
+#include <QThread>
+
+#include "Application/Core/settings.h"
+#include "Application/Tracking/camerathread.h"
+#include "Application/Tracking/cameracalibration.h"
+#include "Application/Tracking/markertable.h"
+#include "Application/Tracking/aruco.h"
+#include "Application/Tracking/detectionmerger.h"
+
+/* CameraRig
+ * The cameras that cover the arena. Every camera has its own calibration into
+ * the shared arena frame and its own ArUco worker on a separate thread, so
+ * detection never runs on the GUI thread. The tracking frames of all cameras
+ * are merged into a single stream of robot poses.
+ */
+class CameraRig : public QObject
+{
+    Q_OBJECT
+
+public:
+    CameraRig(const MarkerTable* markerTable, std::vector<CameraConfig> configs);
+    ~CameraRig();
+
+    void start(void);
+    void stop(void);
+
+    int getCameraCount(void) const { return cameras.size(); }
+    ARCameraThread* getCamera(int index) const { return cameras[index].camera; }
+    CameraCalibration* getCalibration(int index) const { return cameras[index].calibration; }
+
+signals:
+    void newTrackingFrame(FrameResult frame);
+
+private:
+    struct RigCamera
+    {
+        ARCameraThread* camera;
+        CameraCalibration* calibration;
+        ArUco* tracker;
+        QThread* trackerThread;
+    };
+
+    static ARCameraThread* createCamera(const CameraConfig& config, const MarkerTable* markerTable);
+
+    std::vector<RigCamera> cameras;
+    DetectionMerger merger;
+};
+
+#endif // CAMERARIG_H
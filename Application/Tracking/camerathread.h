@@ -2,12 +2,30 @@
 #define CAMERATHREAD_H
 
 #include <opencv2/videoio.hpp>
+#include <opencv2/imgproc.hpp>
 
 #include <QThread>
+#include <QDateTime>
 #include <functional>
 #include <QMutex>
 #include <QMutexLocker>
 
+#include "Application/Core/latencymonitor.h"
+#include "Application/Core/settings.h"
+
+/* FrameInfo
+ * Identifies a frame emitted by a camera thread. Ids increase by one with
+ * every captured frame, except for file sources where the id is the position
+ * of the frame in the file. The capture tick is read from the monotonic
+ * latency clock and is only used to measure delays.
+ */
+struct FrameInfo
+{
+    quint64 id = 0;
+    qint64 captureTime = 0;
+    qint64 captureTick = 0;
+};
+
 class ARCameraThread : public QThread
 {
     Q_OBJECT
@@ -26,7 +44,7 @@ public slots:
     virtual void quit() { this->blockSignals(true); shouldRun = false; }
 
 signals:
-    void newVideoFrame(cv::Mat& image);
+    void newVideoFrame(cv::Mat& image, FrameInfo info);
 
 protected:
     void executePreEmitCalls()
@@ -36,13 +54,62 @@ protected:
             f();
         preEmitCalls.clear();
     }
+
+    // Called as soon as a frame has been captured
+    FrameInfo stampFrame()
+    {
+        FrameInfo info;
+        info.id = ++frameCount;
+        info.captureTime = QDateTime::currentMSecsSinceEpoch();
+        info.captureTick = LatencyMonitor::now();
+        return info;
+    }
+
+    // Used by sources that number frames themselves
+    FrameInfo stampFrame(quint64 id)
+    {
+        frameCount = id - 1;
+        return stampFrame();
+    }
+
+    // Reconnect the consumers that are ready, emit the frame to them and disconnect them again.
+    // In grayscale capture mode a colour frame is reduced to its luma plane here, once for all consumers
+    void publishFrame(cv::Mat& image, FrameInfo info)
+    {
+        if(image.channels() == 3 && Settings::instance()->isGrayscaleCaptureEnabled())
+            cv::cvtColor(image, image, cv::COLOR_BGR2GRAY);
+
+        executePreEmitCalls();
+        lastConsumerCount = receivers(SIGNAL(newVideoFrame(cv::Mat&, FrameInfo)));
+        emit newVideoFrame(image, info);
+        disconnect(this, SIGNAL(newVideoFrame(cv::Mat&, FrameInfo)), nullptr, 0);
+    }
+
+    // Block until every consumer of the previous frame is ready for the next one,
+    // so that no frame is dropped while a consumer is busy
+    void waitForConsumers()
+    {
+        while(shouldRun)
+        {
+            {
+                QMutexLocker lock{&emitCallMutex};
+                if((int)preEmitCalls.size() >= lastConsumerCount)
+                    return;
+            }
+            usleep(100);
+        }
+    }
+
     volatile bool shouldRun = true;
 
 private:
     std::vector<std::function<void()>> preEmitCalls;
     QMutex emitCallMutex;
+    quint64 frameCount = 0;
+    int lastConsumerCount = 0;
 };
 
 Q_DECLARE_METATYPE(cv::Mat)
+Q_DECLARE_METATYPE(FrameInfo)
 
 #endif // CAMERATHREAD_H
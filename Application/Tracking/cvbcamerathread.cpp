@@ -17,9 +17,11 @@ static const size_t DRIVERPATHSIZE = 256;
 
 /* cvb_to_ocv_nocopy
  * Taen from original tracking code. Gets the image from the CVB camera
- * and converts it to an opencv image.
+ * and converts it to an opencv image. If only luma is wanted, a monochrome
+ * image is returned without conversion and a colour one is reduced to luma
+ * directly instead of being reordered first.
  */
-Mat cvb_to_ocv_nocopy(IMG cvbImg)
+Mat cvb_to_ocv_nocopy(IMG cvbImg, bool luma)
 {
     // Construct an appropriate OpenCV image
     Size size(ImageWidth(cvbImg), ImageHeight(cvbImg));
@@ -27,10 +29,24 @@ Mat cvb_to_ocv_nocopy(IMG cvbImg)
     intptr_t xInc = 0;
     intptr_t yInc = 0;
     GetLinearAccess(cvbImg, 0, &ppixels, &xInc, &yInc);
-    Mat image(size, CV_8UC3, ppixels, yInc);
     Mat ret;
 
-    cv::cvtColor(image, ret, CV_BGR2RGB);
+    if(ImageDimension(cvbImg) == 1)
+    {
+        Mat image(size, CV_8UC1, ppixels, yInc);
+        if(luma)
+            return image;
+
+        cv::cvtColor(image, ret, CV_GRAY2BGR);
+        return ret;
+    }
+
+    Mat image(size, CV_8UC3, ppixels, yInc);
+
+    if(luma)
+        cv::cvtColor(image, ret, CV_RGB2GRAY);
+    else
+        cv::cvtColor(image, ret, CV_BGR2RGB);
 
     return ret;
 }
@@ -76,16 +92,17 @@ void CVBCameraThread::run()
         if(camResult < 0) {
             cout << setw(3) << "Error with G2Wait: " << CVC_ERROR_FROM_HRES(camResult) << endl;
         } else {
+            FrameInfo info = stampFrame();
+
             // Create an attached OpenCV image
-            Mat originalImage = cvb_to_ocv_nocopy(hCamera);
-            originalImage.convertTo(originalImage, -1, 2, 0);
+            // A monochrome image still refers to the ring buffer, so the
+            // brightness scaling must write to a separate image
+            Mat cameraImage = cvb_to_ocv_nocopy(hCamera, Settings::instance()->isGrayscaleCaptureEnabled());
+            Mat originalImage;
+            cameraImage.convertTo(originalImage, -1, 2, 0);
 
             if(shouldRun)
-            {
-                executePreEmitCalls();
-                emit newVideoFrame(originalImage);
-                disconnect(this, SIGNAL(newVideoFrame(cv::Mat&)), nullptr, 0);
-            }
+                publishFrame(originalImage, info);
         }
     }
 
@@ -17,9 +17,6 @@ public:
     CVBCameraThread();
     virtual void run() override;
 
-signals:
-    void newVideoFrame(cv::Mat& image);
-
 private:
     IMG hCamera = NULL;
 };
@@ -0,0 +1,64 @@
+/* detectionmerger.cpp
+ *
+ * De-duplicates robots seen by more than one camera.
+ */
+
+#include "detectionmerger.h"
+
+// Time after which a robot may be taken over by any camera that sees it
+static const qint64 DEFAULT_OWNERSHIP_TIMEOUT = 200;
+
+DetectionMerger::DetectionMerger(QObject* parent) : QObject(parent)
+{
+    ownershipTimeout = DEFAULT_OWNERSHIP_TIMEOUT;
+}
+
+/* setOwnershipTimeout
+ * Sets how long, in milliseconds, a camera keeps a robot it has stopped
+ * reporting before another camera may take it over at any quality.
+ */
+void DetectionMerger::setOwnershipTimeout(qint64 milliseconds)
+{
+    ownershipTimeout = milliseconds;
+}
+
+/* newCameraFrame
+ * Slot. Called with the tracking frame of one camera. Passes on the poses of
+ * the robots that this camera owns, or now takes over.
+ */
+void DetectionMerger::newCameraFrame(FrameResult frame)
+{
+    FrameResult merged;
+    merged.camera = frame.camera;
+    merged.frameId = frame.frameId;
+    merged.captureTime = frame.captureTime;
+    merged.captureTick = frame.captureTick;
+    merged.detectedTick = frame.detectedTick;
+    merged.arenaSize = frame.arenaSize;
+    merged.results.reserve(frame.results.size());
+
+    for(auto& result : frame.results)
+    {
+        auto owner = owners.find(result.id);
+
+        bool accept = owner == owners.end() || owner->camera == frame.camera;
+
+        if(!accept)
+        {
+            qint64 age = frame.captureTime - owner->time;
+
+            // A frame from before the owner's last pose is out of date, unless
+            // the owner has lost the robot for longer than the timeout
+            accept = age > ownershipTimeout || (age >= -ownershipTimeout && result.quality > owner->quality);
+        }
+
+        if(!accept)
+            continue;
+
+        owners[result.id] = Owner{frame.camera, frame.captureTime, result.quality};
+        merged.results.push_back(result);
+    }
+
+    if(!merged.results.empty())
+        emit newTrackingFrame(merged);
+}
@@ -0,0 +1,44 @@
+#ifndef DETECTIONMERGER_H
+#define DETECTIONMERGER_H
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+
+#include "Application/Core/util.h"
+
+/* DetectionMerger
+ * Combines the tracking frames of several cameras that look at overlapping
+ * parts of the same arena. Each robot is owned by the camera that last gave
+ * its best pose. Another camera only takes a robot over when it reports a
+ * better quality, or when the owner has not seen the robot for a while, so
+ * robots in an overlap do not jump between two slightly different poses.
+ */
+class DetectionMerger : public QObject
+{
+    Q_OBJECT
+
+public:
+    DetectionMerger(QObject* parent = nullptr);
+
+    void setOwnershipTimeout(qint64 milliseconds);
+
+public slots:
+    void newCameraFrame(FrameResult frame);
+
+signals:
+    void newTrackingFrame(FrameResult frame);
+
+private:
+    struct Owner
+    {
+        int camera;
+        qint64 time;
+        double quality;
+    };
+
+    QHash<QString, Owner> owners;
+    qint64 ownershipTimeout;
+};
+
+#endif // DETECTIONMERGER_H
@@ -0,0 +1,139 @@
+/* dictionarybenchmark.cpp
+ *
+ * Measures marker detection and robot lookup for every predefined ArUco
+ * dictionary large enough for the fleet, using a synthetic scene so that
+ * each dictionary sees the same marker motion.
+ */
+
+#include "dictionarybenchmark.h"
+#include "syntheticscene.h"
+#include "markertable.h"
+
+#include "Application/Core/benchmarkstats.h"
+
+#include <opencv2/aruco.hpp>
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+// Fraction of markers that must be found, with no wrong ids, for a
+// dictionary to be recommended
+static const double MIN_RECALL = 0.99;
+
+// Largest distance from the true centre, as a fraction of the marker size,
+// at which a detection counts as correct
+static const double MAX_CENTRE_ERROR = 0.25;
+
+// Time step used when the scene has no frame rate
+static const double BENCHMARK_TIME_STEP = 1.0 / 30;
+
+/* runDictionaryBenchmark
+ * Render frames of the synthetic scene for each dictionary and print the
+ * detection time, lookup time and detection accuracy. Returns zero if at
+ * least one dictionary tracked the whole fleet reliably.
+ */
+int runDictionaryBenchmark(SyntheticSceneConfig config, int frames) {
+    frames = std::max(1, frames);
+    double timeStep = config.fps > 0 ? 1.0 / config.fps : BENCHMARK_TIME_STEP;
+    auto parameters = cv::aruco::DetectorParameters::create();
+
+    printf("Dictionary benchmark: %d markers of %d px in %dx%d, %d frames\n",
+           config.markerCount, config.markerSize, config.width, config.height, frames);
+    printf("%-20s %6s %10s %10s %12s %8s %8s\n",
+           "dictionary", "size", "mean ms", "p95 ms", "lookup ns", "recall", "wrong");
+
+    QString fastest;
+    double fastestTime = std::numeric_limits<double>::max();
+
+    for (auto& name : markerDictionaryNames()) {
+        int dictionary = markerDictionaryFromName(name);
+        cv::Ptr<cv::aruco::Dictionary> tags = cv::aruco::getPredefinedDictionary(dictionary);
+
+        if (tags->bytesList.rows < config.markerCount) {
+            printf("%-20s %6d %10s\n", name.toStdString().c_str(), tags->bytesList.rows, "too small");
+            continue;
+        }
+
+        config.dictionary = dictionary;
+        SyntheticScene scene{config};
+
+        MarkerTable table;
+        table.resize(tags->bytesList.rows);
+        for (auto& marker : scene.getMarkers()) {
+            table.setRobot(marker.id, "robot_" + QString::number(marker.id));
+        }
+
+        std::vector<double> detectTimes;
+        qint64 lookupTime = 0;
+        qint64 lookups = 0;
+        long expected = 0;
+        long correct = 0;
+        long wrong = 0;
+
+        cv::Mat image;
+        std::vector<int> ids;
+        std::vector<std::vector<cv::Point2f>> corners;
+        std::vector<const QString*> robots;
+        QElapsedTimer timer;
+
+        for (int frame = 0; frame < frames; frame++) {
+            scene.render(image);
+
+            timer.start();
+            cv::aruco::detectMarkers(image, tags, corners, ids, parameters);
+            detectTimes.push_back(timer.nsecsElapsed() / 1e6);
+
+            timer.start();
+            robots.clear();
+            for (int id : ids) {
+                robots.push_back(table.robotFor(id));
+            }
+            lookupTime += timer.nsecsElapsed();
+            lookups += ids.size();
+
+            // Markers are numbered by their position in the scene
+            const std::vector<SyntheticScene::Marker>& markers = scene.getMarkers();
+            std::vector<bool> found(markers.size(), false);
+            expected += markers.size();
+
+            for (size_t i = 0; i < ids.size(); i++) {
+                int id = ids[i];
+                cv::Point2f centre = 0.25 * (corners[i][0] + corners[i][1] + corners[i][2] + corners[i][3]);
+
+                if (robots[i] != nullptr && id < (int)markers.size() && !found[id] &&
+                        cv::norm(centre - cv::Point2f(markers[id].x, markers[id].y)) < MAX_CENTRE_ERROR * config.markerSize) {
+                    found[id] = true;
+                    correct++;
+                } else {
+                    wrong++;
+                }
+            }
+
+            scene.step(timeStep);
+        }
+
+        BenchmarkStats detect = getBenchmarkStats(detectTimes);
+        double recall = expected > 0 ? (1.0 * correct) / expected : 1.0;
+        double lookupNs = lookups > 0 ? (1.0 * lookupTime) / lookups : 0;
+
+        printf("%-20s %6d %10.2f %10.2f %12.1f %7.1f%% %8ld\n", name.toStdString().c_str(),
+               tags->bytesList.rows, detect.mean, detect.p95, lookupNs, 100 * recall, wrong);
+
+        if (recall >= MIN_RECALL && wrong == 0 && detect.mean < fastestTime) {
+            fastestTime = detect.mean;
+            fastest = name;
+        }
+    }
+
+    if (fastest.isEmpty()) {
+        printf("No dictionary tracked the fleet reliably, try larger markers\n");
+        return 1;
+    }
+
+    printf("Fastest reliable dictionary: %s\n", fastest.toStdString().c_str());
+    return 0;
+}
@@ -0,0 +1,8 @@
+#ifndef DICTIONARYBENCHMARK_H
+#define DICTIONARYBENCHMARK_H
+
+#include "Application/Core/settings.h"
+
+int runDictionaryBenchmark(SyntheticSceneConfig config, int frames);
+
+#endif // DICTIONARYBENCHMARK_H
@@ -0,0 +1,138 @@
+/* markertable.cpp
+ *
+ * Marker id to robot id lookup, and the names of the predefined ArUco
+ * dictionaries that can be tracked.
+ */
+
+#include "markertable.h"
+
+#include <opencv2/aruco.hpp>
+
+#include <algorithm>
+
+typedef struct {
+    const char* name;
+    int dictionary;
+} DictionaryName;
+
+// Predefined dictionaries, smallest and fastest to decode first
+static const DictionaryName DICTIONARIES[] = {
+    {"DICT_4X4_50", cv::aruco::DICT_4X4_50},
+    {"DICT_4X4_100", cv::aruco::DICT_4X4_100},
+    {"DICT_4X4_250", cv::aruco::DICT_4X4_250},
+    {"DICT_4X4_1000", cv::aruco::DICT_4X4_1000},
+    {"DICT_5X5_50", cv::aruco::DICT_5X5_50},
+    {"DICT_5X5_100", cv::aruco::DICT_5X5_100},
+    {"DICT_5X5_250", cv::aruco::DICT_5X5_250},
+    {"DICT_5X5_1000", cv::aruco::DICT_5X5_1000},
+    {"DICT_6X6_50", cv::aruco::DICT_6X6_50},
+    {"DICT_6X6_100", cv::aruco::DICT_6X6_100},
+    {"DICT_6X6_250", cv::aruco::DICT_6X6_250},
+    {"DICT_6X6_1000", cv::aruco::DICT_6X6_1000},
+    {"DICT_7X7_50", cv::aruco::DICT_7X7_50},
+    {"DICT_7X7_100", cv::aruco::DICT_7X7_100},
+    {"DICT_7X7_250", cv::aruco::DICT_7X7_250},
+    {"DICT_7X7_1000", cv::aruco::DICT_7X7_1000},
+    {"DICT_ARUCO_ORIGINAL", cv::aruco::DICT_ARUCO_ORIGINAL}
+};
+
+/* Constructor
+ * The table starts empty, resize it to the dictionary before use.
+ */
+MarkerTable::MarkerTable(void) {
+    mapped = 0;
+}
+
+/* resize
+ * Make room for every marker of a dictionary. Assignments to markers that
+ * no longer fit are dropped.
+ */
+void MarkerTable::resize(int markerCount) {
+    robots.resize(std::max(0, markerCount));
+
+    mapped = 0;
+    for (auto& robot : robots) {
+        if (!robot.isNull()) {
+            mapped++;
+        }
+    }
+}
+
+/* setRobot
+ * Assign a marker to a robot. Returns false if the marker is not part of
+ * the dictionary.
+ */
+bool MarkerTable::setRobot(int markerId, QString robotId) {
+    if (markerId < 0 || markerId >= (int)robots.size()) {
+        return false;
+    }
+
+    if (robots[markerId].isNull()) {
+        mapped++;
+    }
+
+    robots[markerId] = robotId.isNull() ? QString("") : robotId;
+    return true;
+}
+
+/* clear
+ * Remove every assignment, keeping the table size.
+ */
+void MarkerTable::clear(void) {
+    for (auto& robot : robots) {
+        robot = QString();
+    }
+
+    mapped = 0;
+}
+
+/* markerDictionaryFromName
+ * Returns the predefined dictionary with the given name, with or without the
+ * DICT_ prefix, or -1 if there is no such dictionary.
+ */
+int markerDictionaryFromName(QString name) {
+    name = name.toUpper();
+    if (!name.startsWith("DICT_")) {
+        name.prepend("DICT_");
+    }
+
+    for (auto& entry : DICTIONARIES) {
+        if (name == entry.name) {
+            return entry.dictionary;
+        }
+    }
+
+    return -1;
+}
+
+/* markerDictionaryName
+ * Returns the name of a predefined dictionary.
+ */
+QString markerDictionaryName(int dictionary) {
+    for (auto& entry : DICTIONARIES) {
+        if (dictionary == entry.dictionary) {
+            return entry.name;
+        }
+    }
+
+    return QString::number(dictionary);
+}
+
+/* markerDictionarySize
+ * Returns the number of markers in a predefined dictionary.
+ */
+int markerDictionarySize(int dictionary) {
+    return cv::aruco::getPredefinedDictionary(dictionary)->bytesList.rows;
+}
+
+/* markerDictionaryNames
+ * Returns the names of all predefined dictionaries.
+ */
+QStringList markerDictionaryNames(void) {
+    QStringList names;
+    for (auto& entry : DICTIONARIES) {
+        names << entry.name;
+    }
+
+    return names;
+}
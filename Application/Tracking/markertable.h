@@ -0,0 +1,47 @@
+#ifndef MARKERTABLE_H
+#define MARKERTABLE_H
+
+#include <vector>
+
+#include <QString>
+#include <QStringList>
+
+/* MarkerTable
+ * Dense lookup from ArUco marker id to robot id. The table is sized to the
+ * marker dictionary in use, so every lookup is a bounds check and an index.
+ */
+class MarkerTable
+{
+public:
+    MarkerTable(void);
+
+    void resize(int markerCount);
+    bool setRobot(int markerId, QString robotId);
+    void clear(void);
+
+    int size(void) const { return robots.size(); }
+    int mappedCount(void) const { return mapped; }
+
+    /* robotFor
+     * Returns the robot id of a marker, or nullptr if the marker is not
+     * assigned to a robot.
+     */
+    const QString* robotFor(int markerId) const {
+        if (markerId < 0 || markerId >= (int)robots.size() || robots[markerId].isNull()) {
+            return nullptr;
+        }
+
+        return &robots[markerId];
+    }
+
+private:
+    std::vector<QString> robots;
+    int mapped;
+};
+
+int markerDictionaryFromName(QString name);
+QString markerDictionaryName(int dictionary);
+int markerDictionarySize(int dictionary);
+QStringList markerDictionaryNames(void);
+
+#endif // MARKERTABLE_H
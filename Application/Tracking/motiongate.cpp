@@ -0,0 +1,133 @@
+/* motiongate.cpp
+ *
+ * Frame differencing stage used to skip marker detection in parts of the
+ * image that have not changed since the previous frame.
+ */
+
+#include "motiongate.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// Width of the low resolution copy that is differenced
+static const int GATE_IMAGE_WIDTH = 320;
+
+// Size, in low resolution pixels, of the cells that changes are reported in
+static const int GATE_CELL_SIZE = 8;
+
+// Grey level change regarded as motion rather than sensor noise
+static const int GATE_PIXEL_THRESHOLD = 20;
+
+// Number of changed pixels needed before a cell is regarded as changed
+static const int GATE_MIN_CELL_PIXELS = 2;
+
+// Fraction of changed cells above which the whole frame is searched instead
+static const double GATE_FULL_FRAME_FRACTION = 0.4;
+
+/* Constructor
+ * Nothing to initialise, the first frame always requests a full search.
+ */
+MotionGate::MotionGate(void) {
+}
+
+/* reset
+ * Forget the reference frame so that the next update requests a full search.
+ */
+void MotionGate::reset(void) {
+    previous.release();
+}
+
+/* update
+ * Compare the image against the previous one. Returns true if the whole
+ * frame should be searched (first frame, size change or widespread motion).
+ * Otherwise fills changedRegions with the full resolution rectangles that
+ * changed, each grown by margin pixels. An empty list means nothing moved.
+ */
+bool MotionGate::update(const cv::Mat& image, int margin, std::vector<cv::Rect>& changedRegions) {
+    changedRegions.clear();
+
+    if (image.size() != frameSize) {
+        frameSize = image.size();
+        reset();
+    }
+
+    double scale = std::min(1.0, (1.0 * GATE_IMAGE_WIDTH) / image.cols);
+    cv::Size smallSize{std::max(1, cvRound(image.cols * scale)), std::max(1, cvRound(image.rows * scale))};
+
+    // Shrink before converting so the colour conversion only touches the small copy
+    cv::Mat scaled;
+    cv::resize(image, scaled, smallSize, 0, 0, cv::INTER_AREA);
+
+    if (scaled.channels() == 3) {
+        cv::cvtColor(scaled, small, cv::COLOR_BGR2GRAY);
+    } else {
+        small = scaled;
+    }
+
+    cv::GaussianBlur(small, small, cv::Size{3, 3}, 0);
+
+    if (previous.empty()) {
+        small.copyTo(previous);
+        return true;
+    }
+
+    cv::absdiff(small, previous, difference);
+    cv::swap(small, previous);
+    cv::threshold(difference, difference, GATE_PIXEL_THRESHOLD, 255, cv::THRESH_BINARY);
+
+    // Average the changed pixels over each cell
+    cv::Size cells{(smallSize.width + GATE_CELL_SIZE - 1) / GATE_CELL_SIZE,
+                   (smallSize.height + GATE_CELL_SIZE - 1) / GATE_CELL_SIZE};
+    cv::resize(difference, cellMask, cells, 0, 0, cv::INTER_AREA);
+    cv::threshold(cellMask, cellMask, (255.0 * GATE_MIN_CELL_PIXELS) / (GATE_CELL_SIZE * GATE_CELL_SIZE) - 1, 255, cv::THRESH_BINARY);
+
+    int changedCells = cv::countNonZero(cellMask);
+
+    if (changedCells == 0) {
+        return false;
+    }
+
+    if (changedCells > GATE_FULL_FRAME_FRACTION * cells.area()) {
+        return true;
+    }
+
+    // Group neighbouring changed cells and convert the groups to full resolution
+    cv::Mat labels, stats, centroids;
+    int count = cv::connectedComponentsWithStats(cellMask, labels, stats, centroids, 8, CV_32S);
+
+    double cellToImage = GATE_CELL_SIZE / scale;
+    cv::Rect imageRect{cv::Point{0, 0}, frameSize};
+
+    for (int i = 1; i < count; i++) {
+        int x0 = std::floor(stats.at<int>(i, cv::CC_STAT_LEFT) * cellToImage) - margin;
+        int y0 = std::floor(stats.at<int>(i, cv::CC_STAT_TOP) * cellToImage) - margin;
+        int x1 = std::ceil((stats.at<int>(i, cv::CC_STAT_LEFT) + stats.at<int>(i, cv::CC_STAT_WIDTH)) * cellToImage) + margin;
+        int y1 = std::ceil((stats.at<int>(i, cv::CC_STAT_TOP) + stats.at<int>(i, cv::CC_STAT_HEIGHT)) * cellToImage) + margin;
+
+        cv::Rect region = cv::Rect{cv::Point{x0, y0}, cv::Point{x1, y1}} & imageRect;
+
+        if (region.area() > 0) {
+            changedRegions.push_back(region);
+        }
+    }
+
+    // Merge regions that overlap after growing so no pixel is searched twice
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < changedRegions.size() && !merged; i++) {
+            for (size_t j = i + 1; j < changedRegions.size(); j++) {
+                if ((changedRegions[i] & changedRegions[j]).area() > 0) {
+                    changedRegions[i] |= changedRegions[j];
+                    changedRegions.erase(changedRegions.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    return false;
+}
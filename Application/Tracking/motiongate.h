@@ -0,0 +1,28 @@
+#ifndef MOTIONGATE_H
+#define MOTIONGATE_H
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+/* MotionGate
+ * Cheap frame differencing on a low resolution grayscale copy of each frame.
+ * Reports which regions of the full resolution image changed since the
+ * previous frame so that marker detection can be restricted to them.
+ */
+class MotionGate
+{
+public:
+    MotionGate(void);
+
+    bool update(const cv::Mat& image, int margin, std::vector<cv::Rect>& changedRegions);
+    void reset(void);
+
+private:
+    cv::Mat small;
+    cv::Mat previous;
+    cv::Mat difference;
+    cv::Mat cellMask;
+    cv::Size frameSize;
+};
+
+#endif // MOTIONGATE_H
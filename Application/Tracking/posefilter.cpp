@@ -0,0 +1,146 @@
+/* posefilter.cpp
+ *
+ * Temporal filtering of tracked poses, including coasting through short
+ * marker dropouts.
+ */
+
+#include "posefilter.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Filter gains for position and heading
+static const double POSITION_ALPHA = 0.5;
+static const double POSITION_BETA = 0.1;
+static const double HEADING_ALPHA = 0.4;
+static const double HEADING_BETA = 0.05;
+
+// Measurements further than this from the prediction, as a proportion of the
+// arena, restart the track instead of being filtered into it
+static const double RESTART_DISTANCE = 0.1;
+
+// Default time in seconds a track is predicted for without a measurement
+static const double DEFAULT_COAST_TIME = 0.5;
+
+/* wrapAngle
+ * Wrap an angle in degrees into the range -180 to 180.
+ */
+static double wrapAngle(double angle) {
+    return std::remainder(angle, 360.0);
+}
+
+/* Constructor
+ * Create the given number of inactive slots.
+ */
+PoseFilter::PoseFilter(int slots) {
+    hasTime = false;
+    lastTime = 0;
+    coastTime = DEFAULT_COAST_TIME;
+    resize(slots);
+}
+
+/* resize
+ * Change the number of slots. All tracks are dropped.
+ */
+void PoseFilter::resize(int slots) {
+    x.assign(slots, 0);
+    y.assign(slots, 0);
+    vx.assign(slots, 0);
+    vy.assign(slots, 0);
+    heading.assign(slots, 0);
+    headingRate.assign(slots, 0);
+    age.assign(slots, 0);
+    confidence.assign(slots, 0);
+    active.assign(slots, 0);
+}
+
+/* initialise
+ * Start a new track at a measurement, at rest.
+ */
+void PoseFilter::initialise(int slot, const Pose& measurement) {
+    x[slot] = measurement.position.x;
+    y[slot] = measurement.position.y;
+    vx[slot] = 0;
+    vy[slot] = 0;
+    heading[slot] = measurement.orientation;
+    headingRate[slot] = 0;
+    age[slot] = 0;
+    active[slot] = 1;
+}
+
+/* update
+ * Advance every track to the given time in seconds and correct the tracks
+ * that have a measurement. Tracks without a measurement for longer than the
+ * coast time are dropped.
+ */
+void PoseFilter::update(double time, const std::vector<int>& slots, const std::vector<Pose>& measurements) {
+    double dt = hasTime ? std::max(0.0, time - lastTime) : 0;
+    hasTime = true;
+    lastTime = time;
+
+    int n = size();
+
+    // Predict every slot forwards. Inactive slots are at rest so this needs no branches.
+    for (int i = 0; i < n; i++) {
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        heading[i] += headingRate[i] * dt;
+        age[i] += dt;
+    }
+
+    // Correct the measured tracks
+    for (size_t k = 0; k < slots.size(); k++) {
+        int s = slots[k];
+        if (s < 0 || s >= n) {
+            continue;
+        }
+
+        const Pose& m = measurements[k];
+        double rx = m.position.x - x[s];
+        double ry = m.position.y - y[s];
+
+        if (!active[s] || rx * rx + ry * ry > RESTART_DISTANCE * RESTART_DISTANCE) {
+            initialise(s, m);
+            continue;
+        }
+
+        double rh = wrapAngle(m.orientation - heading[s]);
+
+        x[s] += POSITION_ALPHA * rx;
+        y[s] += POSITION_ALPHA * ry;
+        heading[s] = wrapAngle(heading[s] + HEADING_ALPHA * rh);
+
+        if (dt > 0) {
+            vx[s] += POSITION_BETA * rx / dt;
+            vy[s] += POSITION_BETA * ry / dt;
+            headingRate[s] += HEADING_BETA * rh / dt;
+        }
+
+        age[s] = 0;
+    }
+
+    // Confidence falls linearly while a track coasts
+    for (int i = 0; i < n; i++) {
+        confidence[i] = active[i] * std::max(0.0, 1.0 - age[i] / coastTime);
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (active[i] && age[i] > coastTime) {
+            active[i] = 0;
+            vx[i] = 0;
+            vy[i] = 0;
+            headingRate[i] = 0;
+        }
+    }
+}
+
+/* getPose
+ * Returns the current estimate of a slot.
+ */
+Pose PoseFilter::getPose(int slot) const {
+    Pose p;
+    p.position.x = x[slot];
+    p.position.y = y[slot];
+    p.orientation = wrapAngle(heading[slot]);
+    return p;
+}
@@ -0,0 +1,47 @@
+#ifndef POSEFILTER_H
+#define POSEFILTER_H
+
+#include <vector>
+
+#include "Application/Core/util.h"
+
+/* PoseFilter
+ * Constant velocity alpha-beta filter over a fixed number of track slots,
+ * one per marker id. Smooths position and heading, and keeps predicting a
+ * track for a short time after its marker stops being detected. The state of
+ * all slots is stored as contiguous arrays and predicted in a single pass.
+ */
+class PoseFilter
+{
+public:
+    PoseFilter(int slots = 0);
+
+    void resize(int slots);
+    void setCoastTime(double seconds) { coastTime = seconds; }
+
+    void update(double time, const std::vector<int>& slots, const std::vector<Pose>& measurements);
+
+    int size(void) const { return (int)active.size(); }
+    bool isActive(int slot) const { return active[slot] != 0; }
+    Pose getPose(int slot) const;
+    double getConfidence(int slot) const { return confidence[slot]; }
+
+private:
+    void initialise(int slot, const Pose& measurement);
+
+    bool hasTime;
+    double lastTime;
+    double coastTime;
+
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> vx;
+    std::vector<double> vy;
+    std::vector<double> heading;
+    std::vector<double> headingRate;
+    std::vector<double> age;
+    std::vector<double> confidence;
+    std::vector<char> active;
+};
+
+#endif // POSEFILTER_H
@@ -0,0 +1,64 @@
+/* syntheticcamerathread.cpp
+ *
+ * Camera source that renders a synthetic marker scene and publishes the true
+ * marker poses alongside each frame.
+ */
+
+#include "syntheticcamerathread.h"
+
+#include <QElapsedTimer>
+
+// Simulated time step used when frames are produced as fast as possible
+static const double UNPACED_TIME_STEP = 1.0 / 30;
+
+SyntheticCameraThread::SyntheticCameraThread(SyntheticSceneConfig config, const MarkerTable* markerTable)
+    : config(config), scene(config)
+{
+    this->markerTable = markerTable;
+}
+
+void SyntheticCameraThread::run()
+{
+    // The scene advances by a fixed step per frame so runs are repeatable
+    double timeStep = config.fps > 0 ? 1.0 / config.fps : UNPACED_TIME_STEP;
+    quint64 frameIndex = 0;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    while(shouldRun)
+    {
+        waitForConsumers();
+
+        if(config.fps > 0)
+        {
+            qint64 due = (1000.0 * frameIndex) / config.fps;
+            qint64 wait = due - clock.elapsed();
+            if(wait > 0)
+                msleep(wait);
+        }
+
+        cv::Mat image;
+        scene.render(image);
+        FrameInfo info = stampFrame();
+
+        std::vector<TrackResult> poses;
+        for(auto& marker : scene.getMarkers())
+        {
+            const QString* name = markerTable->robotFor(marker.id);
+            if(name == nullptr)
+                continue;
+
+            poses.push_back(TrackResult{*name, scene.getPose(marker), 1.0});
+        }
+
+        if(shouldRun)
+        {
+            emit newGroundTruth(info, poses);
+            publishFrame(image, info);
+        }
+
+        scene.step(timeStep);
+        frameIndex++;
+    }
+}
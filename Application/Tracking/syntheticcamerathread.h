@@ -0,0 +1,33 @@
+#ifndef SYNTHETICCAMERATHREAD_H
+#define SYNTHETICCAMERATHREAD_H
+
+#include <vector>
+
+#include <QString>
+
+#include "camerathread.h"
+#include "syntheticscene.h"
+#include "markertable.h"
+#include "Application/Core/util.h"
+
+class SyntheticCameraThread : public ARCameraThread
+{
+    Q_OBJECT
+
+public:
+    SyntheticCameraThread(SyntheticSceneConfig config, const MarkerTable* markerTable);
+    virtual void run() override;
+
+signals:
+    // Emitted just before the frame with the same id
+    void newGroundTruth(FrameInfo info, std::vector<TrackResult> poses);
+
+private:
+    SyntheticSceneConfig config;
+    SyntheticScene scene;
+    const MarkerTable* markerTable;
+};
+
+Q_DECLARE_METATYPE(std::vector<TrackResult>)
+
+#endif // SYNTHETICCAMERATHREAD_H
@@ -0,0 +1,157 @@
+/* syntheticscene.cpp
+ *
+ * Renders ArUco markers moving over a background so that tracking can be
+ * exercised and measured without a camera.
+ */
+
+#include "syntheticscene.h"
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include <QtMath>
+#include <cmath>
+
+// Width of the white border around each marker, as a fraction of its size
+static const double QUIET_ZONE_FRACTION = 0.25;
+
+// Random walk applied to the turn rate, in degrees per second per root second
+static const double TURN_RATE_NOISE = 90;
+
+// Largest turn rate in degrees per second
+static const double MAX_TURN_RATE = 90;
+
+/* Constructor
+ * Render the marker images once and place the markers at random positions.
+ */
+SyntheticScene::SyntheticScene(const SyntheticSceneConfig& config) : config(config), rng(config.seed) {
+    auto dictionary = cv::aruco::getPredefinedDictionary(config.dictionary);
+    int count = std::min(config.markerCount, dictionary->bytesList.rows);
+    int quietZone = std::max(1, cvRound(config.markerSize * QUIET_ZONE_FRACTION));
+
+    // Load the background, falling back to a plain grey level
+    if (!config.backgroundFile.isEmpty()) {
+        cv::Mat loaded = cv::imread(config.backgroundFile.toStdString(), cv::IMREAD_COLOR);
+        if (!loaded.empty()) {
+            cv::resize(loaded, background, cv::Size{config.width, config.height}, 0, 0, cv::INTER_AREA);
+        }
+    }
+
+    if (background.empty()) {
+        background = cv::Mat(config.height, config.width, CV_8UC3, cv::Scalar::all(config.backgroundLevel));
+    }
+
+    double extent = (config.markerSize + 2 * quietZone) * M_SQRT1_2;
+
+    for (int id = 0; id < count; id++) {
+        cv::Mat marker, bordered, colour;
+        cv::aruco::drawMarker(dictionary, id, config.markerSize, marker, 1);
+        cv::copyMakeBorder(marker, bordered, quietZone, quietZone, quietZone, quietZone, cv::BORDER_CONSTANT, cv::Scalar::all(255));
+        cv::cvtColor(bordered, colour, cv::COLOR_GRAY2BGR);
+        markerImages.push_back(colour);
+
+        Marker m;
+        m.id = id;
+        m.x = config.width > 2 * extent ? rng.uniform(extent, config.width - extent) : 0.5 * config.width;
+        m.y = config.height > 2 * extent ? rng.uniform(extent, config.height - extent) : 0.5 * config.height;
+        m.heading = rng.uniform(-180.0, 180.0);
+        m.turnRate = 0;
+        markers.push_back(m);
+    }
+}
+
+/* step
+ * Move every marker forwards along its heading for dt seconds, bouncing off
+ * the edges of the frame.
+ */
+void SyntheticScene::step(double dt) {
+    double speed = config.speed * config.width;
+    double extent = markerImages.empty() ? 0 : markerImages[0].cols * M_SQRT1_2;
+    double maxX = std::max(extent, config.width - extent);
+    double maxY = std::max(extent, config.height - extent);
+
+    for (auto& m : markers) {
+        m.turnRate += rng.gaussian(TURN_RATE_NOISE * std::sqrt(dt));
+        m.turnRate = std::max(-MAX_TURN_RATE, std::min(MAX_TURN_RATE, m.turnRate));
+        m.heading += m.turnRate * dt;
+
+        double heading = qDegreesToRadians(m.heading);
+        m.x += std::cos(heading) * speed * dt;
+        m.y += std::sin(heading) * speed * dt;
+
+        if (m.x < extent) {
+            m.x = 2 * extent - m.x;
+            m.heading = 180 - m.heading;
+        } else if (m.x > maxX) {
+            m.x = 2 * maxX - m.x;
+            m.heading = 180 - m.heading;
+        }
+
+        if (m.y < extent) {
+            m.y = 2 * extent - m.y;
+            m.heading = -m.heading;
+        } else if (m.y > maxY) {
+            m.y = 2 * maxY - m.y;
+            m.heading = -m.heading;
+        }
+
+        m.heading = std::remainder(m.heading, 360.0);
+    }
+}
+
+/* render
+ * Draw the current state of the scene into a new image.
+ */
+void SyntheticScene::render(cv::Mat& image) {
+    background.copyTo(image);
+    cv::Rect frame{0, 0, image.cols, image.rows};
+
+    for (size_t i = 0; i < markers.size(); i++) {
+        const Marker& m = markers[i];
+        const cv::Mat& marker = markerImages[i];
+
+        // The detector measures heading from the marker centre towards the
+        // middle of its top edge, which is 90 degrees behind the image rotation
+        double angle = qDegreesToRadians(m.heading + 90);
+        double c = std::cos(angle);
+        double s = std::sin(angle);
+        double centre = 0.5 * (marker.cols - 1);
+        double extent = 0.5 * marker.cols * (std::abs(c) + std::abs(s)) + 1;
+
+        cv::Rect roi = cv::Rect{cv::Point(std::floor(m.x - extent), std::floor(m.y - extent)),
+                                cv::Point(std::ceil(m.x + extent), std::ceil(m.y + extent))} & frame;
+
+        if (roi.area() == 0) {
+            continue;
+        }
+
+        // Rotate about the marker centre, then move the centre onto the marker position
+        cv::Matx23d transform{c, -s, m.x - roi.x - (c * centre - s * centre),
+                              s,  c, m.y - roi.y - (s * centre + c * centre)};
+
+        cv::Mat target = image(roi);
+        cv::warpAffine(marker, target, transform, roi.size(), cv::INTER_LINEAR, cv::BORDER_TRANSPARENT);
+    }
+
+    if (config.blurKernel > 1) {
+        int kernel = config.blurKernel | 1;
+        cv::GaussianBlur(image, image, cv::Size{kernel, kernel}, 0);
+    }
+
+    if (config.noiseSigma > 0) {
+        noise.create(image.size(), CV_16SC3);
+        rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0), cv::Scalar::all(config.noiseSigma));
+        cv::add(image, noise, image, cv::noArray(), CV_8U);
+    }
+}
+
+/* getPose
+ * Returns the pose of a marker in the same form the ArUco tracker reports it.
+ */
+Pose SyntheticScene::getPose(const Marker& marker) const {
+    Pose p;
+    p.position.x = marker.x / config.width;
+    p.position.y = marker.y / config.height;
+    p.orientation = marker.heading;
+    return p;
+}
@@ -0,0 +1,43 @@
+#ifndef SYNTHETICSCENE_H
+#define SYNTHETICSCENE_H
+
+#include <opencv2/aruco.hpp>
+#include <vector>
+
+#include "Application/Core/settings.h"
+
+/* SyntheticScene
+ * A set of ArUco markers moving around a flat background. Used to produce
+ * camera frames with known marker poses.
+ */
+class SyntheticScene
+{
+public:
+    struct Marker
+    {
+        int id;
+        double x;
+        double y;
+        double heading;
+        double turnRate;
+    };
+
+    SyntheticScene(const SyntheticSceneConfig& config);
+
+    void step(double dt);
+    void render(cv::Mat& image);
+
+    const std::vector<Marker>& getMarkers(void) const { return markers; }
+    Pose getPose(const Marker& marker) const;
+
+private:
+    SyntheticSceneConfig config;
+    cv::RNG rng;
+
+    cv::Mat background;
+    cv::Mat noise;
+    std::vector<cv::Mat> markerImages;
+    std::vector<Marker> markers;
+};
+
+#endif // SYNTHETICSCENE_H
@@ -0,0 +1,165 @@
+/* trackingbenchmark.cpp
+ *
+ * Measures how far the tracked poses are from the true poses of a synthetic
+ * scene, and how long each frame takes from capture until its poses are
+ * reported.
+ */
+
+#include "trackingbenchmark.h"
+#include "syntheticcamerathread.h"
+#include "aruco.h"
+#include "markertable.h"
+
+#include "Application/Core/latencymonitor.h"
+#include "Application/Core/benchmarkstats.h"
+
+#include <QEventLoop>
+#include <QHash>
+#include <QThread>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+/* Constructor
+ * Prepare to compare the given number of tracked frames.
+ */
+TrackingBenchmark::TrackingBenchmark(SyntheticSceneConfig config, int frames) {
+    this->config = config;
+    this->frames = std::max(1, frames);
+    tracked = 0;
+    expected = 0;
+    found = 0;
+}
+
+/* newGroundTruth
+ * Keep the true poses of a frame until the tracker reports it. Frames the
+ * tracker skips while it is busy are dropped when a later frame arrives.
+ */
+void TrackingBenchmark::newGroundTruth(FrameInfo info, std::vector<TrackResult> poses) {
+    truth[info.id] = poses;
+}
+
+/* newTrackingFrame
+ * Match the tracked poses of a frame to its true poses by robot, and print
+ * the position and heading errors and the latency of the frame.
+ */
+void TrackingBenchmark::newTrackingFrame(FrameResult frame) {
+    if (isDone()) {
+        return;
+    }
+
+    auto it = truth.find(frame.frameId);
+    if (it == truth.end()) {
+        return;
+    }
+
+    QHash<QString, Pose> trackedPoses;
+    for (auto& result : frame.results) {
+        trackedPoses[result.id] = result.pose;
+    }
+
+    std::vector<double> frameErrors;
+    double frameHeadingError = 0;
+
+    for (auto& result : it->second) {
+        auto pose = trackedPoses.find(result.id);
+        if (pose == trackedPoses.end()) {
+            continue;
+        }
+
+        // Errors are in pixels of the synthetic image
+        double dx = (pose->position.x - result.pose.position.x) * config.width;
+        double dy = (pose->position.y - result.pose.position.y) * config.height;
+        double heading = std::abs(std::remainder(pose->orientation - result.pose.orientation, 360.0));
+
+        frameErrors.push_back(std::sqrt(dx * dx + dy * dy));
+        headingErrors.push_back(heading);
+        frameHeadingError += heading;
+    }
+
+    double detection = (frame.detectedTick - frame.captureTick) / 1e6;
+    double reported = (LatencyMonitor::now() - frame.captureTick) / 1e6;
+
+    expected += it->second.size();
+    found += frameErrors.size();
+    positionErrors.insert(positionErrors.end(), frameErrors.begin(), frameErrors.end());
+
+    BenchmarkStats frameStats = getBenchmarkStats(frameErrors);
+    printf("%8llu %7zu/%-7zu %10.2f %10.2f %10.2f %10.2f %10.2f\n", (unsigned long long)frame.frameId,
+           frameErrors.size(), it->second.size(), frameStats.mean, frameStats.max,
+           frameErrors.empty() ? 0.0 : frameHeadingError / frameErrors.size(), detection, reported);
+    latencies.push_back(reported);
+
+    truth.erase(truth.begin(), ++it);
+    tracked++;
+
+    if (isDone()) {
+        emit finished();
+    }
+}
+
+/* summarise
+ * Print the errors and latencies over all frames. Returns zero if any
+ * frame was tracked.
+ */
+int TrackingBenchmark::summarise(void) {
+    BenchmarkStats position = getBenchmarkStats(positionErrors);
+    BenchmarkStats heading = getBenchmarkStats(headingErrors);
+    BenchmarkStats latency = getBenchmarkStats(latencies);
+
+    printf("Tracked %d frames, found %ld of %ld markers (%.1f%%)\n", tracked, found, expected,
+           expected > 0 ? (100.0 * found) / expected : 0.0);
+    printf("Position error px: mean %.2f, p95 %.2f, max %.2f\n", position.mean, position.p95, position.max);
+    printf("Heading error deg: mean %.2f, p95 %.2f\n", heading.mean, heading.p95);
+    printf("Latency ms: mean %.2f, p95 %.2f, max %.2f\n", latency.mean, latency.p95, latency.max);
+
+    return tracked > 0 ? 0 : 1;
+}
+
+/* runTrackingBenchmark
+ * Run the synthetic camera and a tracker on its own thread, as the
+ * application does, and compare the poses of the given number of tracked
+ * frames with the true poses of the scene.
+ */
+int runTrackingBenchmark(SyntheticSceneConfig config, int frames) {
+    qRegisterMetaType<cv::Mat>("cv::Mat&");
+    qRegisterMetaType<FrameInfo>("FrameInfo");
+    qRegisterMetaType<std::vector<TrackResult>>("std::vector<TrackResult>");
+    qRegisterMetaType<FrameResult>("FrameResult");
+
+    MarkerTable table;
+    table.resize(markerDictionarySize(config.dictionary));
+    for (int id = 0; id < config.markerCount; id++) {
+        table.setRobot(id, "robot_" + QString::number(id));
+    }
+
+    SyntheticCameraThread camera{config, &table};
+    ArUco tracker{&table, &camera};
+    QThread trackerThread;
+    tracker.moveToThread(&trackerThread);
+
+    TrackingBenchmark benchmark{config, frames};
+    QObject::connect(&camera, SIGNAL(newGroundTruth(FrameInfo, std::vector<TrackResult>)),
+                     &benchmark, SLOT(newGroundTruth(FrameInfo, std::vector<TrackResult>)));
+    QObject::connect(&tracker, SIGNAL(newTrackingFrame(FrameResult)), &benchmark, SLOT(newTrackingFrame(FrameResult)));
+
+    printf("Tracking benchmark: %d markers of %d px in %dx%d at %.0f fps, %d frames\n",
+           config.markerCount, config.markerSize, config.width, config.height, config.fps, frames);
+    printf("%8s %15s %10s %10s %10s %10s %10s\n",
+           "frame", "found", "mean px", "max px", "head deg", "detect ms", "total ms");
+
+    QEventLoop loop;
+    QObject::connect(&benchmark, SIGNAL(finished()), &loop, SLOT(quit()));
+
+    trackerThread.start();
+    camera.start();
+    loop.exec();
+
+    camera.quit();
+    camera.wait();
+    trackerThread.quit();
+    trackerThread.wait();
+
+    return benchmark.summarise();
+}
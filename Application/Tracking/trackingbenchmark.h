@@ -0,0 +1,52 @@
+#ifndef TRACKINGBENCHMARK_H
+#define TRACKINGBENCHMARK_H
+
+#include <map>
+#include <vector>
+
+#include <QObject>
+
+#include "Application/Core/settings.h"
+#include "Application/Core/util.h"
+#include "Application/Tracking/camerathread.h"
+
+/* TrackingBenchmark
+ * Compares the poses the tracker reports for the frames of a synthetic
+ * scene with the true marker poses published by the scene camera, frame by
+ * frame.
+ */
+class TrackingBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    TrackingBenchmark(SyntheticSceneConfig config, int frames);
+
+    bool isDone(void) const { return tracked >= frames; }
+    int summarise(void);
+
+public slots:
+    void newGroundTruth(FrameInfo info, std::vector<TrackResult> poses);
+    void newTrackingFrame(FrameResult frame);
+
+signals:
+    void finished(void);
+
+private:
+    SyntheticSceneConfig config;
+    int frames;
+    int tracked;
+
+    // True poses of the frames the tracker has not reported yet
+    std::map<quint64, std::vector<TrackResult>> truth;
+
+    long expected;
+    long found;
+    std::vector<double> positionErrors;
+    std::vector<double> headingErrors;
+    std::vector<double> latencies;
+};
+
+int runTrackingBenchmark(SyntheticSceneConfig config, int frames);
+
+#endif // TRACKINGBENCHMARK_H
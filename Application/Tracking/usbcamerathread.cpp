@@ -2,9 +2,14 @@
 
 #include <iostream>
 
-USBCameraThread::USBCameraThread()
+USBCameraThread::USBCameraThread(int device)
 {
-    captureDevice = cv::VideoCapture(0);
+    captureDevice = cv::VideoCapture(device);
+
+    // Monochrome cameras can deliver luma directly. Other cameras ignore the
+    // request and their frames are reduced to luma when published.
+    if(Settings::instance()->isGrayscaleCaptureEnabled())
+        captureDevice.set(cv::CAP_PROP_FOURCC, cv::VideoWriter::fourcc('G', 'R', 'E', 'Y'));
 }
 
 void USBCameraThread::run()
@@ -15,12 +20,9 @@ void USBCameraThread::run()
         {
             cv::Mat image;
             captureDevice>>image;
+            FrameInfo info = stampFrame();
             if(shouldRun)
-            {
-                executePreEmitCalls();
-                emit newVideoFrame(image);
-                disconnect(this, SIGNAL(newVideoFrame(cv::Mat&)), nullptr, 0);
-            }
+                publishFrame(image, info);
         }
         else
         {
@@ -10,12 +10,9 @@ class USBCameraThread : public ARCameraThread
     Q_OBJECT
 
 public:
-    USBCameraThread();
+    USBCameraThread(int device = 0);
     virtual void run() override;
 
-signals:
-    void newVideoFrame(cv::Mat& image);
-
 private:
     cv::VideoCapture captureDevice;
 };
@@ -0,0 +1,134 @@
+/* videofilecamerathread.cpp
+ *
+ * Camera source that plays back a recorded video file. Playback is either at
+ * the recorded frame rate or as fast as the consumers allow. Every frame is
+ * delivered to every consumer, so runs over the same file are repeatable.
+ */
+
+#include "videofilecamerathread.h"
+#include "Application/Core/log.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+
+// Frame rate assumed when the file does not report one
+static const double DEFAULT_FRAME_RATE = 30;
+
+// Seeks forward by at most this many frames are done by decoding frame by frame
+static const qint64 MAX_DECODE_FORWARD = 300;
+
+VideoFileCameraThread::VideoFileCameraThread(VideoFileConfig config)
+    : config(config), position(0), pendingSeek(config.startFrame)
+{
+    captureDevice.open(config.file.toStdString());
+
+    frameRate = captureDevice.get(cv::CAP_PROP_FPS);
+    if(!(frameRate > 0) || std::isinf(frameRate))
+        frameRate = DEFAULT_FRAME_RATE;
+
+    if(!captureDevice.isOpened())
+        Log::instance()->logMessage("Could not open video file " + config.file, true);
+}
+
+/* seek
+ * Slot. Request that playback continues from the given frame.
+ */
+void VideoFileCameraThread::seek(qint64 frame)
+{
+    pendingSeek.store(std::max<qint64>(0, frame));
+}
+
+/* seekTo
+ * Move the read position to exactly the given frame. Backends may only be
+ * able to seek to key frames, so short forward seeks decode frame by frame
+ * and any seek the backend cannot confirm is redone from the start.
+ */
+bool VideoFileCameraThread::seekTo(qint64 frame)
+{
+    if(frame < position || frame - position > MAX_DECODE_FORWARD)
+    {
+        captureDevice.set(cv::CAP_PROP_POS_FRAMES, frame);
+
+        if(std::llround(captureDevice.get(cv::CAP_PROP_POS_FRAMES)) == frame)
+        {
+            position = frame;
+            return true;
+        }
+
+        captureDevice.open(config.file.toStdString());
+        position = 0;
+    }
+
+    while(position < frame)
+    {
+        if(!captureDevice.grab())
+            return false;
+
+        position++;
+    }
+
+    return true;
+}
+
+void VideoFileCameraThread::run()
+{
+    // Playback time is measured from an anchor that is reset after every seek
+    QElapsedTimer clock;
+    qint64 anchorFrame = 0;
+    qint64 startTime = QDateTime::currentMSecsSinceEpoch();
+    qint64 framesPlayed = 0;
+    bool atEnd = false;
+
+    while(shouldRun)
+    {
+        qint64 target = pendingSeek.fetchAndStoreOrdered(-1);
+        if(target >= 0)
+        {
+            atEnd = !seekTo(target);
+            anchorFrame = position;
+            clock.start();
+        }
+
+        if(!captureDevice.isOpened() || atEnd)
+        {
+            msleep(10);
+            continue;
+        }
+
+        waitForConsumers();
+
+        if(!config.fast)
+        {
+            qint64 due = (1000.0 * (position - anchorFrame)) / frameRate;
+            qint64 wait = due - clock.elapsed();
+            if(wait > 0)
+                msleep(wait);
+        }
+
+        cv::Mat image;
+        if(!captureDevice.read(image) || image.empty())
+        {
+            if(config.loop)
+                pendingSeek.testAndSetOrdered(-1, 0);
+            else
+                atEnd = true;
+
+            continue;
+        }
+
+        // Frame times advance by the recorded frame interval rather than with
+        // the wall clock, so anything driven by them behaves the same at any
+        // playback speed. They keep increasing across seeks and loops.
+        FrameInfo info = stampFrame(position + 1);
+        info.captureTime = startTime + std::llround((1000.0 * framesPlayed) / frameRate);
+        position++;
+        framesPlayed++;
+
+        if(shouldRun)
+            publishFrame(image, info);
+    }
+
+    captureDevice.release();
+}
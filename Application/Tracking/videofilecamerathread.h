@@ -0,0 +1,35 @@
+#ifndef VIDEOFILECAMERATHREAD_H
+#define VIDEOFILECAMERATHREAD_H
+
+#include <opencv2/videoio.hpp>
+
+#include <QString>
+#include <QAtomicInteger>
+
+#include "camerathread.h"
+#include "Application/Core/settings.h"
+
+class VideoFileCameraThread : public ARCameraThread
+{
+    Q_OBJECT
+
+public:
+    VideoFileCameraThread(VideoFileConfig config);
+    virtual void run() override;
+
+public slots:
+    void seek(qint64 frame);
+
+private:
+    bool seekTo(qint64 frame);
+
+    VideoFileConfig config;
+    cv::VideoCapture captureDevice;
+    double frameRate;
+
+    // Index of the next frame that will be read from the file
+    qint64 position;
+    QAtomicInteger<qint64> pendingSeek;
+};
+
+#endif // VIDEOFILECAMERATHREAD_H
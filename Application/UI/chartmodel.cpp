@@ -0,0 +1,855 @@
+/* chartmodel.cpp
+ *
+ * Keeps the series of the chart below the robot list and updates them in
+ * place as data arrives.
+ */
+
+#include "chartmodel.h"
+#include "../Core/settings.h"
+
+#include <QtCharts/QPieSlice>
+#include <QtCharts/QLegendMarker>
+#include <QtCharts/QBarCategoryAxis>
+#include <QDateTime>
+#include <QFont>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+// Most robot values drawn at once
+static const size_t MAX_PLOTTED_VALUES = 20;
+
+// Points per line when the chart has not been laid out yet
+static const int DEFAULT_PLOT_WIDTH = 500;
+
+// Most events marked on each line, the newest are kept
+static const size_t MAX_EVENT_MARKERS = 500;
+
+// Seconds of history shown when a swarm metric is charted
+static const double METRIC_CHART_DURATION = 60;
+
+// Value counted in the pie chart for robots without the key
+static const QString EMPTY_VALUE = "empty";
+
+/* pieValueOf
+ * The value a robot is counted under in the pie chart of a key.
+ */
+static QString pieValueOf(RobotData* robot, const QString& key)
+{
+    if(robot->getValueType(key) == ValueType::String)
+        return robot->getStringValue(key);
+
+    return EMPTY_VALUE;
+}
+
+/* removePointsBefore
+ * Remove the points of a series left of a position on the x axis.
+ */
+static void removePointsBefore(QtCharts::QXYSeries* series, double x)
+{
+    int expired = 0;
+    while(expired < series->count() && series->at(expired).x() < x)
+        expired++;
+
+    if(expired > 0)
+        series->removePoints(0, expired);
+}
+
+/* setAxisRanges
+ * Fit the axes of a chart to a range of samples, with a margin above and
+ * below.
+ */
+static void setAxisRanges(QtCharts::QChart* chart, double minX, double maxX, double minY, double maxY)
+{
+    if(!chart->axisX() || !chart->axisY())
+        return;
+
+    double range = std::max(fabs(maxY - minY), 1e-6);
+    chart->axisX()->setRange(maxX > minX ? minX : maxX - 1, maxX);
+    chart->axisY()->setRange(minY - range * 0.1, maxY + range * 0.1);
+}
+
+/* Constructor
+ * Create the series that are reused for every pie, bar and metric chart.
+ */
+ChartModel::ChartModel(DataModel* dataModel, QtCharts::QChart* chart, QObject* parent) : QObject(parent)
+{
+    this->dataModel = dataModel;
+    this->chart = chart;
+
+    type = ValueType::Unknown;
+    metric = nullptr;
+    plottedWidth = 0;
+    plottedWindow = 0;
+    plottedEnd = 0;
+
+    pie = new QtCharts::QPieSeries{this};
+    pieRecount = false;
+
+    bars = new QtCharts::QBarSeries{this};
+    barSet = new QtCharts::QBarSet{""};
+    bars->append(barSet);
+    barsChanged = false;
+    barsMax = 0;
+
+    histogramShown = false;
+    histogramRecount = false;
+    histogramBars = new QtCharts::QBarSeries{this};
+    histogramSet = new QtCharts::QBarSet{""};
+    histogramBars->append(histogramSet);
+    for(int i = 0; i < histogram.getBinCount(); ++i)
+        histogramSet->append(0);
+    histogramVersion = 0;
+    histogramLayout = 0;
+
+    metricLine = new QtCharts::QLineSeries{this};
+    metricLine->setUseOpenGL(true);
+    metricNewest = 0;
+
+    epoch = QDateTime::currentMSecsSinceEpoch();
+
+    colours[0].setRgb(230,25,75);//red
+    colours[1].setRgb(60,180,75);//green
+    colours[2].setRgb(255,225,25);//yellow
+    colours[3].setRgb(0,130,200);//blue
+    colours[4].setRgb(245,130,48);//orange
+    colours[5].setRgb(140,30,180);//purple
+    colours[6].setRgb(70,240,240);//cyan
+    colours[7].setRgb(240,30,230);//magenta
+    colours[8].setRgb(170,110,40);//brown
+    colours[9].setRgb(0,0,128);//navy
+    colourCounter = 0;
+}
+
+/* showValue
+ * Chart a key of the robot data: the distribution of a string value over
+ * all robots as a pie, an array of the selected robot as bars, or a number
+ * of the selected robot as a line over time.
+ */
+void ChartModel::showValue(QString key, ValueType type)
+{
+    reset();
+
+    this->key = key;
+    this->type = type;
+    metric = nullptr;
+    shownRobot = dataModel->selectedRobotID;
+
+    if(type == ValueType::String)
+    {
+        recountPie();
+        attachSeries(pie);
+    }
+    else if(type == ValueType::Array)
+    {
+        barSet->setLabel(key);
+        showBars();
+    }
+    else if(type == ValueType::Double)
+    {
+        plotValue(shownRobot, key);
+    }
+}
+
+/* addValue
+ * Draw a number of a robot as another line next to those already drawn.
+ * Replaces any other kind of chart.
+ */
+void ChartModel::addValue(QString robotId, QString key)
+{
+    if(metric || histogramShown || type != ValueType::Double)
+    {
+        reset();
+
+        this->key = key;
+        type = ValueType::Double;
+        metric = nullptr;
+        shownRobot = dataModel->selectedRobotID;
+    }
+
+    plotValue(robotId, key);
+}
+
+/* showHistogram
+ * Chart how a number is distributed over the whole fleet, with its
+ * percentiles in the title.
+ */
+void ChartModel::showHistogram(QString key)
+{
+    reset();
+
+    this->key = key;
+    type = ValueType::Unknown;
+    metric = nullptr;
+    histogramShown = true;
+
+    fillHistogram();
+    attachSeries(histogramBars);
+
+    // Versions never reach the largest value, so every bar and label is set
+    histogramVersion = ~(quint64)0;
+    histogramLayout = ~(quint64)0;
+    updateHistogram();
+}
+
+/* showMetric
+ * Chart the last minute of a swarm metric, read from each sample of the
+ * metrics history by the given function.
+ */
+void ChartModel::showMetric(MetricValue value)
+{
+    reset();
+
+    metric = value;
+    type = ValueType::Unknown;
+
+    attachSeries(metricLine);
+    loadMetricHistory();
+}
+
+/* selectedRobotChanged
+ * Show the line or bars of the newly selected robot. The pie chart and the
+ * histogram cover every robot, and lines added for several robots were
+ * chosen one by one, so those stay as they are.
+ */
+void ChartModel::selectedRobotChanged(void)
+{
+    if(dataModel->selectedRobotID == shownRobot)
+        return;
+
+    shownRobot = dataModel->selectedRobotID;
+
+    if(metric)
+        return;
+
+    if(type == ValueType::Double && plotted.size() == 1)
+    {
+        QString plottedKey = plotted[0].key;
+        clearPlotted();
+        plotValue(shownRobot, plottedKey);
+    }
+    else if(type == ValueType::Array)
+    {
+        detachSeries();
+        showBars();
+    }
+}
+
+/* dataChanged
+ * Slot. Called whenever the data model changes. Only notes what changed, the
+ * series are updated on the next call to update.
+ */
+void ChartModel::dataChanged(bool listChanged, QString robotId, std::vector<QString> changedData)
+{
+    if(metric)
+        return;
+
+    bool keyChanged = std::find(changedData.begin(), changedData.end(), key) != changedData.end();
+
+    if(histogramShown)
+    {
+        RobotData* robot = dataModel->getRobotByID(robotId);
+
+        if(listChanged)
+            histogramRecount = true;
+        else if(keyChanged && robot && robot->getValueType(key) == ValueType::Double)
+            histogram.set(robotId, robot->getDoubleValue(key));
+        else if(keyChanged)
+            histogram.remove(robotId);
+
+        return;
+    }
+
+    if(type == ValueType::String)
+    {
+        if(listChanged)
+            pieRecount = true;
+        else if(keyChanged)
+            pieChanged.insert(robotId);
+    }
+    else if(type == ValueType::Array && keyChanged && robotId == shownRobot)
+    {
+        barsChanged = true;
+    }
+}
+
+/* update
+ * Slot. Called periodically to add what changed since the last call to the
+ * series. Does nothing if no data arrived.
+ */
+void ChartModel::update(void)
+{
+    if(metric)
+    {
+        appendMetricSamples();
+    }
+    else if(histogramShown)
+    {
+        updateHistogram();
+    }
+    else if(type == ValueType::String && pieRecount)
+    {
+        recountPie();
+    }
+    else if(type == ValueType::String)
+    {
+        for(const QString& robotId : pieChanged)
+        {
+            RobotData* robot = dataModel->getRobotByID(robotId);
+            movePieRobot(robotId, robot ? pieValueOf(robot, key) : QString{});
+        }
+
+        pieChanged.clear();
+    }
+    else if(type == ValueType::Array && barsChanged)
+    {
+        updateBars();
+    }
+    else if(type == ValueType::Double)
+    {
+        // Appending to the lines is cheapest, they are only downsampled again
+        // when their width or window changes or they have grown by their width
+        bool redraw = getPlotWidth() != plottedWidth || Settings::instance()->getChartWindow() != plottedWindow;
+        for(const PlottedValue& value : plotted)
+            redraw = redraw || value.appended >= plottedWidth;
+
+        if(redraw)
+            drawPlotted();
+        else
+            appendPlotted();
+    }
+}
+
+/* reset
+ * Clear the chart before something else is shown on it.
+ */
+void ChartModel::reset(void)
+{
+    resetRobotColours();
+    clearPlotted();
+
+    histogramShown = false;
+    chart->setTitle(QString{});
+}
+
+/* detachSeries
+ * Take every series off the chart. The chart gives up ownership, so they
+ * are owned by the model again until they are shown next.
+ */
+void ChartModel::detachSeries(void)
+{
+    for(QtCharts::QAbstractSeries* series : chart->series())
+    {
+        chart->removeSeries(series);
+        series->setParent(this);
+    }
+}
+
+/* attachSeries
+ * Show a series on the chart, with new axes fitted to it.
+ */
+void ChartModel::attachSeries(QtCharts::QAbstractSeries* series)
+{
+    chart->addSeries(series);
+    chart->createDefaultAxes();
+}
+
+/* plotValue
+ * Add a line for a key of a robot, unless it is already drawn or the chart
+ * is full. The lines share one pair of axes, with a legend once there are
+ * several.
+ */
+void ChartModel::plotValue(const QString& robotId, const QString& key)
+{
+    if(plotted.size() >= MAX_PLOTTED_VALUES)
+        return;
+
+    for(const PlottedValue& value : plotted)
+    {
+        if(value.robotId == robotId && value.key == key)
+            return;
+    }
+
+    PlottedValue value;
+    value.robotId = robotId;
+    value.key = key;
+    value.newest = 0;
+    value.appended = 0;
+
+    value.line = new QtCharts::QLineSeries{this};
+    value.line->setUseOpenGL(true);
+    value.line->setName(robotId + " " + key);
+    value.line->setColor(colours[plotted.size() % CHART_COLOUR_COUNT]);
+
+    // Events involving the robot are marked on its line
+    value.events = new QtCharts::QScatterSeries{this};
+    value.events->setMarkerSize(8);
+    value.events->setColor(QColor{230, 25, 75});
+
+    plotted.push_back(value);
+
+    chart->addSeries(value.line);
+    attachSeries(value.events);
+
+    for(QtCharts::QLegendMarker* marker : chart->legend()->markers(value.events))
+        marker->setVisible(false);
+
+    chart->legend()->setVisible(plotted.size() > 1);
+
+    drawPlotted();
+}
+
+/* clearPlotted
+ * Take every series off the chart and delete the lines of robot values.
+ */
+void ChartModel::clearPlotted(void)
+{
+    detachSeries();
+
+    for(PlottedValue& value : plotted)
+    {
+        delete value.line;
+        delete value.events;
+    }
+
+    plotted.clear();
+    chart->legend()->hide();
+}
+
+/* drawPlotted
+ * Draw the chart window of every line from the value history, downsampled
+ * to one point per pixel of the plot area, and mark the events of each
+ * robot on its line. The window ends at the data model's time, the clock
+ * that both the samples and the events are stamped with. Between two calls
+ * samples are only appended, so this is the only place that scans the
+ * history and the only place the lines are replaced.
+ */
+void ChartModel::drawPlotted(void)
+{
+    const ValueHistory* history = dataModel->getValueHistory();
+    EventLog* eventLog = dataModel->getEventLog();
+
+    plottedWidth = getPlotWidth();
+    plottedWindow = Settings::instance()->getChartWindow();
+    plottedEnd = dataModel->getTime();
+    qint64 from = plottedEnd - (qint64)(plottedWindow * 1000);
+
+    for(PlottedValue& value : plotted)
+    {
+        const ValueSeries* series = history->getSeries(value.robotId, value.key);
+        value.range.clear();
+        value.newest = series && !series->empty() ? series->back().time : 0;
+        value.appended = 0;
+
+        QVector<QPointF> points;
+        QList<QPointF> markers;
+
+        if(series)
+        {
+            ValueHistory::downsample(*series, from, plottedEnd, plottedWidth, downsampled);
+
+            points.reserve(downsampled.size());
+            for(const ValueSample& sample : downsampled)
+            {
+                double x = (sample.time - epoch) / 1000.0;
+                points.append(QPointF{x, sample.value});
+                value.range.push(x, sample.value);
+            }
+
+            eventLog->query(from, plottedEnd, events, eventLog->getRobotNumber(value.robotId));
+            markEvents(*series, markers);
+        }
+
+        value.line->replace(points);
+        value.events->replace(markers);
+    }
+
+    fitPlotted();
+}
+
+/* appendPlotted
+ * Append every sample received since the last update to its line, at the
+ * time it arrived, mark the events logged since, and drop the points that
+ * have left the window. Nothing is done while no data arrives.
+ */
+void ChartModel::appendPlotted(void)
+{
+    qint64 end = dataModel->getTime();
+    if(end == plottedEnd)
+        return;
+
+    const ValueHistory* history = dataModel->getValueHistory();
+    EventLog* eventLog = dataModel->getEventLog();
+    qint64 since = plottedEnd;
+    plottedEnd = end;
+    double oldestX = (end - (qint64)(plottedWindow * 1000) - epoch) / 1000.0;
+
+    for(PlottedValue& value : plotted)
+    {
+        const ValueSeries* series = history->getSeries(value.robotId, value.key);
+
+        if(series && !series->empty() && series->back().time > value.newest)
+        {
+            auto first = std::upper_bound(series->begin(), series->end(), value.newest,
+                                          [](qint64 time, const ValueSample& sample){ return time < sample.time; });
+
+            QList<QPointF> points;
+            for(auto sample = first; sample != series->end(); ++sample)
+            {
+                double x = (sample->time - epoch) / 1000.0;
+                points.append(QPointF{x, sample->value});
+                value.range.push(x, sample->value);
+            }
+
+            value.line->append(points);
+            value.newest = series->back().time;
+            value.appended += points.size();
+        }
+
+        if(series)
+        {
+            QList<QPointF> markers;
+            eventLog->query(since + 1, end, events, eventLog->getRobotNumber(value.robotId));
+            markEvents(*series, markers);
+            value.events->append(markers);
+        }
+
+        removePointsBefore(value.line, oldestX);
+        removePointsBefore(value.events, oldestX);
+        value.range.expire(oldestX);
+
+        if(value.events->count() > (int)MAX_EVENT_MARKERS)
+            value.events->removePoints(0, value.events->count() - (int)MAX_EVENT_MARKERS);
+    }
+
+    fitPlotted();
+}
+
+/* markEvents
+ * Add a marker for each event found, at the value the line had when it
+ * happened. Only the newest events are marked.
+ */
+void ChartModel::markEvents(const ValueSeries& series, QList<QPointF>& markers)
+{
+    size_t first = events.size() > MAX_EVENT_MARKERS ? events.size() - MAX_EVENT_MARKERS : 0;
+
+    for(size_t i = first; i < events.size(); ++i)
+    {
+        const ValueSample* sample = ValueHistory::sampleAt(series, events[i].time);
+        if(sample)
+            markers.append(QPointF{(events[i].time - epoch) / 1000.0, sample->value});
+    }
+}
+
+/* fitPlotted
+ * Fit the axes to the window and to the smallest and largest value drawn on
+ * any line.
+ */
+void ChartModel::fitPlotted(void)
+{
+    double minY = std::numeric_limits<double>::max();
+    double maxY = -std::numeric_limits<double>::max();
+
+    for(const PlottedValue& value : plotted)
+    {
+        if(value.range.isEmpty())
+            continue;
+
+        minY = std::min(minY, value.range.getMin());
+        maxY = std::max(maxY, value.range.getMax());
+    }
+
+    double newestX = (plottedEnd - epoch) / 1000.0;
+    if(minY <= maxY)
+        setAxisRanges(chart, newestX - plottedWindow, newestX, minY, maxY);
+}
+
+/* getPlotWidth
+ * Width of the plot area in pixels, which lines are downsampled to.
+ */
+int ChartModel::getPlotWidth(void) const
+{
+    int width = (int)chart->plotArea().width();
+    return width < 3 ? DEFAULT_PLOT_WIDTH : width;
+}
+
+/* recountPie
+ * Count the value of every robot from scratch. Needed when robots join or
+ * leave, or a new key is charted.
+ */
+void ChartModel::recountPie(void)
+{
+    pie->clear();
+    pieValues.clear();
+    pieRobots.clear();
+    pieChanged.clear();
+    pieRecount = false;
+
+    for(int i = 0; i < dataModel->getRobotCount(); i++)
+    {
+        RobotData* robot = dataModel->getRobotByIndex(i);
+        movePieRobot(robot->getID(), pieValueOf(robot, key));
+    }
+}
+
+/* movePieRobot
+ * Count a robot under a new value, adjusting the two slices involved. A
+ * null value removes the robot. Slices are kept in order of their value and
+ * removed when no robot has it.
+ */
+void ChartModel::movePieRobot(const QString& robotId, const QString& value)
+{
+    auto previous = pieRobots.find(robotId);
+    if(previous != pieRobots.end())
+    {
+        if(previous.value() == value)
+            return;
+
+        auto old = pieValues.find(previous.value());
+        if(--old->count == 0)
+        {
+            pie->remove(old->slice);
+            pieValues.erase(old);
+        }
+        else
+        {
+            old->slice->setValue(old->count);
+            old->slice->setLabel(QString("%1 %2").arg(old->count).arg(old.key()));
+        }
+
+        pieRobots.erase(previous);
+    }
+
+    if(value.isNull())
+        return;
+
+    auto current = pieValues.find(value);
+    if(current == pieValues.end())
+    {
+        int index = std::distance(pieValues.begin(), pieValues.lowerBound(value));
+
+        QtCharts::QPieSlice* slice = new QtCharts::QPieSlice{};
+        slice->setLabelFont(QFont{"Arial", 8});
+        slice->setColor(getValueColour(value));
+        slice->setLabelVisible(true);
+        pie->insert(index, slice);
+
+        current = pieValues.insert(value, PieValue{slice, 0});
+    }
+
+    current->count++;
+    current->slice->setValue(current->count);
+    current->slice->setLabel(QString("%1 %2").arg(current->count).arg(value));
+    pieRobots.insert(robotId, value);
+
+    RobotData* robot = dataModel->getRobotByID(robotId);
+    if(robot)
+        robot->colour = getValueColour(value);
+}
+
+/* getValueColour
+ * Returns the colour of a value of the pie chart, which robots with that
+ * value are drawn in. Each new value takes the next colour.
+ */
+QColor ChartModel::getValueColour(const QString& value)
+{
+    if(!valueColours.contains(value))
+        valueColours[value] = colours[colourCounter++ % CHART_COLOUR_COUNT];
+
+    return valueColours[value];
+}
+
+/* resetRobotColours
+ * Draw every robot in white again, when the pie chart is no longer shown.
+ */
+void ChartModel::resetRobotColours(void)
+{
+    if(type != ValueType::String || metric)
+        return;
+
+    for(int i = 0; i < dataModel->getRobotCount(); i++)
+        dataModel->getRobotByIndex(i)->colour = QColor(255, 255, 255);
+}
+
+/* showBars
+ * Show the bars of the charted array of the selected robot.
+ */
+void ChartModel::showBars(void)
+{
+    if(barSet->count() > 0)
+        barSet->remove(0, barSet->count());
+
+    barsMax = 0;
+    updateBars();
+    attachSeries(bars);
+
+    if(chart->axisY())
+        chart->axisY()->setMax(barsMax * 1.05);
+}
+
+/* updateBars
+ * Show the numbers in the charted array of the selected robot, replacing
+ * the bars in place. The axes are only fitted again when the number of bars
+ * or the largest value seen grows.
+ */
+void ChartModel::updateBars(void)
+{
+    barsChanged = false;
+
+    RobotData* robot = dataModel->getRobotByID(shownRobot);
+    if(!robot || robot->getValueType(key) != ValueType::Array)
+        return;
+
+    int count = 0;
+    double previousMax = barsMax;
+    int previousCount = barSet->count();
+
+    for(const auto& item : robot->getArrayValue(key))
+    {
+        if(item.type != Double)
+            continue;
+
+        if(count < barSet->count())
+        {
+            if(barSet->at(count) != item.doubleValue)
+                barSet->replace(count, item.doubleValue);
+        }
+        else
+        {
+            barSet->append(item.doubleValue);
+        }
+
+        barsMax = std::max(barsMax, item.doubleValue);
+        count++;
+    }
+
+    if(count < barSet->count())
+        barSet->remove(count, barSet->count() - count);
+
+    if(!bars->chart())
+        return;
+
+    if(count != previousCount)
+        chart->createDefaultAxes();
+
+    if((count != previousCount || barsMax != previousMax) && chart->axisY())
+        chart->axisY()->setMax(barsMax * 1.05);
+}
+
+/* fillHistogram
+ * Count the charted number of every robot from scratch. Needed when robots
+ * join or leave, or a new key is charted.
+ */
+void ChartModel::fillHistogram(void)
+{
+    histogram.clear();
+    histogramRecount = false;
+
+    for(int i = 0; i < dataModel->getRobotCount(); i++)
+    {
+        RobotData* robot = dataModel->getRobotByIndex(i);
+        if(robot->getValueType(key) == ValueType::Double)
+            histogram.set(robot->getID(), robot->getDoubleValue(key));
+    }
+}
+
+/* updateHistogram
+ * Show the counts of the bins that changed, the bin edges if they moved,
+ * and the percentiles of the fleet.
+ */
+void ChartModel::updateHistogram(void)
+{
+    if(histogramRecount)
+        fillHistogram();
+
+    if(histogram.getVersion() == histogramVersion)
+        return;
+
+    histogramVersion = histogram.getVersion();
+
+    int largest = 1;
+    for(int i = 0; i < histogram.getBinCount(); ++i)
+    {
+        if(histogramSet->at(i) != histogram.getCount(i))
+            histogramSet->replace(i, histogram.getCount(i));
+
+        largest = std::max(largest, histogram.getCount(i));
+    }
+
+    auto axis = qobject_cast<QtCharts::QBarCategoryAxis*>(chart->axisX());
+    if(axis && histogram.getLayoutVersion() != histogramLayout)
+    {
+        QStringList labels;
+        for(int i = 0; i < histogram.getBinCount(); ++i)
+            labels.append(QString::number(histogram.getBinStart(i), 'g', 4));
+
+        axis->setCategories(labels);
+        histogramLayout = histogram.getLayoutVersion();
+    }
+
+    if(chart->axisY())
+        chart->axisY()->setRange(0, largest * 1.1);
+
+    if(histogram.getRobotCount() == 0)
+    {
+        chart->setTitle(key);
+        return;
+    }
+
+    chart->setTitle(QString("%1 over %2 robots: median %3, 90th %4, 99th %5")
+                    .arg(key).arg(histogram.getRobotCount())
+                    .arg(histogram.getQuantile(0.5), 0, 'g', 4)
+                    .arg(histogram.getQuantile(0.9), 0, 'g', 4)
+                    .arg(histogram.getQuantile(0.99), 0, 'g', 4));
+}
+
+/* loadMetricHistory
+ * Start the metric line again from the last minute of the history.
+ */
+void ChartModel::loadMetricHistory(void)
+{
+    metricLine->clear();
+    metricRange.clear();
+    metricNewest = 0;
+
+    appendMetricSamples();
+}
+
+/* appendMetricSamples
+ * Append the swarm metric samples newer than the last one shown, and drop
+ * those that have left the last minute.
+ */
+void ChartModel::appendMetricSamples(void)
+{
+    const auto& history = dataModel->getSwarmMetrics()->getHistory();
+    if(history.empty() || history.back().time <= metricNewest)
+        return;
+
+    qint64 oldest = history.back().time - (qint64)(METRIC_CHART_DURATION * 1000);
+    qint64 from = std::max(metricNewest + 1, oldest);
+    auto first = std::lower_bound(history.begin(), history.end(), from,
+                                  [](const SwarmMetricsSample& sample, qint64 time){ return sample.time < time; });
+
+    QList<QPointF> points;
+    for(auto sample = first; sample != history.end(); ++sample)
+    {
+        double x = (sample->time - epoch) / 1000.0;
+        double y = metric(*sample);
+        points.append(QPointF{x, y});
+        metricRange.push(x, y);
+    }
+
+    metricLine->append(points);
+    metricNewest = history.back().time;
+
+    double newestX = (metricNewest - epoch) / 1000.0;
+    double oldestX = newestX - METRIC_CHART_DURATION;
+
+    removePointsBefore(metricLine, oldestX);
+    metricRange.expire(oldestX);
+
+    if(metricLine->chart() && !metricRange.isEmpty())
+        setAxisRanges(chart, oldestX, newestX, metricRange.getMin(), metricRange.getMax());
+}
@@ -0,0 +1,153 @@
+#ifndef CHARTMODEL_H
+#define CHARTMODEL_H
+
+#include <QObject>
+#include <QString>
+#include <QColor>
+#include <QMap>
+#include <QHash>
+#include <QSet>
+
+#include <QtCharts/QChart>
+#include <QtCharts/QLineSeries>
+#include <QtCharts/QScatterSeries>
+#include <QtCharts/QPieSeries>
+#include <QtCharts/QBarSeries>
+#include <QtCharts/QBarSet>
+
+#include <vector>
+
+#include "../DataModel/datamodel.h"
+#include "../DataModel/slidingrange.h"
+#include "../DataModel/valuehistory.h"
+#include "../DataModel/fleethistogram.h"
+
+#define CHART_COLOUR_COUNT 10
+
+/* ChartModel
+ * Keeps the chart below the robot list up to date. The series are kept
+ * between updates rather than rebuilt: one pie series whose slices are
+ * adjusted for the robots whose value changed, one bar set, and a line for
+ * the swarm metric being charted, which only has new samples appended.
+ * Numbers of robots are drawn from the value history, up to twenty keys
+ * of any robots at once. Each line is downsampled to the width of the chart
+ * when it is shown, so that long windows cost no more to draw than short
+ * ones, and then has every sample received appended as it arrives. Lines
+ * are only downsampled again when the chart is resized, the window changes
+ * or a line has had as many samples appended as it has pixels. A number can also be
+ * shown as a histogram over the fleet, which moves each robot between bins
+ * as its value changes. The data model reports
+ * which robot and keys changed, so nothing is done while no data is
+ * arriving.
+ */
+class ChartModel : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef double (*MetricValue)(const SwarmMetricsSample&);
+
+    ChartModel(DataModel* dataModel, QtCharts::QChart* chart, QObject* parent = 0);
+
+    void showValue(QString key, ValueType type);
+    void addValue(QString robotId, QString key);
+    void showHistogram(QString key);
+    void showMetric(MetricValue value);
+    void selectedRobotChanged(void);
+
+public slots:
+    void dataChanged(bool listChanged, QString robotId, std::vector<QString> changedData);
+    void update(void);
+
+private:
+    // A key of a robot drawn as a line, the range of the values on it, the
+    // newest sample drawn and the samples appended since it was downsampled
+    struct PlottedValue
+    {
+        QString robotId;
+        QString key;
+        QtCharts::QLineSeries* line;
+        QtCharts::QScatterSeries* events;
+        SlidingRange range;
+        qint64 newest;
+        int appended;
+    };
+
+    // A value of the pie chart and the number of robots with it
+    struct PieValue
+    {
+        QtCharts::QPieSlice* slice;
+        int count;
+    };
+
+    void reset(void);
+    void detachSeries(void);
+    void attachSeries(QtCharts::QAbstractSeries* series);
+    void plotValue(const QString& robotId, const QString& key);
+    void clearPlotted(void);
+    void drawPlotted(void);
+    void appendPlotted(void);
+    void markEvents(const ValueSeries& series, QList<QPointF>& markers);
+    void fitPlotted(void);
+    int getPlotWidth(void) const;
+
+    void recountPie(void);
+    void movePieRobot(const QString& robotId, const QString& value);
+    QColor getValueColour(const QString& value);
+    void resetRobotColours(void);
+
+    void showBars(void);
+    void updateBars(void);
+
+    void fillHistogram(void);
+    void updateHistogram(void);
+
+    void loadMetricHistory(void);
+    void appendMetricSamples(void);
+
+    DataModel* dataModel;
+    QtCharts::QChart* chart;
+
+    QString key;
+    ValueType type;
+    MetricValue metric;
+    QString shownRobot;
+
+    std::vector<PlottedValue> plotted;
+    int plottedWidth;
+    double plottedWindow;
+    qint64 plottedEnd;
+    std::vector<ValueSample> downsampled;
+
+    QtCharts::QPieSeries* pie;
+    QMap<QString, PieValue> pieValues;
+    QHash<QString, QString> pieRobots;
+    QSet<QString> pieChanged;
+    bool pieRecount;
+
+    QtCharts::QBarSeries* bars;
+    QtCharts::QBarSet* barSet;
+    bool barsChanged;
+    double barsMax;
+
+    FleetHistogram histogram;
+    bool histogramShown;
+    bool histogramRecount;
+    QtCharts::QBarSeries* histogramBars;
+    QtCharts::QBarSet* histogramSet;
+    quint64 histogramVersion;
+    quint64 histogramLayout;
+
+    QtCharts::QLineSeries* metricLine;
+    SlidingRange metricRange;
+    qint64 metricNewest;
+
+    qint64 epoch;
+    std::vector<SwarmEvent> events;
+
+    QColor colours[CHART_COLOUR_COUNT];
+    QMap<QString, QColor> valueColours;
+    int colourCounter;
+};
+
+#endif // CHARTMODEL_H
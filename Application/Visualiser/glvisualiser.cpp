@@ -0,0 +1,451 @@
+/* glvisualiser.cpp
+ *
+ * OpenGL renderer for the visualiser, drawing all robots with one instanced
+ * draw call.
+ */
+
+#include "glvisualiser.h"
+#include "visualiser.h"
+#include "../Core/settings.h"
+#include "../Core/log.h"
+#include "../Core/latencymonitor.h"
+
+#include <QSurfaceFormat>
+#include <QPainter>
+#include <QtMath>
+
+#include <cmath>
+#include <cstddef>
+
+// Radius of a robot glyph in pixels, as drawn by VisPosition
+static const float GLYPH_RADIUS = 10;
+
+// Grey level drawn where there is no camera image
+static const float BACKGROUND_LEVEL = 200 / 255.0;
+
+// Distance from a click, as a proportion of the longer side of the arena,
+// within which a robot is selected
+static const double SELECTION_DISTANCE = 0.02;
+
+// Each glyph is a square around the robot, the ring and heading line are
+// cut out of it in the fragment shader
+static const char* GLYPH_VERTEX_SHADER = R"(
+#version 330 core
+layout(location = 0) in vec2 corner;
+layout(location = 1) in vec4 pose;
+layout(location = 2) in vec4 colour;
+
+uniform vec4 arenaRect;
+uniform vec2 viewport;
+uniform float radius;
+
+out vec2 local;
+out vec4 glyphColour;
+flat out vec2 heading;
+flat out float selected;
+
+void main()
+{
+    float extent = radius + 6.0;
+    vec2 centre = arenaRect.xy + pose.xy * arenaRect.zw;
+    vec2 pixel = centre + corner * extent;
+
+    local = corner * extent;
+    glyphColour = colour;
+    heading = vec2(cos(pose.z), sin(pose.z));
+    selected = pose.w;
+
+    gl_Position = vec4(2.0 * pixel.x / viewport.x - 1.0, 1.0 - 2.0 * pixel.y / viewport.y, 0.0, 1.0);
+}
+)";
+
+static const char* GLYPH_FRAGMENT_SHADER = R"(
+#version 330 core
+in vec2 local;
+in vec4 glyphColour;
+flat in vec2 heading;
+flat in float selected;
+
+uniform float radius;
+
+out vec4 fragColour;
+
+float segmentDistance(vec2 p, vec2 b)
+{
+    float h = clamp(dot(p, b) / dot(b, b), 0.0, 1.0);
+    return length(p - b * h);
+}
+
+void main()
+{
+    float ringWidth = selected > 0.5 ? 2.6 : 1.5;
+    float ring = abs(length(local) - radius);
+    float line = segmentDistance(local, heading * radius);
+
+    // Coloured ring and line inside a black border, anti-aliased over a pixel
+    float shape = min(ring - ringWidth, line - 1.5);
+    float border = min(ring - ringWidth - 1.5, line - 2.5);
+    float inner = 1.0 - smoothstep(-0.5, 0.5, shape);
+    float outer = 1.0 - smoothstep(-0.5, 0.5, border);
+
+    if(outer <= 0.0)
+        discard;
+
+    fragColour = vec4(glyphColour.rgb * inner, outer * glyphColour.a);
+}
+)";
+
+static const char* BACKGROUND_VERTEX_SHADER = R"(
+#version 330 core
+layout(location = 0) in vec2 corner;
+
+uniform vec4 arenaRect;
+uniform vec2 viewport;
+
+out vec2 uv;
+
+void main()
+{
+    uv = 0.5 * corner + 0.5;
+    vec2 pixel = arenaRect.xy + uv * arenaRect.zw;
+    gl_Position = vec4(2.0 * pixel.x / viewport.x - 1.0, 1.0 - 2.0 * pixel.y / viewport.y, 0.0, 1.0);
+}
+)";
+
+static const char* BACKGROUND_FRAGMENT_SHADER = R"(
+#version 330 core
+in vec2 uv;
+
+uniform sampler2D image;
+
+out vec4 fragColour;
+
+void main()
+{
+    fragColour = vec4(texture(image, uv).rgb, 1.0);
+}
+)";
+
+/* Constructor
+ * Request an OpenGL 3.3 core context. Nothing is allocated on the GPU until
+ * the context exists.
+ */
+GLVisualiser::GLVisualiser(DataModel* dataModelRef, VideoCompositor* compositor)
+{
+    this->dataModelRef = dataModelRef;
+    this->compositor = compositor;
+
+    glyphVertexArray = 0;
+    cornerBuffer = 0;
+    instanceBuffer = 0;
+    backgroundVertexArray = 0;
+    backgroundTexture = 0;
+    instanceCapacity = 0;
+    backgroundChanged = false;
+
+    QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    setFormat(format);
+
+    connect(compositor, SIGNAL(frameReady()), this, SLOT(newCompositedFrame()));
+}
+
+/* Destructor
+ * Release the GPU objects while the context still exists.
+ */
+GLVisualiser::~GLVisualiser()
+{
+    if(!context())
+        return;
+
+    makeCurrent();
+    glDeleteVertexArrays(1, &glyphVertexArray);
+    glDeleteVertexArrays(1, &backgroundVertexArray);
+    glDeleteBuffers(1, &cornerBuffer);
+    glDeleteBuffers(1, &instanceBuffer);
+    glDeleteTextures(1, &backgroundTexture);
+    doneCurrent();
+}
+
+/* refreshVisualisation
+ * Slot. Called when the data model changes, schedules a repaint.
+ */
+void GLVisualiser::refreshVisualisation()
+{
+    update();
+}
+
+/* newCompositedFrame
+ * Slot. Called when the compositor has finished a frame. The frame is
+ * uploaded on the next paint.
+ */
+void GLVisualiser::newCompositedFrame(void)
+{
+    if(compositor->swapBuffers())
+    {
+        backgroundChanged = true;
+        update();
+    }
+}
+
+/* initializeGL
+ * Override. Compile the shaders and set up the vertex arrays.
+ */
+void GLVisualiser::initializeGL()
+{
+    if(!initializeOpenGLFunctions())
+    {
+        Log::instance()->logMessage("OpenGL 3.3 core is not available, the OpenGL visualiser cannot draw", true);
+        return;
+    }
+
+    if(!glyphProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, GLYPH_VERTEX_SHADER) ||
+       !glyphProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, GLYPH_FRAGMENT_SHADER) ||
+       !glyphProgram.link())
+        Log::instance()->logMessage("Could not build the robot shader: " + glyphProgram.log(), true);
+
+    if(!backgroundProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, BACKGROUND_VERTEX_SHADER) ||
+       !backgroundProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, BACKGROUND_FRAGMENT_SHADER) ||
+       !backgroundProgram.link())
+        Log::instance()->logMessage("Could not build the background shader: " + backgroundProgram.log(), true);
+
+    static const GLfloat corners[] = {-1, -1, 1, -1, -1, 1, 1, 1};
+
+    glGenBuffers(1, &cornerBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, cornerBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+
+    // Glyphs share the corners and step through the instance buffer once per robot
+    glGenVertexArrays(1, &glyphVertexArray);
+    glBindVertexArray(glyphVertexArray);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), (void*)offsetof(GlyphInstance, x));
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), (void*)offsetof(GlyphInstance, colour));
+    glVertexAttribDivisor(2, 1);
+
+    glGenVertexArrays(1, &backgroundVertexArray);
+    glBindVertexArray(backgroundVertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, cornerBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenTextures(1, &backgroundTexture);
+    glBindTexture(GL_TEXTURE_2D, backgroundTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    backgroundChanged = true;
+}
+
+/* resizeGL
+ * Override. The compositor prepares frames at the new size.
+ */
+void GLVisualiser::resizeGL(int, int)
+{
+    compositor->setDisplaySize(this->size());
+}
+
+/* arenaRect
+ * Returns the widget area the arena is drawn in. This is the arena fitted
+ * and centred in the widget, or the whole widget before the first frame.
+ * This visualiser is not zoomed.
+ */
+QRectF GLVisualiser::arenaRect(void)
+{
+    return VideoCompositor::arenaRect(size(), compositor->getFrontSourceSize(), 1, QPointF{0.5, 0.5});
+}
+
+/* uploadBackground
+ * Copy the front buffer of the compositor into the background texture. The
+ * buffer is already in BGRA order, so no conversion is needed.
+ */
+void GLVisualiser::uploadBackground(void)
+{
+    const QImage& backgroundImage = compositor->getFrontBuffer();
+    backgroundChanged = false;
+
+    if(backgroundImage.isNull())
+        return;
+
+    glBindTexture(GL_TEXTURE_2D, backgroundTexture);
+
+    if(backgroundImage.size() != backgroundSize)
+    {
+        backgroundSize = backgroundImage.size();
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, backgroundSize.width(), backgroundSize.height(), 0, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, backgroundImage.bytesPerLine() / 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, backgroundSize.width(), backgroundSize.height(), GL_BGRA, GL_UNSIGNED_BYTE, backgroundImage.constBits());
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/* fillInstance
+ * Returns the per robot data of the instanced draw call for a robot. Robots
+ * tracked with low confidence are drawn faded.
+ */
+GLVisualiser::GlyphInstance GLVisualiser::fillInstance(RobotData* robot, bool selected)
+{
+    Pose pose = robot->getPos();
+
+    GlyphInstance instance;
+    instance.x = pose.position.x;
+    instance.y = pose.position.y;
+    instance.angle = qDegreesToRadians(robot->getAngle());
+    instance.selected = selected ? 1 : 0;
+    instance.colour[0] = robot->colour.redF();
+    instance.colour[1] = robot->colour.greenF();
+    instance.colour[2] = robot->colour.blueF();
+    instance.colour[3] = 0.25 + 0.75 * robot->getTrackingConfidence();
+
+    return instance;
+}
+
+/* paintGL
+ * Override. Draw the camera image, then every robot in one draw call, then
+ * the text of the selected robot with QPainter.
+ */
+void GLVisualiser::paintGL()
+{
+    glClearColor(BACKGROUND_LEVEL, BACKGROUND_LEVEL, BACKGROUND_LEVEL, 1);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if(!glyphProgram.isLinked() || !backgroundProgram.isLinked())
+        return;
+
+    if(backgroundChanged)
+        uploadBackground();
+
+    QRectF arena = arenaRect();
+
+    if(!backgroundSize.isEmpty())
+    {
+        // The image covers the region of the arena it was prepared for
+        QRectF region = compositor->getFrontRegion();
+        QRectF imageRect{arena.x() + arena.width() * region.x(), arena.y() + arena.height() * region.y(),
+                         arena.width() * region.width(), arena.height() * region.height()};
+
+        backgroundProgram.bind();
+        backgroundProgram.setUniformValue("arenaRect", (float)imageRect.x(), (float)imageRect.y(), (float)imageRect.width(), (float)imageRect.height());
+        backgroundProgram.setUniformValue("viewport", (float)width(), (float)height());
+        backgroundProgram.setUniformValue("image", 0);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, backgroundTexture);
+        glBindVertexArray(backgroundVertexArray);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        backgroundProgram.release();
+    }
+
+    // The selected robot is added last so that it is drawn on top
+    const auto& selectedId = dataModelRef->selectedRobotID;
+    RobotData* selectedRobot = nullptr;
+    instances.clear();
+
+    for(int i = 0; i < dataModelRef->getRobotCount(); ++i)
+    {
+        RobotData* robot = dataModelRef->getRobotByIndex(i);
+
+        if(robot->getID() == selectedId)
+        {
+            selectedRobot = robot;
+            continue;
+        }
+
+        instances.push_back(fillInstance(robot, false));
+    }
+
+    if(selectedRobot)
+        instances.push_back(fillInstance(selectedRobot, true));
+
+    if(!instances.empty())
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+        // Grow the buffer by doubling, otherwise only replace its contents
+        if((int)instances.size() > instanceCapacity)
+        {
+            instanceCapacity = std::max<int>(instances.size(), 2 * instanceCapacity);
+            glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(GlyphInstance), nullptr, GL_STREAM_DRAW);
+        }
+
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(GlyphInstance), instances.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glyphProgram.bind();
+        glyphProgram.setUniformValue("arenaRect", (float)arena.x(), (float)arena.y(), (float)arena.width(), (float)arena.height());
+        glyphProgram.setUniformValue("viewport", (float)width(), (float)height());
+        glyphProgram.setUniformValue("radius", GLYPH_RADIUS);
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glBindVertexArray(glyphVertexArray);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instances.size());
+        glDisable(GL_BLEND);
+        glyphProgram.release();
+    }
+
+    glBindVertexArray(0);
+
+    // Text is rare, QPainter draws it over the OpenGL output
+    bool overlay = Settings::instance()->isLatencyOverlayEnabled();
+    if(selectedRobot || overlay)
+    {
+        QPainter painter(this);
+
+        QPen pen{QColor{255, 255, 255}};
+        pen.setWidth(3);
+        painter.setPen(pen);
+
+        if(selectedRobot)
+        {
+            textVis.describeRobot(selectedRobot);
+            textVis.render(this, &painter, selectedRobot, true, arena);
+        }
+
+        if(overlay)
+            Visualiser::renderLatencyOverlay(painter);
+
+        painter.end();
+    }
+
+    LatencyMonitor::instance()->framePainted();
+}
+
+/* mousePressEvent
+ * Captures mouse presses when the mouse is within the visualiser bounds.
+ */
+void GLVisualiser::mousePressEvent(QMouseEvent* event)
+{
+    QRectF arena = arenaRect();
+
+    // Calculate x and y values as proportions of the image
+    double x = (event->x() - arena.x()) / arena.width();
+    double y = (event->y() - arena.y()) / arena.height();
+
+    // Select the closest robot within a threshold of the click
+    std::vector<RobotData*> nearest;
+    dataModelRef->getSpatialIndex()->nearest(x, y, 1, SELECTION_DISTANCE, nearest);
+
+    if(!nearest.empty())
+    {
+        // Signal that a robot has been selected
+        emit robotSelectedInVisualiser(nearest.front()->getID());
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef GLVISUALISER_H
+#define GLVISUALISER_H
+
+#include <QOpenGLWidget>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShaderProgram>
+#include <QMouseEvent>
+
+#include <vector>
+
+#include "../DataModel/datamodel.h"
+#include "videocompositor.h"
+#include "vistext.h"
+
+/* GLVisualiser
+ * OpenGL version of the visualiser. The camera image is drawn as a texture
+ * and every robot is drawn by one instanced draw call from an array of robot
+ * poses, so the cost per robot is a few floats rather than several QPainter
+ * calls. Only OpenGL 3.3 core is needed, which Mesa's llvmpipe software
+ * rasteriser provides.
+ */
+class GLVisualiser : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
+{
+    Q_OBJECT
+
+public:
+    GLVisualiser(DataModel* dataModelRef, VideoCompositor* compositor);
+    ~GLVisualiser();
+
+    QSize minimumSizeHint () const { return QSize(200, 200); }
+
+public slots:
+    void refreshVisualisation();
+    void newCompositedFrame(void);
+
+signals:
+    void robotSelectedInVisualiser(QString id);
+
+protected:
+    void initializeGL();
+    void resizeGL(int width, int height);
+    void paintGL();
+
+    void mousePressEvent(QMouseEvent*);
+
+private:
+    // Per robot data uploaded for the instanced draw call
+    struct GlyphInstance
+    {
+        float x;
+        float y;
+        float angle;
+        float selected;
+        float colour[4];
+    };
+
+    QRectF arenaRect(void);
+    void uploadBackground(void);
+    GlyphInstance fillInstance(RobotData* robot, bool selected);
+
+    DataModel* dataModelRef;
+    VideoCompositor* compositor;
+    VisText textVis;
+
+    QOpenGLShaderProgram glyphProgram;
+    QOpenGLShaderProgram backgroundProgram;
+
+    GLuint glyphVertexArray;
+    GLuint cornerBuffer;
+    GLuint instanceBuffer;
+    GLuint backgroundVertexArray;
+    GLuint backgroundTexture;
+
+    int instanceCapacity;
+    std::vector<GlyphInstance> instances;
+
+    bool backgroundChanged;
+    QSize backgroundSize;
+};
+
+#endif // GLVISUALISER_H
@@ -0,0 +1,261 @@
+/* videocompositor.cpp
+ *
+ * Prepares the camera image shown behind the visualisation, away from the
+ * GUI thread.
+ */
+
+#include "videocompositor.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// Grey level shown where no camera image is available
+static const int BACKGROUND_LEVEL = 200;
+
+/* Constructor
+ * Subscribe to the frames of every camera of the rig. Called on the GUI
+ * thread before the compositor is moved to its own, with whether video is
+ * shown and the size the first frames are composited at.
+ */
+VideoCompositor::VideoCompositor(CameraRig* cameraRig, bool videoEnabled, QSize displaySize)
+    : videoEnabled(videoEnabled), displaySize(displaySize)
+{
+    front = 0;
+    ready = 1;
+    back = 2;
+    readyIsNew = false;
+    viewZoom = 1;
+    viewCentre = QPointF{0.5, 0.5};
+
+    for(int i = 0; i < cameraRig->getCameraCount(); ++i)
+    {
+        CompositorCamera c;
+        c.camera = cameraRig->getCamera(i);
+        c.calibration = cameraRig->getCalibration(i);
+        cameras.push_back(c);
+
+        connect(c.camera, SIGNAL(newVideoFrame(cv::Mat&, FrameInfo)), this, SLOT(newVideoFrame(cv::Mat&, FrameInfo)));
+    }
+}
+
+/* setDisplaySize
+ * Sets the size of the widget the frames are shown in. Called from the GUI
+ * thread, the next frame is composited at the new size.
+ */
+void VideoCompositor::setDisplaySize(QSize size)
+{
+    QMutexLocker lock{&mutex};
+    displaySize = size;
+}
+
+/* setView
+ * Sets the zoom of the visualiser and the point of the arena, as proportions,
+ * at the centre of the widget. Called from the GUI thread.
+ */
+void VideoCompositor::setView(double zoom, QPointF centre)
+{
+    QMutexLocker lock{&mutex};
+    viewZoom = zoom;
+    viewCentre = centre;
+}
+
+/* arenaRect
+ * Returns where the whole arena lies in widget coordinates. At a zoom of one
+ * it is as large as fits in the widget, and the centre point of the arena,
+ * as proportions, is placed at the centre of the widget.
+ */
+QRectF VideoCompositor::arenaRect(QSizeF widgetSize, QSizeF sourceSize, double zoom, QPointF centre)
+{
+    if(sourceSize.isEmpty())
+        return QRectF{QPointF{0, 0}, widgetSize};
+
+    double scale = zoom * std::min(widgetSize.width() / sourceSize.width(), widgetSize.height() / sourceSize.height());
+    QSizeF size = sourceSize * scale;
+
+    return QRectF{0.5 * widgetSize.width() - centre.x() * size.width(),
+                  0.5 * widgetSize.height() - centre.y() * size.height(),
+                  size.width(), size.height()};
+}
+
+/* swapBuffers
+ * Make the newest finished frame the front buffer. Returns false if no frame
+ * has been finished since the last swap.
+ */
+bool VideoCompositor::swapBuffers(void)
+{
+    QMutexLocker lock{&mutex};
+
+    if(!readyIsNew)
+        return false;
+
+    std::swap(front, ready);
+    readyIsNew = false;
+    return true;
+}
+
+/* newVideoFrame
+ * Slot. Called with each frame of each camera. Without a calibration only the
+ * first camera is shown. With one, every calibrated camera is warped into its
+ * part of the arena view.
+ */
+void VideoCompositor::newVideoFrame(cv::Mat& image, FrameInfo)
+{
+    ARCameraThread* source = qobject_cast<ARCameraThread*>(sender());
+    auto match = std::find_if(cameras.begin(), cameras.end(), [&](const CompositorCamera& c){ return c.camera == source; });
+    if(match == cameras.end())
+        return;
+
+    CompositorCamera& camera = *match;
+    bool arenaView = cameras[0].calibration->isValid();
+    bool shown = arenaView ? camera.calibration->isValid() : &camera == &cameras[0];
+
+    if(shown && !image.empty())
+    {
+        QSize widgetSize;
+        double zoom;
+        QPointF centre;
+        {
+            QMutexLocker lock{&mutex};
+            widgetSize = displaySize;
+            zoom = viewZoom;
+            centre = viewCentre;
+        }
+
+        double sourceWidth = arenaView ? camera.calibration->getArenaSize().x : image.cols;
+        double sourceHeight = arenaView ? camera.calibration->getArenaSize().y : image.rows;
+        QSizeF sourceSize{sourceWidth, sourceHeight};
+
+        // Only the part of the arena inside the widget is prepared, at its size on screen
+        QRectF arena = arenaRect(widgetSize, sourceSize, zoom, centre);
+        QRectF visible = arena.intersected(QRectF{QPointF{0, 0}, QSizeF(widgetSize)});
+
+        if(visible.width() >= 1 && visible.height() >= 1)
+        {
+            cv::Rect2d region{(visible.x() - arena.x()) / arena.width(), (visible.y() - arena.y()) / arena.height(),
+                              visible.width() / arena.width(), visible.height() / arena.height()};
+            cv::Size outputSize{qRound(visible.width()), qRound(visible.height())};
+
+            QImage& target = buffers[back];
+            if(target.width() != outputSize.width || target.height() != outputSize.height)
+                target = QImage(outputSize.width, outputSize.height, QImage::Format_RGB32);
+
+            regions[back] = QRectF{region.x, region.y, region.width, region.height};
+            sourceSizes[back] = sourceSize;
+
+            // Format_RGB32 is laid out as BGRA in memory, so OpenCV writes it directly
+            cv::Mat targetPixels(target.height(), target.width(), CV_8UC4, target.bits(), target.bytesPerLine());
+            int conversion = image.channels() == 1 ? cv::COLOR_GRAY2BGRA : cv::COLOR_BGR2BGRA;
+
+            if(!videoEnabled)
+            {
+                targetPixels.setTo(cv::Scalar::all(BACKGROUND_LEVEL));
+            }
+            else if(!arenaView)
+            {
+                scaleRegion(image, camera.thumbnail, outputSize, region);
+                cv::cvtColor(camera.thumbnail, targetPixels, conversion);
+            }
+            else if(cameras.size() == 1)
+            {
+                camera.calibration->warpToArena(image, camera.thumbnail, outputSize, region);
+                cv::cvtColor(camera.thumbnail, targetPixels, conversion);
+            }
+            else
+            {
+                // The canvas keeps the newest image of every camera in the arena view
+                if(canvas.size() != outputSize || canvasRegion != region)
+                {
+                    canvas = cv::Mat(outputSize, CV_8UC4, cv::Scalar::all(BACKGROUND_LEVEL));
+                    canvasRegion = region;
+                }
+
+                updateCoverage(camera, image.size(), outputSize, region);
+                camera.calibration->warpToArena(image, camera.thumbnail, outputSize, region);
+                cv::cvtColor(camera.thumbnail, converted, conversion);
+                converted.copyTo(canvas, camera.coverage);
+                canvas.copyTo(targetPixels);
+            }
+
+            publishBackBuffer();
+        }
+    }
+
+    waitForFrame(camera.camera);
+}
+
+/* scaleRegion
+ * Crop a region of an image, given as proportions of its size, and scale it
+ * to the output size. Shrinking averages whole source pixels. Enlarging
+ * interpolates at the exact sub-pixel position of the region, because one
+ * source pixel may cover many screen pixels.
+ */
+void VideoCompositor::scaleRegion(const cv::Mat& image, cv::Mat& output, cv::Size outputSize, cv::Rect2d region)
+{
+    double scaleX = region.width * image.cols / outputSize.width;
+    double scaleY = region.height * image.rows / outputSize.height;
+
+    if(scaleX >= 1 && scaleY >= 1)
+    {
+        cv::Rect crop{(int)(region.x * image.cols), (int)(region.y * image.rows),
+                      std::max(1, (int)std::round(region.width * image.cols)), std::max(1, (int)std::round(region.height * image.rows))};
+        crop &= cv::Rect{0, 0, image.cols, image.rows};
+        cv::resize(image(crop), output, outputSize, 0, 0, cv::INTER_AREA);
+        return;
+    }
+
+    // Maps each output pixel centre back to the image
+    cv::Matx23d outputToImage{scaleX, 0, region.x * image.cols + 0.5 * scaleX - 0.5,
+                              0, scaleY, region.y * image.rows + 0.5 * scaleY - 0.5};
+    cv::warpAffine(image, output, outputToImage, outputSize, cv::INTER_LINEAR | cv::WARP_INVERSE_MAP,
+                   cv::BORDER_CONSTANT, cv::Scalar::all(BACKGROUND_LEVEL));
+}
+
+/* updateCoverage
+ * Work out which pixels of the arena view a camera can see, by warping a
+ * white image through its calibration. Only redone when a size or the
+ * region changes.
+ */
+void VideoCompositor::updateCoverage(CompositorCamera& camera, cv::Size imageSize, cv::Size outputSize, cv::Rect2d region)
+{
+    if(camera.coverage.size() == outputSize && camera.coverageImageSize == imageSize && camera.coverageRegion == region)
+        return;
+
+    cv::Mat white(imageSize, CV_8UC1, cv::Scalar::all(255));
+    camera.calibration->warpToArena(white, camera.coverage, outputSize, region);
+
+    // Pixels blended with the border are left to the other cameras
+    cv::threshold(camera.coverage, camera.coverage, 254, 255, cv::THRESH_BINARY);
+    camera.coverageImageSize = imageSize;
+    camera.coverageRegion = region;
+}
+
+/* publishBackBuffer
+ * Hand the finished back buffer to the GUI thread. The GUI is only told once
+ * until it has taken the frame, newer frames replace it in the meantime.
+ */
+void VideoCompositor::publishBackBuffer(void)
+{
+    bool notify;
+
+    {
+        QMutexLocker lock{&mutex};
+        std::swap(back, ready);
+        notify = !readyIsNew;
+        readyIsNew = true;
+    }
+
+    if(notify)
+        emit frameReady();
+}
+
+/* waitForFrame
+ * Ask a camera for its next frame once this one has been composited.
+ */
+void VideoCompositor::waitForFrame(ARCameraThread* camera)
+{
+    camera->addPreEmitCall([this, camera](){
+        connect(camera, SIGNAL(newVideoFrame(cv::Mat&, FrameInfo)), this, SLOT(newVideoFrame(cv::Mat&, FrameInfo)));
+    });
+}
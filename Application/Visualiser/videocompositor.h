@@ -0,0 +1,92 @@
+#ifndef VIDEOCOMPOSITOR_H
+#define VIDEOCOMPOSITOR_H
+
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QRectF>
+#include <QMutex>
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+#include "Application/Tracking/camerarig.h"
+
+/* VideoCompositor
+ * Turns camera frames into the visualiser background on its own thread. The
+ * frames are scaled, or warped into the arena view and combined when several
+ * calibrated cameras are used, and converted to the widget's native pixel
+ * format. Three buffers are used: the GUI thread draws the front buffer, the
+ * compositor writes the back buffer, and finished frames wait in between, so
+ * neither side ever waits for the other for more than a pointer swap.
+ * When the view is zoomed in, only the part of the arena inside the widget is
+ * cropped from the camera image and scaled.
+ */
+class VideoCompositor : public QObject
+{
+    Q_OBJECT
+
+public:
+    VideoCompositor(CameraRig* cameraRig, bool videoEnabled, QSize displaySize);
+
+    void setDisplaySize(QSize size);
+    void setView(double zoom, QPointF centre);
+
+    static QRectF arenaRect(QSizeF widgetSize, QSizeF sourceSize, double zoom, QPointF centre);
+
+    // GUI thread only
+    bool swapBuffers(void);
+    const QImage& getFrontBuffer(void) const { return buffers[front]; }
+    QRectF getFrontRegion(void) const { return regions[front]; }
+    QSizeF getFrontSourceSize(void) const { return sourceSizes[front]; }
+
+public slots:
+    void newVideoFrame(cv::Mat& image, FrameInfo info);
+
+signals:
+    void frameReady(void);
+
+private:
+    struct CompositorCamera
+    {
+        ARCameraThread* camera;
+        CameraCalibration* calibration;
+        cv::Mat thumbnail;
+
+        // Part of the arena view this camera can see, and the sizes and region it was built for
+        cv::Mat coverage;
+        cv::Size coverageImageSize;
+        cv::Rect2d coverageRegion;
+    };
+
+    void waitForFrame(ARCameraThread* camera);
+    void updateCoverage(CompositorCamera& camera, cv::Size imageSize, cv::Size outputSize, cv::Rect2d region);
+    void scaleRegion(const cv::Mat& image, cv::Mat& output, cv::Size outputSize, cv::Rect2d region);
+    void publishBackBuffer(void);
+
+    std::vector<CompositorCamera> cameras;
+
+    // Fixed when constructed, so the compositor thread never reads the settings
+    const bool videoEnabled;
+
+    // Each buffer holds the region of the arena it shows, as proportions,
+    // and the size of the whole arena image it was taken from
+    QImage buffers[3];
+    QRectF regions[3];
+    QSizeF sourceSizes[3];
+    int front;
+    int ready;
+    int back;
+    bool readyIsNew;
+
+    QMutex mutex;
+    QSize displaySize;
+    double viewZoom;
+    QPointF viewCentre;
+
+    cv::Mat canvas;
+    cv::Rect2d canvasRegion;
+    cv::Mat converted;
+};
+
+#endif // VIDEOCOMPOSITOR_H
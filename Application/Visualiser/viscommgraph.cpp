@@ -0,0 +1,65 @@
+/* viscommgraph.cpp
+ *
+ * This class encapsulates the visualisation of which robots are within
+ * communication range of each other.
+ *
+ */
+
+#include "viscommgraph.h"
+#include "../Core/settings.h"
+
+#include <QPainter>
+
+/* Constructor
+ * Initialise all setttings.
+ */
+VisCommGraph::VisCommGraph(const CommGraph* graph) {
+    this->graph = graph;
+    setEnabled(true);
+}
+
+/* toString
+ * Generate a string describing all settings.
+ */
+QString VisCommGraph::toString(void) {
+    return QString("Communication");
+}
+
+/* render
+ * Nothing is drawn per robot.
+ */
+void VisCommGraph::render(QWidget*, QPainter*, RobotData*, bool, QRectF) {
+}
+
+/* renderBackground
+ * Draw a line between every pair of robots in communication range, under
+ * the robots, in a single call.
+ */
+void VisCommGraph::renderBackground(QWidget*, QPainter* painter, QRectF rect) {
+    if (!isEnabled() || !(Settings::instance()->getCommRadius() > 0)) {
+        return;
+    }
+
+    graph->getEdges(edges);
+    lines.resize(0);
+    lines.reserve(edges.size());
+
+    for (auto& edge : edges) {
+        Pose a = edge.first->getPos();
+        Pose b = edge.second->getPos();
+        lines.append(QLineF{rect.x() + rect.width() * a.position.x, rect.y() + rect.height() * a.position.y,
+                            rect.x() + rect.width() * b.position.x, rect.y() + rect.height() * b.position.y});
+    }
+
+    painter->save();
+    painter->setPen(QPen{QColor{0, 130, 200, 128}, 1});
+    painter->drawLines(lines);
+    painter->restore();
+}
+
+/* getSettingsDialog
+ * Return a pointer to the settings dialog for this visualisation.
+ */
+QDialog* VisCommGraph::getSettingsDialog(void) {
+    return NULL;
+}
@@ -0,0 +1,31 @@
+#ifndef VISCOMMGRAPH_H
+#define VISCOMMGRAPH_H
+
+#include "viselement.h"
+#include "../DataModel/commgraph.h"
+
+#include <QVector>
+#include <QLineF>
+
+#include <utility>
+#include <vector>
+
+class VisCommGraph : public VisElement
+{
+    const CommGraph* graph;
+
+    std::vector<std::pair<RobotData*, RobotData*>> edges;
+    QVector<QLineF> lines;
+
+public:
+    VisCommGraph(const CommGraph* graph);
+
+    virtual QString toString(void);
+
+    virtual void render(QWidget* widget, QPainter* painter, RobotData *robot, bool selected, QRectF rect);
+    virtual void renderBackground(QWidget* widget, QPainter* painter, QRectF rect);
+
+    virtual QDialog* getSettingsDialog(void);
+};
+
+#endif // VISCOMMGRAPH_H
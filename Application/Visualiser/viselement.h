@@ -18,6 +18,9 @@ public:
     bool isEnabled(void) { return enabled; }
 
     virtual void render(QWidget* widget, QPainter* painter, RobotData* robot, bool selected, QRectF rect) = 0;
+
+    // Called once per paint, before any robot is drawn, for whole arena overlays
+    virtual void renderBackground(QWidget*, QPainter*, QRectF) { }
 };
 
 Q_DECLARE_METATYPE(VisElement*)
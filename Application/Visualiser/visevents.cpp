@@ -0,0 +1,96 @@
+/* visevents.cpp
+ *
+ * This class encapsulates the visualisation of recent proximity and arena
+ * events.
+ *
+ */
+
+#include "visevents.h"
+
+#include <QPainter>
+
+#include <algorithm>
+
+// How long, in milliseconds, a marker stays on screen while it fades
+static const qint64 EVENT_MARKER_DURATION = 5000;
+
+// Most markers drawn, the newest are kept
+static const size_t MAX_EVENT_MARKERS = 2000;
+
+// Size of a marker in pixels
+static const double EVENT_MARKER_SIZE = 8;
+
+/* Constructor
+ * Initialise all setttings.
+ */
+VisEvents::VisEvents(DataModel* dataModel) {
+    this->dataModel = dataModel;
+    setEnabled(true);
+}
+
+/* toString
+ * Generate a string describing all settings.
+ */
+QString VisEvents::toString(void) {
+    return QString("Events");
+}
+
+/* render
+ * Nothing is drawn per robot.
+ */
+void VisEvents::render(QWidget*, QPainter*, RobotData*, bool, QRectF) {
+}
+
+/* renderBackground
+ * Mark where recent events happened, under the robots. Two robots coming
+ * close is a red ring, and a robot leaving the arena an orange cross. The
+ * markers fade out as they age, on the clock the events were logged with,
+ * so they keep pace with a video played faster than real time. Separations
+ * and robots entering the arena are not marked.
+ */
+void VisEvents::renderBackground(QWidget*, QPainter* painter, QRectF rect) {
+    if (!isEnabled()) {
+        return;
+    }
+
+    qint64 now = dataModel->getTime();
+    dataModel->getEventLog()->query(now - EVENT_MARKER_DURATION, now, recent);
+
+    size_t first = recent.size() > MAX_EVENT_MARKERS ? recent.size() - MAX_EVENT_MARKERS : 0;
+
+    painter->save();
+    painter->setBrush(Qt::NoBrush);
+
+    for (size_t i = first; i < recent.size(); i++) {
+        const SwarmEvent& event = recent[i];
+
+        if (event.type != EVENT_PROXIMITY && event.type != EVENT_LEFT_ARENA) {
+            continue;
+        }
+
+        double age = std::min(1.0, std::max(0.0, (now - event.time) / (double)EVENT_MARKER_DURATION));
+        QPointF centre{rect.x() + rect.width() * event.x, rect.y() + rect.height() * event.y};
+        QColor colour = event.type == EVENT_PROXIMITY ? QColor{230, 25, 75} : QColor{245, 130, 48};
+        colour.setAlphaF(1 - age);
+
+        QPen pen{colour};
+        pen.setWidthF(2);
+        painter->setPen(pen);
+
+        if (event.type == EVENT_PROXIMITY) {
+            painter->drawEllipse(centre, EVENT_MARKER_SIZE, EVENT_MARKER_SIZE);
+        } else {
+            painter->drawLine(centre + QPointF{-EVENT_MARKER_SIZE, -EVENT_MARKER_SIZE}, centre + QPointF{EVENT_MARKER_SIZE, EVENT_MARKER_SIZE});
+            painter->drawLine(centre + QPointF{-EVENT_MARKER_SIZE, EVENT_MARKER_SIZE}, centre + QPointF{EVENT_MARKER_SIZE, -EVENT_MARKER_SIZE});
+        }
+    }
+
+    painter->restore();
+}
+
+/* getSettingsDialog
+ * Return a pointer to the settings dialog for this visualisation.
+ */
+QDialog* VisEvents::getSettingsDialog(void) {
+    return NULL;
+}
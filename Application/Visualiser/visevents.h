@@ -0,0 +1,25 @@
+#ifndef VISEVENTS_H
+#define VISEVENTS_H
+
+#include "viselement.h"
+#include "../DataModel/datamodel.h"
+
+#include <vector>
+
+class VisEvents : public VisElement
+{
+    DataModel* dataModel;
+    std::vector<SwarmEvent> recent;
+
+public:
+    VisEvents(DataModel* dataModel);
+
+    virtual QString toString(void);
+
+    virtual void render(QWidget* widget, QPainter* painter, RobotData *robot, bool selected, QRectF rect);
+    virtual void renderBackground(QWidget* widget, QPainter* painter, QRectF rect);
+
+    virtual QDialog* getSettingsDialog(void);
+};
+
+#endif // VISEVENTS_H
@@ -0,0 +1,145 @@
+/* visoccupancy.cpp
+ *
+ * This class encapsulates the visualisation of where robots have spent
+ * their time.
+ *
+ */
+
+#include "visoccupancy.h"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <cmath>
+
+/* Constructor
+ * Initialise all setttings. Off until enabled.
+ */
+VisOccupancy::VisOccupancy(OccupancyGrid* grid) {
+    this->grid = grid;
+    setEnabled(false);
+}
+
+/* toString
+ * Generate a string describing all settings.
+ */
+QString VisOccupancy::toString(void) {
+    return QString("Occupancy");
+}
+
+/* render
+ * Nothing is drawn per robot.
+ */
+void VisOccupancy::render(QWidget*, QPainter*, RobotData*, bool, QRectF) {
+}
+
+/* renderBackground
+ * Draw the occupancy map over the arena. The scaled map is kept between
+ * paints and only the tiles that gained time are recoloured and redrawn, so
+ * a paint is normally a single copy of the map. Only the part of the arena
+ * inside the widget is kept, so zooming in does not enlarge the map.
+ */
+void VisOccupancy::renderBackground(QWidget* widget, QPainter* painter, QRectF rect) {
+    QRectF visible = rect.intersected(QRectF{widget->rect()});
+
+    if (!isEnabled() || visible.isEmpty()) {
+        return;
+    }
+
+    bool all = grid->takeDirtyTiles(dirtyTiles);
+
+    if (cellImage.width() != grid->getColumns() || cellImage.height() != grid->getRows()) {
+        cellImage = QImage(grid->getColumns(), grid->getRows(), QImage::Format_ARGB32_Premultiplied);
+        all = true;
+    }
+
+    qreal ratio = painter->device()->devicePixelRatioF();
+    QSize pixelSize{(int)std::ceil(visible.width() * ratio), (int)std::ceil(visible.height() * ratio)};
+
+    if (overlay.size() != pixelSize || overlay.devicePixelRatio() != ratio || overlayRect != rect) {
+        overlay = QPixmap(pixelSize);
+        overlay.setDevicePixelRatio(ratio);
+        overlayRect = rect;
+        all = true;
+    }
+
+    QPainter overlayPainter(&overlay);
+    overlayPainter.setCompositionMode(QPainter::CompositionMode_Source);
+
+    // Position of the whole arena relative to the kept part
+    double left = rect.x() - visible.x();
+    double top = rect.y() - visible.y();
+    double cellWidth = rect.width() / grid->getColumns();
+    double cellHeight = rect.height() / grid->getRows();
+
+    if (all) {
+        for (int tile = 0; tile < grid->getTileColumns() * grid->getTileRows(); tile++) {
+            colourTile(tile);
+        }
+
+        overlayPainter.drawImage(QRectF{left, top, rect.width(), rect.height()}, cellImage);
+    } else {
+        for (int tile : dirtyTiles) {
+            colourTile(tile);
+
+            int column = (tile % grid->getTileColumns()) * OCCUPANCY_TILE_SIZE;
+            int row = (tile / grid->getTileColumns()) * OCCUPANCY_TILE_SIZE;
+            int columns = std::min(OCCUPANCY_TILE_SIZE, grid->getColumns() - column);
+            int rows = std::min(OCCUPANCY_TILE_SIZE, grid->getRows() - row);
+
+            overlayPainter.drawImage(QRectF{left + column * cellWidth, top + row * cellHeight, columns * cellWidth, rows * cellHeight},
+                                     cellImage, QRectF(column, row, columns, rows));
+        }
+    }
+
+    overlayPainter.end();
+    painter->drawPixmap(visible.topLeft(), overlay);
+}
+
+/* colourTile
+ * Colour the cells of one tile by the time spent in them, relative to the
+ * colour scale of the grid.
+ */
+void VisOccupancy::colourTile(int tile) {
+    int column = (tile % grid->getTileColumns()) * OCCUPANCY_TILE_SIZE;
+    int row = (tile / grid->getTileColumns()) * OCCUPANCY_TILE_SIZE;
+    int lastColumn = std::min(column + OCCUPANCY_TILE_SIZE, grid->getColumns());
+    int lastRow = std::min(row + OCCUPANCY_TILE_SIZE, grid->getRows());
+    float scale = grid->getScale();
+
+    for (int y = row; y < lastRow; y++) {
+        QRgb* line = reinterpret_cast<QRgb*>(cellImage.scanLine(y));
+
+        for (int x = column; x < lastColumn; x++) {
+            float value = grid->getCell(x, y);
+            line[x] = heatColour(value <= 0 ? 0 : std::max(1, (int)(255 * value / scale)));
+        }
+    }
+}
+
+/* heatColour
+ * Premultiplied colour of a heat map level from 0 to 255, running from
+ * transparent through blue and yellow to red.
+ */
+QRgb VisOccupancy::heatColour(int level) {
+    static QRgb ramp[256];
+    static bool rampBuilt = false;
+
+    if (!rampBuilt) {
+        for (int i = 0; i < 256; i++) {
+            double t = i / 255.0;
+            QColor colour = QColor::fromHsvF((1 - t) * 0.66, 1, 1, i == 0 ? 0 : 0.3 + 0.6 * t);
+            ramp[i] = qPremultiply(colour.rgba());
+        }
+        rampBuilt = true;
+    }
+
+    return ramp[std::min(255, std::max(0, level))];
+}
+
+/* getSettingsDialog
+ * Return a pointer to the settings dialog for this visualisation.
+ */
+QDialog* VisOccupancy::getSettingsDialog(void) {
+    return NULL;
+}
@@ -0,0 +1,38 @@
+#ifndef VISOCCUPANCY_H
+#define VISOCCUPANCY_H
+
+#include "viselement.h"
+#include "../DataModel/occupancygrid.h"
+
+#include <QImage>
+#include <QPixmap>
+
+#include <vector>
+
+class VisOccupancy : public VisElement
+{
+    OccupancyGrid* grid;
+
+    // One pixel per cell, and the same scaled to the arena on screen
+    QImage cellImage;
+    QPixmap overlay;
+    QRectF overlayRect;
+
+    std::vector<int> dirtyTiles;
+
+    void colourTile(int tile);
+
+public:
+    VisOccupancy(OccupancyGrid* grid);
+
+    virtual QString toString(void);
+
+    virtual void render(QWidget* widget, QPainter* painter, RobotData *robot, bool selected, QRectF rect);
+    virtual void renderBackground(QWidget* widget, QPainter* painter, QRectF rect);
+
+    virtual QDialog* getSettingsDialog(void);
+
+    static QRgb heatColour(int level);
+};
+
+#endif // VISOCCUPANCY_H
@@ -10,12 +10,34 @@
 #include <QtMath>
 
 #include <iostream>
+#include <cmath>
+
+// Radius of the ring drawn around each robot, in pixels
+static const double INDICATOR_SIZE = 10;
+
+// Rotation steps of the cached sprites. At 5 degrees the end of the heading
+// line is at most half a pixel from where it would be drawn.
+static const int SPRITE_ROTATIONS = 72;
+
+// Steps of the confidence fade of the cached sprites
+static const int SPRITE_ALPHA_LEVELS = 16;
+
+// Sprite atlases kept before the cache is emptied
+static const int MAX_SPRITE_ATLASES = 64;
+
+/* spriteSize
+ * Side length of one sprite, enough for the ring and its border.
+ */
+static int spriteSize(int penWidth) {
+    return 2 * (int)std::ceil(INDICATOR_SIZE + penWidth + 3);
+}
 
 /* Constructor
  * Initialise all setttings
  */
 VisPosition::VisPosition(void) {
     setEnabled(true);
+    spriteCacheEnabled = true;
 }
 
 /* toString
@@ -26,20 +48,53 @@ QString VisPosition::toString(void) {
 }
 
 /* render
- * Render this visualisation for one robot.
+ * Render this visualisation for one robot. Unless the painter is scaled or
+ * rotated, the glyph is copied from the sprite cache instead of being drawn.
  */
 void VisPosition::render(QWidget*, QPainter* painter, RobotData *robot, bool selected, QRectF rect) {
     if (!isEnabled()) {
         return;
     }
 
-    double indicatorSize = 10;
-
     double orientation = qDegreesToRadians(robot->getAngle()*1.0);
     double x = rect.x() + (rect.width() * robot->getPos().position.x);
     double y = rect.y() + (rect.height() * robot->getPos().position.y);
     QPointF centre = QPointF{x, y};
-    QPointF endOfLine = QPointF{centre.x() + cos(orientation) * indicatorSize, centre.y() + sin(orientation) * indicatorSize};
+
+    // Robots that are only being predicted fade out as confidence drops
+    int alpha = 255 * (0.25 + 0.75 * robot->getTrackingConfidence());
+    QColor colour = robot->colour;
+
+    if (!spriteCacheEnabled || painter->transform().type() > QTransform::TxTranslate) {
+        colour.setAlpha(alpha);
+        drawGlyph(painter, centre, orientation, colour, selected);
+        return;
+    }
+
+    // Quantise the fade and the rotation to the sprites that are cached
+    int level = qRound(alpha * (SPRITE_ALPHA_LEVELS - 1) / 255.0);
+    colour.setAlpha(level * 255 / (SPRITE_ALPHA_LEVELS - 1));
+
+    int rotation = qRound(orientation * SPRITE_ROTATIONS / (2 * M_PI)) % SPRITE_ROTATIONS;
+    if (rotation < 0) {
+        rotation += SPRITE_ROTATIONS;
+    }
+
+    int penWidth = painter->pen().width();
+    qreal pixelRatio = painter->device()->devicePixelRatioF();
+    int size = spriteSize(penWidth);
+
+    const QPixmap& atlas = getSprites(colour, selected, penWidth, pixelRatio);
+    painter->drawPixmap(QPointF{x - 0.5 * size, y - 0.5 * size}, atlas,
+                        QRectF{rotation * size * pixelRatio, 0, size * pixelRatio, size * pixelRatio});
+}
+
+/* drawGlyph
+ * Draw the ring and heading line of a robot, outlined in black. The width of
+ * the painter's pen sets the line width.
+ */
+void VisPosition::drawGlyph(QPainter* painter, QPointF centre, double orientation, QColor colour, bool selected) {
+    QPointF endOfLine = QPointF{centre.x() + cos(orientation) * INDICATOR_SIZE, centre.y() + sin(orientation) * INDICATOR_SIZE};
 
     auto pen = painter->pen();
     auto circlePen = pen;
@@ -49,16 +104,17 @@ void VisPosition::render(QWidget*, QPainter* painter, RobotData *robot, bool sel
       circlePen.setWidth(pen.widthF() * 1.75);
 
     borderPen.setWidth(circlePen.width()+3);
-    borderPen.setColor(QColor{0, 0, 0, 255});
-    circlePen.setColor(robot->colour);
+
+    borderPen.setColor(QColor{0, 0, 0, colour.alpha()});
+    circlePen.setColor(colour);
     painter->setPen(borderPen);
-    painter->drawEllipse(centre, indicatorSize, indicatorSize);
+    painter->drawEllipse(centre, INDICATOR_SIZE, INDICATOR_SIZE);
     borderPen.setWidth(5);
     painter->setPen(borderPen);
     painter->drawLine(centre, endOfLine);
 
     painter->setPen(circlePen);
-    painter->drawEllipse(centre, indicatorSize, indicatorSize);
+    painter->drawEllipse(centre, INDICATOR_SIZE, INDICATOR_SIZE);
     circlePen.setWidth(3);
     painter->setPen(circlePen);
     painter->drawLine(centre, endOfLine);
@@ -66,6 +122,44 @@ void VisPosition::render(QWidget*, QPainter* painter, RobotData *robot, bool sel
     painter->setPen(pen);
 }
 
+/* getSprites
+ * Returns the sprite atlas for one glyph style, drawing it on first use. The
+ * atlas holds one sprite per rotation step side by side.
+ */
+const QPixmap& VisPosition::getSprites(QColor colour, bool selected, int penWidth, qreal pixelRatio) {
+    quint64 key = (quint64)colour.rgba() | ((quint64)selected << 32) |
+                  ((quint64)(penWidth & 0xff) << 33) | ((quint64)qRound(pixelRatio * 4) << 41);
+
+    auto cached = sprites.find(key);
+    if (cached != sprites.end()) {
+        return *cached;
+    }
+
+    // Styles are few, a fade that passes through every level is the worst case
+    if (sprites.size() >= MAX_SPRITE_ATLASES) {
+        sprites.clear();
+    }
+
+    int size = spriteSize(penWidth);
+    QPixmap atlas{(int)std::ceil(SPRITE_ROTATIONS * size * pixelRatio), (int)std::ceil(size * pixelRatio)};
+    atlas.setDevicePixelRatio(pixelRatio);
+    atlas.fill(Qt::transparent);
+
+    QPainter painter(&atlas);
+    painter.setRenderHint(QPainter::Antialiasing);
+    QPen pen;
+    pen.setWidth(penWidth);
+    painter.setPen(pen);
+
+    for (int rotation = 0; rotation < SPRITE_ROTATIONS; rotation++) {
+        QPointF centre{(rotation + 0.5) * size, 0.5 * size};
+        drawGlyph(&painter, centre, rotation * 2 * M_PI / SPRITE_ROTATIONS, colour, selected);
+    }
+
+    painter.end();
+    return *sprites.insert(key, atlas);
+}
+
 /* getSettingsDialog
  * Return a pointer to the settings dialog for this visualisation.
  */
@@ -3,8 +3,19 @@
 
 #include "viselement.h"
 
+#include <QHash>
+#include <QPixmap>
+
 class VisPosition : public VisElement
 {
+    // Robot glyphs pre-rendered at every rotation, keyed by colour, selection,
+    // pen width and pixel ratio
+    QHash<quint64, QPixmap> sprites;
+    bool spriteCacheEnabled;
+
+    void drawGlyph(QPainter* painter, QPointF centre, double orientation, QColor colour, bool selected);
+    const QPixmap& getSprites(QColor colour, bool selected, int penWidth, qreal pixelRatio);
+
 public:
     VisPosition(void);
 
@@ -13,6 +24,9 @@ public:
     virtual void render(QWidget* widget, QPainter* painter, RobotData *robot, bool selected, QRectF rect);
 
     virtual QDialog* getSettingsDialog(void);
+
+    void setSpriteCacheEnabled(bool enable) { spriteCacheEnabled = enable; }
+    bool isSpriteCacheEnabled(void) { return spriteCacheEnabled; }
 };
 
 #endif // VISPOSITION_H
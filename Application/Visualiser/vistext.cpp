@@ -10,7 +10,11 @@
 
 #include <QPainter>
 #include <QPainterPath>
+#include <QFontMetricsF>
 #include <limits>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
 
 /* Constructor
  * Initialise all setttings
@@ -18,6 +22,10 @@
 VisText::VisText(void) {
     setEnabled(true);
 //    setSelectedOnly(false);
+
+    describedVersion = 0;
+    textChanged = true;
+    pixmapRatio = 1;
 }
 
 /* Destructor
@@ -27,7 +35,8 @@ VisText::~VisText() {
 }
 
 /* render
- * Render this visualisation for one robot.
+ * Render this visualisation for one robot. The text is laid out into a
+ * pixmap when it or the painter's style changes, and copied otherwise.
  */
 void VisText::render(QWidget* , QPainter* painter, RobotData *robot, bool selected, QRectF rect) {
 
@@ -37,20 +46,48 @@ void VisText::render(QWidget* , QPainter* painter, RobotData *robot, bool select
     double x = rect.x() + (rect.width() * robot->getPos().position.x) + 15;
     double y = rect.y() + (rect.height() * robot->getPos().position.y) - 10;
 
-    auto font = painter->font();
-    auto pen  = painter->pen();
+    updatePixmap(painter);
+    painter->drawPixmap(QPointF{x, y}, textPixmap);
+}
+
+/* updatePixmap
+ * Lay out and draw the text into the pixmap if the text, font, pen or pixel
+ * ratio have changed since it was last drawn.
+ */
+void VisText::updatePixmap(QPainter* painter)
+{
+    qreal ratio = painter->device()->devicePixelRatioF();
+
+    if(!textChanged && painter->font() == pixmapFont && painter->pen() == pixmapPen && ratio == pixmapRatio)
+        return;
 
-    painter->setBackgroundMode(Qt::BGMode::OpaqueMode);
-    painter->setBackground(QBrush{QColor{0, 0, 0, 100}});
+    pixmapFont = painter->font();
+    pixmapPen = painter->pen();
+    pixmapRatio = ratio;
+    textChanged = false;
 
-    painter->setFont(font);
-    painter->setPen(pen);
-    painter->drawText(QRectF{x, y, std::numeric_limits<float>::max(), std::numeric_limits<float>::max()}, Qt::TextWordWrap, text);
+    QRectF layout{0, 0, std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    QRectF bounds = QFontMetricsF{pixmapFont}.boundingRect(layout, Qt::TextWordWrap, text);
+
+    textPixmap = QPixmap{std::max(1, (int)std::ceil(bounds.width() * ratio)), std::max(1, (int)std::ceil(bounds.height() * ratio))};
+    textPixmap.setDevicePixelRatio(ratio);
+    textPixmap.fill(Qt::transparent);
+
+    QPainter textPainter(&textPixmap);
+    textPainter.setRenderHints(painter->renderHints());
+    textPainter.setBackgroundMode(Qt::BGMode::OpaqueMode);
+    textPainter.setBackground(QBrush{QColor{0, 0, 0, 100}});
+    textPainter.setFont(pixmapFont);
+    textPainter.setPen(pixmapPen);
+    textPainter.drawText(layout, Qt::TextWordWrap, text);
+    textPainter.end();
 }
 
 void VisText::setText(QString newText)
 {
     text = newText;
+    textChanged = true;
+    describedVersion = 0;
 }
 
 QString VisText::getText()
@@ -64,9 +101,84 @@ void VisText::addLine(QString newLine)
         text += "\n";
 
     text += newLine;
+    textChanged = true;
+    describedVersion = 0;
 }
 
 void VisText::resetText()
 {
     text = "";
+    textChanged = true;
+    describedVersion = 0;
+}
+
+/* describeRobot
+ * Set the text to the ID of a robot followed by each of its values that is
+ * marked for display. Nothing is rebuilt if none of these have changed since
+ * the robot was last described.
+ */
+void VisText::describeRobot(RobotData* robot)
+{
+    quint64 version = robot->getDisplayVersion();
+
+    if(version == describedVersion)
+        return;
+
+    // @EXTEND: Add other data types
+    resetText();
+    addLine("ID:   " + robot->getID());
+    for(auto& key : robot->getKeys())
+    {
+        if(!robot->valueShouldBeDisplayed(key))
+            continue;
+
+        std::stringstream ss;
+        ss<<key.toStdString();
+        ss<<": ";
+
+        auto type = robot->getValueType(key);
+
+        if(type == String) ss<<robot->getStringValue(key).toStdString();
+
+        if(type == Double) ss<<robot->getDoubleValue(key);
+
+        if(type == Bool) ss<<(robot->getBoolValue(key) ? "True" : "False");
+
+        if(type == Array)
+        {
+            auto arr = robot->getArrayValue(key);
+            ss<<"[ ";
+            for(int i = 0; i < arr.size(); ++i)
+            {
+                if(i > 0) ss<<"   ";
+                auto item = arr[i];
+                if(item.type == String) ss<<'"'<<item.stringValue.toStdString()<<'"';
+                else if(item.type == Double) ss<<item.doubleValue;
+                else if(item.type == Bool) ss<<(item.boolValue ? "True" : "False");
+                else ss<<"Unsupported";
+            }
+            ss<<" ]";
+        }
+
+        if(type == Object)
+        {
+            auto obj = robot->getObjectValue(key);
+            ss<<"{ ";
+            for(auto& key : obj.keys())
+            {
+                ss<<key.toStdString()<<": ";
+                auto& item = obj[key];
+                if(item.type == String) ss<<'"'<<item.stringValue.toStdString()<<'"';
+                else if(item.type == Double) ss<<item.doubleValue;
+                else if(item.type == Bool) ss<<(item.boolValue ? "True" : "False");
+                else ss<<"Unsupported";
+                ss<<"   ";
+            }
+            ss<<" }";
+        }
+
+        addLine(QString::fromStdString(ss.str()));
+    }
+
+    describedVersion = version;
 }
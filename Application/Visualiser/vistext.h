@@ -3,6 +3,10 @@
 
 #include "viselement.h"
 
+#include <QPixmap>
+#include <QFont>
+#include <QPen>
+
 class VisText : public VisElement
 {
 public:
@@ -16,9 +20,22 @@ public:
 
     void addLine(QString newLine);
     void resetText();
+    void describeRobot(RobotData* robot);
 
 private:
     QString text;
+
+    // Display version of the robot the text was last built for, zero if none
+    quint64 describedVersion;
+
+    // The text drawn once, and the style it was drawn with
+    QPixmap textPixmap;
+    bool textChanged;
+    QFont pixmapFont;
+    QPen pixmapPen;
+    qreal pixmapRatio;
+
+    void updatePixmap(QPainter* painter);
 };
 
 #endif // VISID_H
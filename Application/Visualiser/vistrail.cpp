@@ -0,0 +1,153 @@
+/* vistrail.cpp
+ *
+ * This class encapsulates the visualisation of the path each robot took.
+ *
+ */
+
+#include "vistrail.h"
+#include "../Core/settings.h"
+
+#include <QPainter>
+#include <QDateTime>
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// Shortest distance in pixels between two points of a drawn trail. Samples
+// closer to the last kept point are not drawn.
+static const double TRAIL_MIN_DISTANCE = 2;
+
+// Trails of robots that have not been drawn for this long are forgotten
+static const qint64 TRAIL_EXPIRY = 5000;
+
+/* Constructor
+ * Initialise all setttings
+ */
+VisTrail::VisTrail(void) {
+    setEnabled(true);
+    lastPrune = 0;
+}
+
+/* toString
+ * Generate a string describing all settings.
+ */
+QString VisTrail::toString(void) {
+    return QString("Trail");
+}
+
+/* render
+ * Render this visualisation for one robot, as a single polyline from the
+ * oldest position within the trail length to the current position.
+ */
+void VisTrail::render(QWidget*, QPainter* painter, RobotData *robot, bool selected, QRectF rect) {
+    double length = Settings::instance()->getTrailLength();
+
+    if (!isEnabled() || length <= 0) {
+        return;
+    }
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    pruneTrails(now);
+
+    // The trail length is measured back from the robot's newest pose, on the
+    // clock its poses were stamped with, which need not be the wall clock
+    const PoseHistory& history = robot->getPoseHistory();
+    qint64 newest = history.size() > 0 ? history.at(history.size() - 1).time : robot->getPoseTime();
+
+    Trail& trail = trails[robot->getID()];
+    trail.lastUsed = now;
+    updateTrail(trail, history, rect, newest - (qint64)(1000 * length));
+
+    // The trail ends at the current position, which may not be recorded yet
+    Pose pose = robot->getPos();
+    trail.points.push_back(QPointF{rect.x() + rect.width() * pose.position.x, rect.y() + rect.height() * pose.position.y});
+
+    size_t count = trail.points.size() - trail.start;
+    if (count >= 2) {
+        auto pen = painter->pen();
+
+        QColor colour = robot->colour;
+        colour.setAlpha(128);
+        QPen trailPen{colour};
+        trailPen.setWidthF(selected ? 3 : 2);
+        trailPen.setJoinStyle(Qt::RoundJoin);
+
+        painter->setPen(trailPen);
+        painter->drawPolyline(&trail.points[trail.start], count);
+        painter->setPen(pen);
+    }
+
+    trail.points.pop_back();
+}
+
+/* updateTrail
+ * Add the samples recorded since the last paint to a trail, dropping any
+ * within a few pixels of the previous point, and trim the points older than
+ * the trail length. The trail is rebuilt when the arena moves on screen or
+ * the history no longer contains its newest point.
+ */
+void VisTrail::updateTrail(Trail& trail, const PoseHistory& history, QRectF rect, qint64 since) {
+    bool historyReset = history.size() == 0 || history.at(history.size() - 1).time < trail.lastTime;
+
+    if (trail.rect != rect || historyReset || trail.points.empty()) {
+        trail.rect = rect;
+        trail.lastTime = std::numeric_limits<qint64>::min();
+        trail.start = 0;
+        trail.points.clear();
+        trail.times.clear();
+    }
+
+    for (int i = history.firstAtOrAfter(std::max(since, trail.lastTime + 1)); i < history.size(); i++) {
+        const PoseSample& sample = history.at(i);
+        QPointF point{rect.x() + rect.width() * sample.x, rect.y() + rect.height() * sample.y};
+        trail.lastTime = sample.time;
+
+        if (trail.points.size() > trail.start) {
+            QPointF step = point - trail.points.back();
+            if (std::abs(step.x()) + std::abs(step.y()) < TRAIL_MIN_DISTANCE) {
+                continue;
+            }
+        }
+
+        trail.points.push_back(point);
+        trail.times.push_back(sample.time);
+    }
+
+    while (trail.start < trail.points.size() && trail.times[trail.start] < since) {
+        trail.start++;
+    }
+
+    // Reclaim the trimmed points once they are most of the buffer
+    if (trail.start > 64 && trail.start > trail.points.size() / 2) {
+        trail.points.erase(trail.points.begin(), trail.points.begin() + trail.start);
+        trail.times.erase(trail.times.begin(), trail.times.begin() + trail.start);
+        trail.start = 0;
+    }
+}
+
+/* pruneTrails
+ * Every few seconds, forget the trails of robots that are no longer drawn.
+ */
+void VisTrail::pruneTrails(qint64 now) {
+    if (now - lastPrune < TRAIL_EXPIRY) {
+        return;
+    }
+
+    lastPrune = now;
+
+    for (auto trail = trails.begin(); trail != trails.end();) {
+        if (now - trail->lastUsed > TRAIL_EXPIRY) {
+            trail = trails.erase(trail);
+        } else {
+            ++trail;
+        }
+    }
+}
+
+/* getSettingsDialog
+ * Return a pointer to the settings dialog for this visualisation.
+ */
+QDialog* VisTrail::getSettingsDialog(void) {
+    return NULL;
+}
@@ -0,0 +1,42 @@
+#ifndef VISTRAIL_H
+#define VISTRAIL_H
+
+#include "viselement.h"
+
+#include <QHash>
+#include <QPointF>
+#include <QRectF>
+
+#include <vector>
+
+class VisTrail : public VisElement
+{
+    // Decimated trail of one robot in widget coordinates, extended with new
+    // samples and trimmed at its old end on each paint
+    struct Trail
+    {
+        QRectF rect;
+        qint64 lastTime;
+        qint64 lastUsed;
+        size_t start;
+        std::vector<QPointF> points;
+        std::vector<qint64> times;
+    };
+
+    QHash<QString, Trail> trails;
+    qint64 lastPrune;
+
+    void updateTrail(Trail& trail, const PoseHistory& history, QRectF rect, qint64 since);
+    void pruneTrails(qint64 now);
+
+public:
+    VisTrail(void);
+
+    virtual QString toString(void);
+
+    virtual void render(QWidget* widget, QPainter* painter, RobotData *robot, bool selected, QRectF rect);
+
+    virtual QDialog* getSettingsDialog(void);
+};
+
+#endif // VISTRAIL_H
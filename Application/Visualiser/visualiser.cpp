@@ -7,19 +7,50 @@
 
 #include "visualiser.h"
 #include "../Core/settings.h"
+#include "../Core/latencymonitor.h"
 
 #include <stdio.h>
 #include <math.h>
 #include <cmath>
+#include <algorithm>
 
 #include <iostream>
 #include <QLayout>
 
 #include "vistext.h"
 #include "visposition.h"
+#include "vistrail.h"
+#include "visoccupancy.h"
+#include "visevents.h"
+#include "viscommgraph.h"
 
 #include <iostream>
 
+// Average on screen spacing, in pixels, below which robots are drawn as
+// points instead of glyphs, and as a density map instead of points
+static const double GLYPH_SPACING = 30;
+static const double POINT_SPACING = 6;
+
+// Largest fleets drawn as glyphs and as points
+static const size_t MAX_GLYPH_ROBOTS = 1000;
+static const size_t MAX_POINT_ROBOTS = 20000;
+
+// Distance in pixels outside the view within which robots are still drawn,
+// so that glyphs on the edge are not cut off
+static const double VIEW_MARGIN = 20;
+
+// Distance from a click, as a proportion of the longer side of the arena,
+// within which a robot is selected
+static const double SELECTION_DISTANCE = 0.02;
+
+// Largest zoom, and the zoom per step of the mouse wheel
+static const double MAX_ZOOM = 32;
+static const double ZOOM_PER_WHEEL_STEP = 1.25;
+
+// Size in pixels of a point, and of a cell of the density map
+static const int POINT_SIZE = 5;
+static const double DENSITY_CELL_SIZE = 8;
+
 /* Constructor
  * Empty.
  */
@@ -28,22 +59,33 @@
 /* Constructor
  * Initalises the visualiser data.
  */
-Visualiser::Visualiser(DataModel *dataModelRef, ARCameraThread* cameraThread) {
+Visualiser::Visualiser(DataModel *dataModelRef, VideoCompositor* compositor) {
     this->dataModelRef = dataModelRef;
 
     // Default visualiser config
     this->config = VisConfig();
     textVis = new VisText;
+
+    VisOccupancy* occupancy = new VisOccupancy{dataModelRef->getOccupancyGrid()};
+    occupancy->setEnabled(Settings::instance()->isOccupancyOverlayEnabled());
+    this->config.elements.push_back(occupancy);
+
+    this->config.elements.push_back(new VisCommGraph{dataModelRef->getCommGraph()});
+    this->config.elements.push_back(new VisTrail);
+    this->config.elements.push_back(new VisEvents{dataModelRef});
     this->config.elements.push_back(textVis);
     this->config.elements.push_back(new VisPosition);
 
     this->click.x = 0.0;
     this->click.y = 0.0;
 
-    backgroundImage.fill(QColor{200, 200, 200});
+    this->zoom = 1;
+    this->viewCentre = QPointF{0.5, 0.5};
+    this->panning = false;
 
-    this->cameraThread = cameraThread;
-    connect(cameraThread, SIGNAL(newVideoFrame(cv::Mat&)), this, SLOT(newVideoFrame(cv::Mat&)));
+    // Camera frames are prepared on the compositor thread, this widget only draws them
+    this->compositor = compositor;
+    connect(compositor, SIGNAL(frameReady()), this, SLOT(newCompositedFrame()));
 }
 
 void Visualiser::refreshVisualisation()
@@ -64,17 +106,25 @@ void Visualiser::paintEvent(QPaintEvent*) {
     painter.setWindow(this->rect());
     painter.fillRect(this->rect(), painter.background());
 
-    double width = this->width();
-    double height = this->height();
-    double xOffset = 0;
-    double yOffset = 0;
+    QRectF arena = arenaRect();
+    double width = arena.width();
+    double height = arena.height();
+    double xOffset = arena.x();
+    double yOffset = arena.y();
+
+    // The image only covers the visible part of the arena. It is drawn
+    // unscaled unless the view changed since it was prepared.
+    const QImage& backgroundImage = compositor->getFrontBuffer();
+    QRectF region = compositor->getFrontRegion();
+    QRectF imageRect{xOffset + width * region.x(), yOffset + height * region.y(), width * region.width(), height * region.height()};
 
-    xOffset = 0.5*(this->width() - backgroundImage.width());
-    yOffset = 0.5*(this->height() - backgroundImage.height());
-    width = backgroundImage.width();
-    height = backgroundImage.height();
+    if(qAbs(imageRect.width() - backgroundImage.width()) < 1 && qAbs(imageRect.height() - backgroundImage.height()) < 1)
+        painter.drawImage(imageRect.topLeft(), backgroundImage);
+    else
+        painter.drawImage(imageRect, backgroundImage);
 
-    painter.drawImage(xOffset, yOffset, backgroundImage);
+    for(auto element : config.elements)
+        element->renderBackground(this, &painter, arena);
 
     QPen pen{QColor{255, 255, 255}};
     pen.setWidth(3);
@@ -86,82 +136,199 @@ void Visualiser::paintEvent(QPaintEvent*) {
     std::vector<RobotData*> selectedRobots;
     std::vector<RobotData*> unselectedRobots;
 
-    for (int i = 0; i < dataModelRef->getRobotCount(); i++) {
-        // Get data
-        RobotData* robot = dataModelRef->getRobotByIndex(i);
+    // Only robots within a glyph of the visible part of the arena are drawn
+    QRectF visible = arena.intersected(QRectF{this->rect()});
+    visibleRobots.clear();
 
+    if(!visible.isEmpty())
+    {
+        double marginX = VIEW_MARGIN / width;
+        double marginY = VIEW_MARGIN / height;
+
+        dataModelRef->getSpatialIndex()->query((visible.left() - xOffset) / width - marginX, (visible.top() - yOffset) / height - marginY,
+                                               (visible.right() - xOffset) / width + marginX, (visible.bottom() - yOffset) / height + marginY,
+                                               visibleRobots);
+    }
+
+    for (auto robot : visibleRobots) {
         if(robot->getID() == selectedId)
             selectedRobots.push_back(robot);
         else
             unselectedRobots.push_back(robot);
     }
 
-    for(auto robot : unselectedRobots)
-        renderSingleRobot(robot, false, painter, xOffset, yOffset, width, height);
+    // Dense swarms are drawn as points or as a density map, the selected
+    // robot is always drawn in full
+    VisualiserDetail detail = chooseDetail(unselectedRobots.size() + selectedRobots.size(), visible);
+
+    if(detail == VISUALISER_DETAIL_GLYPHS)
+    {
+        for(auto robot : unselectedRobots)
+            renderSingleRobot(robot, false, painter, xOffset, yOffset, width, height);
+    }
+    else if(detail == VISUALISER_DETAIL_POINTS)
+    {
+        renderPoints(unselectedRobots, painter, arena);
+    }
+    else
+    {
+        renderDensity(unselectedRobots, painter, arena, visible);
+    }
 
     for(auto robot : selectedRobots)
         renderSingleRobot(robot, true, painter, xOffset, yOffset, width, height);
 
+    if(Settings::instance()->isLatencyOverlayEnabled())
+        renderLatencyOverlay(painter);
+
     painter.end();
+
+    LatencyMonitor::instance()->framePainted();
 }
 
-void Visualiser::renderSingleRobot(RobotData* robot, bool selected, QPainter& painter, double xOffset, double yOffset, double width, double height){
-    // @EXTEND: Add other data types
-    textVis->resetText();
-    textVis->addLine("ID:   " + robot->getID());
-    for(auto& key : robot->getKeys())
+/* chooseDetail
+ * Pick how robots are drawn from the average on screen spacing between them.
+ * Glyphs need room to be read, and each way of drawing has a robot count
+ * above which it is no longer used, so the paint cost stays bounded.
+ */
+VisualiserDetail Visualiser::chooseDetail(size_t robotCount, QRectF arena)
+{
+    VisualiserDetail detail = Settings::instance()->getVisualiserDetail();
+    if(detail != VISUALISER_DETAIL_AUTO)
+        return detail;
+
+    if(robotCount == 0)
+        return VISUALISER_DETAIL_GLYPHS;
+
+    double spacing = std::sqrt(arena.width() * arena.height() / robotCount);
+
+    if(spacing >= GLYPH_SPACING && robotCount <= MAX_GLYPH_ROBOTS)
+        return VISUALISER_DETAIL_GLYPHS;
+
+    if(spacing >= POINT_SPACING && robotCount <= MAX_POINT_ROBOTS)
+        return VISUALISER_DETAIL_POINTS;
+
+    return VISUALISER_DETAIL_DENSITY;
+}
+
+/* renderPoints
+ * Draw each robot as a single point in its colour. Robots are grouped by
+ * colour so that there is one draw call per colour.
+ */
+void Visualiser::renderPoints(const std::vector<RobotData*>& robots, QPainter& painter, QRectF arena)
+{
+    for(auto& batch : pointBatches)
+        batch.clear();
+
+    for(auto robot : robots)
     {
-        if(!robot->valueShouldBeDisplayed(key))
+        // Fading robots share a few alpha levels to keep the batches few
+        QColor colour = robot->colour;
+        colour.setAlpha(64 + 191 * qRound(3 * robot->getTrackingConfidence()) / 3);
+
+        Pose pose = robot->getPos();
+        pointBatches[colour.rgba()].push_back(QPointF{arena.x() + arena.width() * pose.position.x,
+                                                      arena.y() + arena.height() * pose.position.y});
+    }
+
+    painter.save();
+    painter.setRenderHint(QPainter::Antialiasing, false);
+    painter.setRenderHint(QPainter::HighQualityAntialiasing, false);
+
+    for(auto batch = pointBatches.begin(); batch != pointBatches.end(); ++batch)
+    {
+        if(batch->empty())
             continue;
 
-        std::stringstream ss;
-        ss<<key.toStdString();
-        ss<<": ";
-
-        auto type = robot->getValueType(key);
-
-        if(type == String) ss<<robot->getStringValue(key).toStdString();
-
-        if(type == Double) ss<<robot->getDoubleValue(key);
-
-        if(type == Bool) ss<<(robot->getBoolValue(key) ? "True" : "False");
-
-        if(type == Array)
-        {
-            auto arr = robot->getArrayValue(key);
-            ss<<"[ ";
-            for(int i = 0; i < arr.size(); ++i)
-            {
-                if(i > 0) ss<<"   ";
-                auto item = arr[i];
-                if(item.type == String) ss<<'"'<<item.stringValue.toStdString()<<'"';
-                else if(item.type == Double) ss<<item.doubleValue;
-                else if(item.type == Bool) ss<<(item.boolValue ? "True" : "False");
-                else ss<<"Unsupported";
-            }
-            ss<<" ]";
-        }
-
-        if(type == Object)
-        {
-            auto obj = robot->getObjectValue(key);
-            ss<<"{ ";
-            for(auto& key : obj.keys())
-            {
-                ss<<key.toStdString()<<": ";
-                auto& item = obj[key];
-                if(item.type == String) ss<<'"'<<item.stringValue.toStdString()<<'"';
-                else if(item.type == Double) ss<<item.doubleValue;
-                else if(item.type == Bool) ss<<(item.boolValue ? "True" : "False");
-                else ss<<"Unsupported";
-                ss<<"   ";
-            }
-            ss<<" }";
-        }
-
-        textVis->addLine(QString::fromStdString(ss.str()));
+        QPen pen{QColor::fromRgba(batch.key())};
+        pen.setWidth(POINT_SIZE);
+        painter.setPen(pen);
+        painter.drawPoints(batch->data(), batch->size());
     }
 
+    painter.restore();
+}
+
+/* renderDensity
+ * Draw a heat map of how many robots are in each cell of a coarse grid over
+ * the visible part of the arena. The grid is filled in one pass over the
+ * robots and is never larger than the widget divided by the cell size.
+ */
+void Visualiser::renderDensity(const std::vector<RobotData*>& robots, QPainter& painter, QRectF arena, QRectF visible)
+{
+    int columns = std::max(1, (int)std::ceil(visible.width() / DENSITY_CELL_SIZE));
+    int rows = std::max(1, (int)std::ceil(visible.height() / DENSITY_CELL_SIZE));
+
+    densityCounts.assign(columns * rows, 0);
+    int maxCount = 0;
+
+    for(auto robot : robots)
+    {
+        Pose pose = robot->getPos();
+        double x = arena.x() + arena.width() * pose.position.x - visible.x();
+        double y = arena.y() + arena.height() * pose.position.y - visible.y();
+
+        // Robots just outside the view are only looked up for drawing glyphs
+        if(x < 0 || y < 0 || x >= visible.width() || y >= visible.height())
+            continue;
+
+        int column = std::min(columns - 1, std::max(0, (int)(x * columns / visible.width())));
+        int row = std::min(rows - 1, std::max(0, (int)(y * rows / visible.height())));
+        maxCount = std::max(maxCount, ++densityCounts[row * columns + column]);
+    }
+
+    if(maxCount == 0)
+        return;
+
+    if(densityImage.width() != columns || densityImage.height() != rows)
+        densityImage = QImage(columns, rows, QImage::Format_ARGB32_Premultiplied);
+
+    for(int row = 0; row < rows; ++row)
+    {
+        QRgb* line = reinterpret_cast<QRgb*>(densityImage.scanLine(row));
+        const int* counts = &densityCounts[row * columns];
+
+        for(int column = 0; column < columns; ++column)
+            line[column] = VisOccupancy::heatColour(counts[column] == 0 ? 0 : std::max(1, 255 * counts[column] / maxCount));
+    }
+
+    painter.save();
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawImage(visible, densityImage);
+    painter.restore();
+}
+
+/* renderLatencyOverlay
+ * Draw the latency statistics of every hop of the tracking path in the top
+ * left corner of the widget.
+ */
+void Visualiser::renderLatencyOverlay(QPainter& painter)
+{
+    QString text = QString{"%1 %2 %3 %4 %5"}.arg("latency ms", -20).arg("last", 7).arg("p50", 7).arg("p95", 7).arg("p99", 7);
+
+    for(int hop = 0; hop < LATENCY_HOP_COUNT; ++hop)
+    {
+        LatencySummary summary = LatencyMonitor::instance()->getSummary((LatencyHop)hop);
+        text += QString{"\n%1 %2 %3 %4 %5"}.arg(LatencyMonitor::hopName((LatencyHop)hop), -20)
+                .arg(summary.last, 7, 'f', 1).arg(summary.p50, 7, 'f', 1)
+                .arg(summary.p95, 7, 'f', 1).arg(summary.p99, 7, 'f', 1);
+    }
+
+    QFont font{"Monospace"};
+    font.setStyleHint(QFont::TypeWriter);
+    painter.setFont(font);
+
+    QRectF bounds = painter.boundingRect(QRectF{10, 10, 0, 0}, Qt::AlignLeft | Qt::AlignTop, text);
+    painter.fillRect(bounds.adjusted(-5, -5, 5, 5), QColor{0, 0, 0, 160});
+    painter.setPen(QColor{255, 255, 255});
+    painter.drawText(bounds, Qt::AlignLeft | Qt::AlignTop, text);
+}
+
+void Visualiser::renderSingleRobot(RobotData* robot, bool selected, QPainter& painter, double xOffset, double yOffset, double width, double height){
+    // Only the selected robot is labelled
+    if(selected)
+        textVis->describeRobot(robot);
+
     // Render the visualisations
     for (size_t j = 0; j < this->config.elements.size(); j++) {
         VisElement* element = this->config.elements.at(j);
@@ -175,70 +342,112 @@ void Visualiser::renderSingleRobot(RobotData* robot, bool selected, QPainter& pa
  */
 void Visualiser::resizeEvent(QResizeEvent*) {
 //    checkFrameSize();
+    compositor->setDisplaySize(this->size());
+    setView(zoom, viewCentre);
 }
 
 /* mousePressEvent
  * Captures mouse presses when the mouse is within the visualiser bounds.
+ * The left button selects a robot, the others start panning the view.
  */
 void Visualiser::mousePressEvent(QMouseEvent* event) {
-    double xOffset = 0.5*(this->width() - backgroundImage.width());
-    double yOffset = 0.5*(this->height() - backgroundImage.height());
+    if (event->button() != Qt::LeftButton) {
+        panning = true;
+        lastMousePos = event->pos();
+        return;
+    }
 
-    // Calculate x and y values as proportions of the image
-    click.x = (1.0 * event->x() - xOffset) / backgroundImage.width();
-    click.y = (1.0 * event->y() - yOffset) / backgroundImage.height();
+    QRectF arena = arenaRect();
 
-    // Loop over the robots looking for any within a threshold of the click
-    for (int i = 0; i < dataModelRef->getRobotCount(); i++) {
-        RobotData* robot = dataModelRef->getRobotByIndex(i);
+    // Calculate x and y values as proportions of the image
+    click.x = (1.0 * event->x() - arena.x()) / arena.width();
+    click.y = (1.0 * event->y() - arena.y()) / arena.height();
 
-        float dx = std::abs(robot->getPos().position.x - click.x);
-        float dy = std::abs(robot->getPos().position.y - click.y);
+    // Select the closest robot within a threshold of the click, which shrinks as the view zooms in
+    std::vector<RobotData*> nearest;
+    dataModelRef->getSpatialIndex()->nearest(click.x, click.y, 1, SELECTION_DISTANCE / zoom, nearest);
 
-        if (dx < 0.02 && dy < 0.02) {
-            // Signal that a robot has been selected
-            emit robotSelectedInVisualiser(robot->getID());
+    if (!nearest.empty()) {
+        // Signal that a robot has been selected
+        emit robotSelectedInVisualiser(nearest.front()->getID());
+    }
+}
 
-            // Max one selection per click
-            return;
-        }
-//        else
-//            emit robotSelectedInVisualiser("none");
+/* mouseMoveEvent
+ * Pans the view while a button other than the left one is held.
+ */
+void Visualiser::mouseMoveEvent(QMouseEvent* event) {
+    if (!panning) {
+        return;
     }
+
+    QRectF arena = arenaRect();
+    QPoint delta = event->pos() - lastMousePos;
+    lastMousePos = event->pos();
+
+    setView(zoom, QPointF{viewCentre.x() - delta.x() / arena.width(), viewCentre.y() - delta.y() / arena.height()});
 }
 
-void Visualiser::newVideoFrame(cv::Mat& newImage)
-{
-    static cv::Mat image;
-    cv::cvtColor(newImage, image, cv::COLOR_BGR2RGB);
+/* mouseReleaseEvent
+ * Ends panning.
+ */
+void Visualiser::mouseReleaseEvent(QMouseEvent*) {
+    panning = false;
+}
 
-    double xScale = (1.0 * this->width())/image.cols;
-    double yScale = (1.0 * this->height())/image.rows;
-    double scaleFactor;
+/* wheelEvent
+ * Zooms the view in or out, keeping the point of the arena under the mouse
+ * in place.
+ */
+void Visualiser::wheelEvent(QWheelEvent* event) {
+    QRectF arena = arenaRect();
+    QPointF mouse = event->pos();
+    QPointF anchor{(mouse.x() - arena.x()) / arena.width(), (mouse.y() - arena.y()) / arena.height()};
 
-    int newX, newY;
+    double newZoom = std::min(MAX_ZOOM, std::max(1.0, zoom * std::pow(ZOOM_PER_WHEEL_STEP, event->angleDelta().y() / 120.0)));
+    double scale = newZoom / zoom;
 
-    if(xScale < yScale)
-    {
-        newX = image.cols * xScale;
-        newY = image.rows * xScale;
-        scaleFactor = xScale;
-    }
-    else
-    {
-        newX = image.cols * yScale;
-        newY = image.rows * yScale;
-        scaleFactor = yScale;
-    }
+    // Where the arena would lie after zooming about the mouse
+    QSizeF size = arena.size() * scale;
+    QPointF topLeft = mouse - QPointF{anchor.x() * size.width(), anchor.y() * size.height()};
+
+    setView(newZoom, QPointF{(0.5 * this->width() - topLeft.x()) / size.width(), (0.5 * this->height() - topLeft.y()) / size.height()});
+    event->accept();
+}
+
+/* setView
+ * Zoom the view and put a point of the arena, as proportions, at its centre.
+ * Along each axis on which the arena is larger than the widget the arena is
+ * kept covering the widget, otherwise it is centred.
+ */
+void Visualiser::setView(double newZoom, QPointF centre) {
+    zoom = newZoom;
 
-    cv::resize(image, image, cv::Size{newX, newY}, cv::INTER_LINEAR);
+    QRectF arena = arenaRect();
+    double halfWidth = 0.5 * this->width() / arena.width();
+    double halfHeight = 0.5 * this->height() / arena.height();
 
-    backgroundImage = QImage(image.data, image.cols, image.rows, image.cols*3, QImage::Format_RGB888);
+    centre.setX(halfWidth >= 0.5 ? 0.5 : std::min(1 - halfWidth, std::max(halfWidth, centre.x())));
+    centre.setY(halfHeight >= 0.5 ? 0.5 : std::min(1 - halfHeight, std::max(halfHeight, centre.y())));
+    viewCentre = centre;
 
-    repaint();
+    compositor->setView(zoom, viewCentre);
+    update();
+}
 
-    cameraThread->addPreEmitCall([&](){
-        connect(cameraThread, SIGNAL(newVideoFrame(cv::Mat&)), this, SLOT(newVideoFrame(cv::Mat&)));
-    });
+/* arenaRect
+ * Returns where the whole arena lies in the widget under the current view.
+ */
+QRectF Visualiser::arenaRect(void) {
+    return VideoCompositor::arenaRect(this->size(), compositor->getFrontSourceSize(), zoom, viewCentre);
 }
 
+/* newCompositedFrame
+ * Slot. Called when the compositor has finished a frame. Takes the frame
+ * and schedules a repaint.
+ */
+void Visualiser::newCompositedFrame(void)
+{
+    if(compositor->swapBuffers())
+        update();
+}
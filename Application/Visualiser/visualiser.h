@@ -4,6 +4,7 @@
 #include "../DataModel/datamodel.h"
 #include "visconfig.h"
 #include "../Core/util.h"
+#include "../Core/settings.h"
 #include "vistext.h"
 
 #include <QWidget>
@@ -11,11 +12,13 @@
 #include <QPainter>
 #include <QTimer>
 #include <QMouseEvent>
+#include <QWheelEvent>
 #include <QMutex>
+#include <QHash>
 
 #include <opencv2/opencv.hpp>
 
-#include "Application/Tracking/camerathread.h"
+#include "videocompositor.h"
 
 class Visualiser : public QWidget
 {
@@ -23,15 +26,17 @@ class Visualiser : public QWidget
 public:
     VisConfig config;
 
-    Visualiser(DataModel* dataModelRef, ARCameraThread* cameraThread);
+    Visualiser(DataModel* dataModelRef, VideoCompositor* compositor);
 
     QSize minimumSizeHint () const { return QSize(200, 200); }
 
     void checkFrameSize(void);
 
+    static void renderLatencyOverlay(QPainter& painter);
+
 public slots:
     void refreshVisualisation();
-    void newVideoFrame(cv::Mat& image);
+    void newCompositedFrame(void);
 
 signals:
     void frameSizeChanged(int width, int height);
@@ -42,17 +47,36 @@ protected:
     void resizeEvent(QResizeEvent*);
 
     void mousePressEvent(QMouseEvent*);
+    void mouseMoveEvent(QMouseEvent*);
+    void mouseReleaseEvent(QMouseEvent*);
+    void wheelEvent(QWheelEvent*);
+
+    void setView(double newZoom, QPointF centre);
+    QRectF arenaRect(void);
 
     void renderSingleRobot(RobotData* robot, bool selected, QPainter& painter, double xOffset, double yOffset, double width, double height);
+    VisualiserDetail chooseDetail(size_t robotCount, QRectF arena);
+    void renderPoints(const std::vector<RobotData*>& robots, QPainter& painter, QRectF arena);
+    void renderDensity(const std::vector<RobotData*>& robots, QPainter& painter, QRectF arena, QRectF visible);
     DataModel* dataModelRef;
 
     Vector2D click;
 
-    QImage backgroundImage;
+    // Zoom, and the point of the arena at the centre of the widget
+    double zoom;
+    QPointF viewCentre;
+    bool panning;
+    QPoint lastMousePos;
 
-    ARCameraThread* cameraThread;
+    VideoCompositor* compositor;
 
     VisText* textVis;
+
+    // Kept between paints so that drawing a dense swarm allocates nothing
+    std::vector<RobotData*> visibleRobots;
+    QHash<QRgb, std::vector<QPointF>> pointBatches;
+    std::vector<int> densityCounts;
+    QImage densityImage;
 };
 
 #endif // VISUALISER_H
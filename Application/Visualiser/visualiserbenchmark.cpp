@@ -0,0 +1,224 @@
+/* visualiserbenchmark.cpp
+ *
+ * Measures the frame time of the visualisers, and of the robot glyphs alone,
+ * with a large simulated fleet.
+ */
+
+#include "visualiserbenchmark.h"
+#include "visualiser.h"
+#include "glvisualiser.h"
+#include "visposition.h"
+#include "videocompositor.h"
+#include "../Tracking/camerarig.h"
+#include "../Tracking/markertable.h"
+#include "../DataModel/datamodel.h"
+#include "../Core/latencymonitor.h"
+#include "../Core/benchmarkstats.h"
+
+#include <QApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QSurfaceFormat>
+#include <QPainter>
+#include <QImage>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Size of the window the visualisers draw into
+static const int BENCHMARK_WIDTH = 1280;
+static const int BENCHMARK_HEIGHT = 720;
+
+// Frame time a 60 Hz display allows
+static const double TARGET_FRAME_TIME = 1000.0 / 60;
+
+// Largest step of the random walk, as a fraction of the arena
+static const double MAX_STEP = 0.002;
+
+/* moveFleet
+ * Move every robot one step of a random walk and apply the poses to the
+ * data model as one tracking frame.
+ */
+static void moveFleet(DataModel* model, std::vector<TrackResult>& fleet, std::mt19937& random, quint64 frameId) {
+    std::uniform_real_distribution<double> step(-MAX_STEP, MAX_STEP);
+    std::uniform_real_distribution<double> turn(-5, 5);
+
+    for (auto& robot : fleet) {
+        robot.pose.position.x = std::min(1.0, std::max(0.0, robot.pose.position.x + step(random)));
+        robot.pose.position.y = std::min(1.0, std::max(0.0, robot.pose.position.y + step(random)));
+        robot.pose.orientation = robot.pose.orientation + turn(random);
+    }
+
+    FrameResult frame;
+    frame.camera = 0;
+    frame.frameId = frameId;
+    frame.captureTime = QDateTime::currentMSecsSinceEpoch();
+    frame.captureTick = LatencyMonitor::now();
+    frame.detectedTick = frame.captureTick;
+    frame.arenaSize = Vector2D{1, 1};
+    frame.results = fleet;
+    model->newTrackingFrame(frame);
+}
+
+/* timeVisualiser
+ * Show a visualiser, repaint it once per frame while the fleet moves, and
+ * print the mean and 95th percentile frame times. Returns the 95th
+ * percentile in milliseconds.
+ */
+static double timeVisualiser(const char* name, QWidget* visualiser, DataModel* model,
+                           std::vector<TrackResult>& fleet, int frames) {
+    std::mt19937 random{1};
+    std::vector<double> frameTimes;
+    QElapsedTimer timer;
+
+    visualiser->resize(BENCHMARK_WIDTH, BENCHMARK_HEIGHT);
+    visualiser->show();
+    QApplication::processEvents();
+
+    for (int frame = 0; frame < frames; frame++) {
+        moveFleet(model, fleet, random, frame);
+
+        timer.start();
+        visualiser->repaint();
+        QApplication::processEvents();
+        frameTimes.push_back(timer.nsecsElapsed() / 1e6);
+    }
+
+    visualiser->hide();
+
+    BenchmarkStats stats = getBenchmarkStats(frameTimes);
+    printFrameTimes(name, stats);
+    return stats.p95;
+}
+
+/* runVisualiserBenchmark
+ * Draw a fleet of robots on a random walk with both visualisers. There are
+ * no cameras, so only the robots are drawn. Returns zero if the OpenGL
+ * visualiser kept up with a 60 Hz display.
+ */
+int runVisualiserBenchmark(int robots, int frames) {
+    robots = std::max(1, robots);
+    frames = std::max(1, frames);
+
+    MarkerTable markerTable;
+    CameraRig cameraRig{&markerTable, {}};
+    VideoCompositor compositor{&cameraRig, false, QSize{BENCHMARK_WIDTH, BENCHMARK_HEIGHT}};
+    DataModel model;
+
+    std::mt19937 random{1};
+    std::uniform_real_distribution<double> place(0, 1);
+    std::uniform_real_distribution<double> angle(0, 360);
+    std::vector<TrackResult> fleet(robots);
+
+    for (int i = 0; i < robots; i++) {
+        fleet[i].id = "robot_" + QString::number(i);
+        fleet[i].pose.position.x = place(random);
+        fleet[i].pose.position.y = place(random);
+        fleet[i].pose.orientation = angle(random);
+        fleet[i].quality = 1;
+    }
+
+    printf("Visualiser benchmark: %d robots at %dx%d, %d frames\n", robots, BENCHMARK_WIDTH, BENCHMARK_HEIGHT, frames);
+    printf("%-12s %10s %10s %10s\n", "visualiser", "mean ms", "p95 ms", "fps");
+
+    Visualiser painterVisualiser{&model, &compositor};
+    timeVisualiser("QPainter", &painterVisualiser, &model, fleet, frames);
+
+    // Without vsync the frame time is the drawing time, not the display rate
+    GLVisualiser glVisualiser{&model, &compositor};
+    QSurfaceFormat format = glVisualiser.format();
+    format.setSwapInterval(0);
+    glVisualiser.setFormat(format);
+
+    double p95 = timeVisualiser("OpenGL", &glVisualiser, &model, fleet, frames);
+
+    if (p95 > TARGET_FRAME_TIME) {
+        printf("The OpenGL visualiser is slower than 60 fps\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/* timeGlyphs
+ * Draw every robot with VisPosition into an image once per frame, turning
+ * the robots a little each frame, and print the mean and 95th percentile
+ * frame times. Returns the mean in milliseconds.
+ */
+static double timeGlyphs(const char* name, VisPosition& position, std::vector<RobotData*>& fleet, int frames) {
+    QImage image{BENCHMARK_WIDTH, BENCHMARK_HEIGHT, QImage::Format_ARGB32_Premultiplied};
+    QRectF rect{0, 0, (double)BENCHMARK_WIDTH, (double)BENCHMARK_HEIGHT};
+    std::vector<double> frameTimes;
+    QElapsedTimer timer;
+
+    for (int frame = 0; frame < frames; frame++) {
+        for (auto robot : fleet) {
+            robot->setAngle(robot->getAngle() + 3);
+        }
+
+        image.fill(QColor{200, 200, 200});
+
+        timer.start();
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::HighQualityAntialiasing);
+        QPen pen{QColor{255, 255, 255}};
+        pen.setWidth(3);
+        painter.setPen(pen);
+
+        for (size_t i = 0; i < fleet.size(); i++) {
+            position.render(nullptr, &painter, fleet[i], i == 0, rect);
+        }
+
+        painter.end();
+        frameTimes.push_back(timer.nsecsElapsed() / 1e6);
+    }
+
+    BenchmarkStats stats = getBenchmarkStats(frameTimes);
+    printFrameTimes(name, stats);
+    return stats.mean;
+}
+
+/* runSpriteBenchmark
+ * Draw a fleet of robot glyphs with and without the VisPosition sprite
+ * cache. The first frame of the cached run includes drawing the sprites.
+ * Returns zero if the cache was faster.
+ */
+int runSpriteBenchmark(int robots, int frames) {
+    robots = std::max(1, robots);
+    frames = std::max(1, frames);
+
+    static const QColor palette[] = {Qt::red, Qt::green, Qt::blue, Qt::cyan, Qt::magenta, Qt::yellow, Qt::white, Qt::darkRed};
+
+    std::mt19937 random{1};
+    std::uniform_real_distribution<double> place(0, 1);
+    std::uniform_real_distribution<double> angle(0, 360);
+    std::vector<RobotData*> fleet;
+
+    for (int i = 0; i < robots; i++) {
+        RobotData* robot = new RobotData{"robot_" + QString::number(i)};
+        robot->setPos(place(random), place(random));
+        robot->setAngle(angle(random));
+        robot->colour = palette[i % 8];
+        fleet.push_back(robot);
+    }
+
+    printf("Robot glyph benchmark: %d robots at %dx%d, %d frames\n", robots, BENCHMARK_WIDTH, BENCHMARK_HEIGHT, frames);
+    printf("%-12s %10s %10s %10s\n", "glyphs", "mean ms", "p95 ms", "fps");
+
+    VisPosition position;
+    position.setSpriteCacheEnabled(false);
+    double drawn = timeGlyphs("drawn", position, fleet, frames);
+
+    position.setSpriteCacheEnabled(true);
+    double cached = timeGlyphs("sprites", position, fleet, frames);
+
+    printf("Sprite cache speedup: %.1fx\n", drawn / cached);
+
+    for (auto robot : fleet) {
+        delete robot;
+    }
+
+    return cached < drawn ? 0 : 1;
+}
@@ -0,0 +1,7 @@
+#ifndef VISUALISERBENCHMARK_H
+#define VISUALISERBENCHMARK_H
+
+int runVisualiserBenchmark(int robots, int frames);
+int runSpriteBenchmark(int robots, int frames);
+
+#endif // VISUALISERBENCHMARK_H
@@ -40,6 +40,37 @@ class Robot:
             
         return json.dumps(values)
 
+class SpatialGrid:
+    """Robots binned by position into square cells, so that robots near a
+    point are found by checking the surrounding cells instead of every robot."""
+
+    def __init__(self, cell_size):
+        self.cell_size = cell_size
+        self.cells = {}
+        self.robot_cells = {}
+
+    def cell_of(self, x, y):
+        return (int(math.floor(x / self.cell_size)), int(math.floor(y / self.cell_size)))
+
+    def update(self, robot):
+        cell = self.cell_of(robot.pose['x'], robot.pose['y'])
+        old = self.robot_cells.get(robot.id)
+        if old == cell:
+            return
+        if old is not None:
+            self.cells[old].remove(robot)
+        self.cells.setdefault(cell, []).append(robot)
+        self.robot_cells[robot.id] = cell
+
+    def within(self, x, y, radius):
+        cx, cy = self.cell_of(x, y)
+        reach = int(math.ceil(radius / self.cell_size))
+        for i in range(cx - reach, cx + reach + 1):
+            for j in range(cy - reach, cy + reach + 1):
+                for r in self.cells.get((i, j), ()):
+                    if math.hypot(r.pose['x'] - x, r.pose['y'] - y) < radius:
+                        yield r
+
 hostName = ''
 hostPort = 8888
 
@@ -51,6 +82,11 @@ if __name__=="__main__":
             
     robots = [Robot('robot_%d' % (i,), reportPose) for i in range(8)]
 
+    avoidance_radius = 0.1
+    grid = SpatialGrid(avoidance_radius)
+    for r in robots:
+        grid.update(r)
+
     s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
     s.connect((hostName, hostPort))
 
@@ -70,7 +106,6 @@ if __name__=="__main__":
 
                 v = 0.01
                 a = 10
-                avoidance_radius = 0.1
 
                 dx = v * math.cos(math.radians(r.pose['orientation']))
                 dy = v * math.sin(math.radians(r.pose['orientation']))
@@ -81,19 +116,19 @@ if __name__=="__main__":
 
                     if(r.time_since_last_turn > 0.5):
 
-                        for s in robots:
-                            if s.id != r.id:
-                                if math.sqrt(math.pow(s.pose['x'] - r.pose['x'], 2) + math.pow(s.pose['y'] - r.pose['y'], 2)) < avoidance_radius:
-                                    r.desired_heading = r.pose['orientation'] + 180
-                                    r.state = "AVOIDING"
-                                    break
+                        for other in grid.within(r.pose['x'], r.pose['y'], avoidance_radius):
+                            if other.id != r.id:
+                                r.desired_heading = r.pose['orientation'] + 180
+                                r.state = "AVOIDING"
+                                break
                     
                         if (r.pose['x'] + dx > 0.95) or (r.pose['x'] + dx < 0.05) or (r.pose['y'] + dy > 0.95) or (r.pose['y'] + dy < 0.05):
                             r.desired_heading = r.pose['orientation'] + 180
                             r.state = "TURNING"
 
                     r.pose['x'] = r.pose['x'] + dx
-                    r.pose['y'] = r.pose['y'] + dy    
+                    r.pose['y'] = r.pose['y'] + dy
+                    grid.update(r)
 
                 elif r.state == "TURNING" or r.state == "AVOIDING":
                     if r.desired_heading > 360: